@@ -0,0 +1,310 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+// one leg of the camera path: a key held for some seconds while the mouse turns the view
+struct CameraLeg
+{
+    float seconds;
+    Camera_Movement movement;
+    float yawPerSecond;         // degrees
+    float pitchPerSecond;
+};
+
+// out toward the earth, around it, back up and home again. the legs cancel out, so the
+// path can loop for any frame count and still stays near the scene
+static const CameraLeg BENCHMARK_PATH[] = {
+    { 2.0f, FORWARD,   10.0f,   0.0f },
+    { 2.0f, LEFT,      20.0f,  -5.0f },
+    { 2.0f, DOWN,       0.0f,  -5.0f },
+    { 2.0f, BACKWARD, -10.0f,   5.0f },
+    { 2.0f, RIGHT,    -20.0f,   5.0f },
+    { 2.0f, UP,         0.0f,   0.0f },
+};
+static const std::size_t BENCHMARK_PATH_LEGS = sizeof(BENCHMARK_PATH) / sizeof(BENCHMARK_PATH[0]);
+
+double BenchmarkPathSeconds()
+{
+    double seconds = 0.0;
+    for (std::size_t i = 0; i < BENCHMARK_PATH_LEGS; i++)
+        seconds += BENCHMARK_PATH[i].seconds;
+    return seconds;
+}
+
+void FlyBenchmarkPath(Camera& camera, double time, float deltaTime)
+{
+    double t = fmod(time, BenchmarkPathSeconds());
+    std::size_t leg = 0;
+    while (leg + 1 < BENCHMARK_PATH_LEGS && t >= BENCHMARK_PATH[leg].seconds)
+        t -= BENCHMARK_PATH[leg++].seconds;
+
+    camera.ProcessKeyboard(BENCHMARK_PATH[leg].movement, deltaTime);
+    // ProcessMouseMovement scales its offsets by the sensitivity, undo that to turn in degrees
+    float sensitivity = camera.MouseSensitivity > 0.0f ? camera.MouseSensitivity : 1.0f;
+    camera.ProcessMouseMovement(BENCHMARK_PATH[leg].yawPerSecond * deltaTime / sensitivity,
+        BENCHMARK_PATH[leg].pitchPerSecond * deltaTime / sensitivity);
+}
+
+static double WallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+// function to get the cpu time of the calling thread, the driver's own threads (llvmpipe
+// rasterizes on several) are not part of it
+static double ThreadCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exited, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user);
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static double PeakRssMB()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0.0;
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+static FrameTimeStats ComputeStats(std::vector<double> samples)
+{
+    FrameTimeStats stats = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (samples.empty())
+        return stats;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (std::size_t i = 0; i < samples.size(); i++)
+        sum += samples[i];
+    // nearest rank percentiles
+    std::size_t n = samples.size();
+    stats.mean = sum / n;
+    stats.p50 = samples[(std::size_t)std::ceil(0.50 * n) - 1];
+    stats.p95 = samples[(std::size_t)std::ceil(0.95 * n) - 1];
+    stats.p99 = samples[(std::size_t)std::ceil(0.99 * n) - 1];
+    stats.max = samples[n - 1];
+    return stats;
+}
+
+FrameBenchmark::FrameBenchmark() : frameIndex(0), width(0), height(0), frameStart(0.0), cpuStart(0.0)
+{
+    for (unsigned int i = 0; i < BENCHMARK_QUERY_RING; i++)
+    {
+        queries[i][0] = queries[i][1] = 0;
+        pending[i] = false;
+    }
+}
+
+void FrameBenchmark::begin(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    frameIndex = 0;
+    frameTimes.clear();
+    cpuTimes.clear();
+    gpuTimes.clear();
+    for (unsigned int i = 0; i < BENCHMARK_QUERY_RING; i++)
+    {
+        if (queries[i][0] == 0)
+            glGenQueries(2, queries[i]);
+        pending[i] = false;
+    }
+}
+
+void FrameBenchmark::beginFrame()
+{
+    double now = WallSeconds();
+    if (frameIndex > BENCHMARK_WARMUP_FRAMES)
+        frameTimes.push_back((now - frameStart) * 1000.0);
+    frameStart = now;
+    cpuStart = ThreadCpuSeconds();
+
+    unsigned int slot = frameIndex % BENCHMARK_QUERY_RING;
+    if (pending[slot])
+        collect(slot);
+    glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+}
+
+void FrameBenchmark::endFrame()
+{
+    unsigned int slot = frameIndex % BENCHMARK_QUERY_RING;
+    glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+    if (frameIndex >= BENCHMARK_WARMUP_FRAMES)
+    {
+        cpuTimes.push_back((ThreadCpuSeconds() - cpuStart) * 1000.0);
+        pending[slot] = true;
+    }
+    frameIndex++;
+}
+// function to read a frame's timestamps, BENCHMARK_QUERY_RING frames after they were issued
+// they are all but always available and waiting for them keeps the run deterministic
+void FrameBenchmark::collect(unsigned int slot)
+{
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+    gpuTimes.push_back(end > start ? (end - start) / 1e6 : 0.0);
+    pending[slot] = false;
+}
+
+BenchmarkResult FrameBenchmark::finish()
+{
+    glFinish();
+    if (frameIndex > BENCHMARK_WARMUP_FRAMES)
+        frameTimes.push_back((WallSeconds() - frameStart) * 1000.0);
+    for (unsigned int i = 0; i < BENCHMARK_QUERY_RING; i++)
+    {
+        // oldest first, so the gpu times stay in frame order
+        unsigned int slot = (frameIndex + i) % BENCHMARK_QUERY_RING;
+        if (pending[slot])
+            collect(slot);
+    }
+
+    BenchmarkResult result;
+    result.frames = (unsigned int)frameTimes.size();
+    result.width = width;
+    result.height = height;
+    result.frame = ComputeStats(frameTimes);
+    result.cpu = ComputeStats(cpuTimes);
+    result.gpu = ComputeStats(gpuTimes);
+    result.peakRssMB = PeakRssMB();
+    return result;
+}
+
+void FrameBenchmark::release()
+{
+    for (unsigned int i = 0; i < BENCHMARK_QUERY_RING; i++)
+    {
+        if (queries[i][0] != 0)
+            glDeleteQueries(2, queries[i]);
+        queries[i][0] = queries[i][1] = 0;
+        pending[i] = false;
+    }
+}
+
+static void WriteStats(FILE* file, const char* name, const FrameTimeStats& stats)
+{
+    fprintf(file, "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+        name, stats.mean, stats.p50, stats.p95, stats.p99, stats.max);
+}
+
+void WriteBenchmarkResult(FILE* file, const BenchmarkResult& result)
+{
+    fprintf(file, "{\n  \"frames\": %u,\n  \"width\": %d,\n  \"height\": %d,\n", result.frames, result.width, result.height);
+    WriteStats(file, "frame_ms", result.frame);
+    WriteStats(file, "cpu_ms", result.cpu);
+    WriteStats(file, "gpu_ms", result.gpu);
+    fprintf(file, "  \"peak_rss_mb\": %.2f\n}\n", result.peakRssMB);
+    fflush(file);
+}
+// function to find "key": number in a result file, inside the object named section if
+// section is not empty. only reads what WriteBenchmarkResult writes
+static bool ReadResultNumber(const std::string& text, const char* section, const char* key, double& value)
+{
+    std::size_t from = 0;
+    if (section[0] != 0)
+    {
+        from = text.find(std::string("\"") + section + "\"");
+        if (from == std::string::npos)
+            return false;
+    }
+    std::size_t at = text.find(std::string("\"") + key + "\"", from);
+    if (at == std::string::npos)
+        return false;
+    at = text.find(':', at);
+    if (at == std::string::npos)
+        return false;
+    value = strtod(text.c_str() + at + 1, NULL);
+    return true;
+}
+
+bool CompareBenchmarkBaseline(const std::string& path, const BenchmarkResult& result, double tolerance)
+{
+    std::ifstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "Failed to read benchmark baseline " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    double frames = 0, width = 0, height = 0;
+    ReadResultNumber(text, "", "frames", frames);
+    ReadResultNumber(text, "", "width", width);
+    ReadResultNumber(text, "", "height", height);
+    if ((unsigned int)frames != result.frames || (int)width != result.width || (int)height != result.height)
+        std::cout << "Warning: the baseline ran " << frames << " frames at " << width << "x" << height
+                  << ", this run " << result.frames << " at " << result.width << "x" << result.height << std::endl;
+
+    struct Metric
+    {
+        const char* section;
+        const char* key;
+        double current;
+        bool gate;          // false for metrics that are only reported
+    };
+    const Metric metrics[] = {
+        { "frame_ms", "p50", result.frame.p50, true },
+        { "frame_ms", "p95", result.frame.p95, true },
+        { "frame_ms", "p99", result.frame.p99, true },
+        { "cpu_ms", "p50", result.cpu.p50, false },
+        { "cpu_ms", "p95", result.cpu.p95, false },
+        { "gpu_ms", "p50", result.gpu.p50, true },
+        { "gpu_ms", "p95", result.gpu.p95, true },
+        { "", "peak_rss_mb", result.peakRssMB, true },
+    };
+
+    bool passed = true;
+    for (std::size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++)
+    {
+        double baseline = 0.0;
+        if (!ReadResultNumber(text, metrics[i].section, metrics[i].key, baseline))
+            continue;
+        double change = baseline > 0.0 ? (metrics[i].current - baseline) / baseline : 0.0;
+        bool regressed = metrics[i].gate && baseline > 0.0 && change > tolerance;
+        char line[160];
+        snprintf(line, sizeof(line), "%-8s %-12s %10.3f -> %10.3f  %+6.1f%%%s", metrics[i].section[0] ? metrics[i].section : "memory",
+            metrics[i].key, baseline, metrics[i].current, change * 100.0, regressed ? "  REGRESSION" : "");
+        std::cout << line << std::endl;
+        if (regressed)
+            passed = false;
+    }
+    std::cout << (passed ? "Benchmark within " : "Benchmark regressed beyond ") << tolerance * 100.0 << "% of " << path << std::endl;
+    return passed;
+}
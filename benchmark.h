@@ -0,0 +1,82 @@
+#pragma once
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "camera.h"
+
+// frames rendered before the measurement starts (shader compiles, first uploads, caches)
+const unsigned int BENCHMARK_WARMUP_FRAMES = 10;
+// timestamp query pairs in flight, frame n is read back when frame n + 4 starts
+const unsigned int BENCHMARK_QUERY_RING = 4;
+
+// function to fly the camera along the benchmark path through the Camera API, the same
+// way the keyboard and mouse do. called once per frame with the fixed timestep, the path
+// repeats after BenchmarkPathSeconds()
+void FlyBenchmarkPath(Camera& camera, double time, float deltaTime);
+double BenchmarkPathSeconds();
+
+// percentiles of one per frame measurement in ms
+struct FrameTimeStats
+{
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+struct BenchmarkResult
+{
+    unsigned int frames;
+    int width, height;
+    FrameTimeStats frame;       // wall time from one frame start to the next
+    FrameTimeStats cpu;         // cpu time of the render thread in the frame
+    FrameTimeStats gpu;         // GL_TIMESTAMP difference around the frame's commands
+    double peakRssMB;
+};
+
+// times the frames of a scripted run. beginFrame/endFrame bracket every frame, the
+// gpu time comes from timestamp queries that are read back BENCHMARK_QUERY_RING frames
+// later (timestamps, not GL_TIME_ELAPSED, so the profiler's pass queries can run inside)
+class FrameBenchmark
+{
+public:
+    FrameBenchmark();
+
+    void begin(int width, int height);
+    void beginFrame();
+    void endFrame();
+    // function to wait for the last queries and compute the statistics
+    BenchmarkResult finish();
+    void release();
+
+private:
+    FrameBenchmark(const FrameBenchmark&);
+    FrameBenchmark& operator=(const FrameBenchmark&);
+
+    void collect(unsigned int slot);
+
+    GLuint queries[BENCHMARK_QUERY_RING][2];
+    bool pending[BENCHMARK_QUERY_RING];
+    unsigned int frameIndex;
+    int width, height;
+    double frameStart;
+    double cpuStart;
+    std::vector<double> frameTimes;
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+};
+
+// function to write a result as JSON, the format --benchmark-baseline reads back
+void WriteBenchmarkResult(FILE* file, const BenchmarkResult& result);
+// function to compare a result with a stored one. prints every metric with its change and
+// returns false when a frame time percentile, the gpu time or the peak RSS got worse by
+// more than tolerance (0.1 is 10%)
+bool CompareBenchmarkBaseline(const std::string& path, const BenchmarkResult& result, double tolerance);
+
+#endif
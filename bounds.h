@@ -0,0 +1,131 @@
+#pragma once
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstddef>
+
+// axis aligned box and bounding sphere of a mesh, in the space its vertices are in
+struct Aabb
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center;
+    float radius;
+};
+
+struct Bounds
+{
+    Aabb box;
+    BoundingSphere sphere;
+};
+
+// function to compute the bounds of interleaved vertices whose first three floats are
+// the position. the sphere is centered on the box and reaches the farthest vertex
+inline Bounds ComputeBounds(const float* vertices, std::size_t vertexCount, std::size_t floatsPerVertex)
+{
+    Bounds bounds;
+    bounds.box.min = bounds.box.max = glm::vec3(0.0f);
+    bounds.sphere.center = glm::vec3(0.0f);
+    bounds.sphere.radius = 0.0f;
+    if (vertexCount == 0)
+        return bounds;
+
+    glm::vec3 low(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 high = low;
+    for (std::size_t i = 1; i < vertexCount; i++)
+    {
+        const float* p = vertices + i * floatsPerVertex;
+        for (int k = 0; k < 3; k++)
+        {
+            low[k] = p[k] < low[k] ? p[k] : low[k];
+            high[k] = p[k] > high[k] ? p[k] : high[k];
+        }
+    }
+    bounds.box.min = low;
+    bounds.box.max = high;
+
+    glm::vec3 center((low.x + high.x) * 0.5f, (low.y + high.y) * 0.5f, (low.z + high.z) * 0.5f);
+    float radius2 = 0.0f;
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        const float* p = vertices + i * floatsPerVertex;
+        float dx = p[0] - center.x, dy = p[1] - center.y, dz = p[2] - center.z;
+        float d2 = dx * dx + dy * dy + dz * dz;
+        radius2 = d2 > radius2 ? d2 : radius2;
+    }
+    bounds.sphere.center = center;
+    bounds.sphere.radius = std::sqrt(radius2);
+    return bounds;
+}
+
+// function to get the largest scale of a model matrix's axes. the scene also uses
+// matrices scaled as a whole (w included), so everything is divided by w
+inline float MaxScale(const glm::mat4& m)
+{
+    float largest = 0.0f;
+    for (int c = 0; c < 3; c++)
+    {
+        float l2 = m[c][0] * m[c][0] + m[c][1] * m[c][1] + m[c][2] * m[c][2];
+        largest = l2 > largest ? l2 : largest;
+    }
+    return std::sqrt(largest) / std::fabs(m[3][3]);
+}
+
+inline glm::vec3 TransformPoint(const glm::mat4& m, const glm::vec3& p)
+{
+    float w = m[3][3];
+    return glm::vec3((m[0][0] * p.x + m[1][0] * p.y + m[2][0] * p.z + m[3][0]) / w,
+                     (m[0][1] * p.x + m[1][1] * p.y + m[2][1] * p.z + m[3][1]) / w,
+                     (m[0][2] * p.x + m[1][2] * p.y + m[2][2] * p.z + m[3][2]) / w);
+}
+
+inline BoundingSphere TransformSphere(const BoundingSphere& sphere, const glm::mat4& m)
+{
+    BoundingSphere result;
+    result.center = TransformPoint(m, sphere.center);
+    result.radius = sphere.radius * MaxScale(m);
+    return result;
+}
+// function to get the box around a transformed box: the center moves with the matrix and
+// each half extent is the sum of the absolute matrix entries times the old half extents
+inline Aabb TransformAabb(const Aabb& box, const glm::mat4& m)
+{
+    glm::vec3 center((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f);
+    glm::vec3 half((box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f);
+    glm::vec3 newCenter = TransformPoint(m, center);
+    float w = std::fabs(m[3][3]);
+    glm::vec3 newHalf;
+    for (int r = 0; r < 3; r++)
+        newHalf[r] = (std::fabs(m[0][r]) * half.x + std::fabs(m[1][r]) * half.y + std::fabs(m[2][r]) * half.z) / w;
+    Aabb result;
+    result.min = glm::vec3(newCenter.x - newHalf.x, newCenter.y - newHalf.y, newCenter.z - newHalf.z);
+    result.max = glm::vec3(newCenter.x + newHalf.x, newCenter.y + newHalf.y, newCenter.z + newHalf.z);
+    return result;
+}
+// function to get a sphere around two spheres, an empty (radius 0) sphere is ignored
+inline BoundingSphere MergeSpheres(const BoundingSphere& a, const BoundingSphere& b)
+{
+    if (a.radius <= 0.0f)
+        return b;
+    if (b.radius <= 0.0f)
+        return a;
+    float dx = b.center.x - a.center.x, dy = b.center.y - a.center.y, dz = b.center.z - a.center.z;
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (distance + b.radius <= a.radius)
+        return a;
+    if (distance + a.radius <= b.radius)
+        return b;
+    BoundingSphere result;
+    result.radius = (distance + a.radius + b.radius) * 0.5f;
+    float t = (result.radius - a.radius) / distance;
+    result.center = glm::vec3(a.center.x + dx * t, a.center.y + dy * t, a.center.z + dz * t);
+    return result;
+}
+
+#endif
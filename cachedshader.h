@@ -0,0 +1,125 @@
+#pragma once
+#ifndef CACHEDSHADER_H
+#define CACHEDSHADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstring>
+#include "shader.h"
+#include "renderstats.h"
+
+// FNV-1a hash of a uniform name, usable in constant expressions
+constexpr unsigned int hashUniformName(const char* name, unsigned int hash = 2166136261u)
+{
+    return *name == 0 ? hash : hashUniformName(name + 1, (hash ^ (unsigned char)*name) * 16777619u);
+}
+
+// a uniform name with its hash. built from a string literal, so the hash of
+// setMat4("model", ...) is folded by the compiler instead of computed per call.
+// the name is only borrowed for the call, the cache keeps a copy of its own
+struct UniformName
+{
+    const char* name;
+    unsigned int hash;
+
+    template <std::size_t N>
+    constexpr UniformName(const char (&name)[N]) : name(name), hash(hashUniformName(name))
+    {
+    }
+};
+
+// Shader with a per program cache of uniform locations. the first set of a
+// name asks GL for the location, every later set is a table lookup with no
+// string building, no allocation and no glGetUniformLocation
+class CachedShader : public Shader
+{
+public:
+    CachedShader(const char* vertexPath, const char* fragmentPath) : Shader(vertexPath, fragmentPath)
+    {
+        memset(entries, 0, sizeof(entries));
+    }
+
+    // Shader::use through the render stats, so switches and redundant binds are counted
+    void use() const
+    {
+        countedUseProgram(ID);
+    }
+
+    GLint location(const UniformName& uniform) const
+    {
+        unsigned int slot = uniform.hash & (CACHE_SIZE - 1);
+        for (unsigned int probe = 0; probe < CACHE_SIZE; probe++)
+        {
+            Entry& entry = entries[(slot + probe) & (CACHE_SIZE - 1)];
+            if (entry.name[0] == 0)
+            {
+                // first use of this name, ask GL once and remember it. names too long
+                // for an entry are looked up every time
+                std::size_t length = strlen(uniform.name);
+                if (length >= MAX_NAME_LENGTH)
+                    break;
+                memcpy(entry.name, uniform.name, length + 1);
+                entry.hash = uniform.hash;
+                entry.location = glGetUniformLocation(ID, uniform.name);
+                return entry.location;
+            }
+            if (entry.hash == uniform.hash && strcmp(entry.name, uniform.name) == 0)
+                return entry.location;
+        }
+        // more names than the cache holds, or a long one, look it up every time
+        return glGetUniformLocation(ID, uniform.name);
+    }
+
+    void setBool(const UniformName& name, bool value) const
+    {
+        countedUniform1i(location(name), (int)value);
+    }
+    void setInt(const UniformName& name, int value) const
+    {
+        countedUniform1i(location(name), value);
+    }
+    void setFloat(const UniformName& name, float value) const
+    {
+        countedUniform1f(location(name), value);
+    }
+    void setVec2(const UniformName& name, const glm::vec2& value) const
+    {
+        countedUniform2fv(location(name), 1, &value[0]);
+    }
+    void setVec3(const UniformName& name, const glm::vec3& value) const
+    {
+        countedUniform3fv(location(name), 1, &value[0]);
+    }
+    void setVec3(const UniformName& name, float x, float y, float z) const
+    {
+        countedUniform3f(location(name), x, y, z);
+    }
+    void setVec4(const UniformName& name, const glm::vec4& value) const
+    {
+        countedUniform4fv(location(name), 1, &value[0]);
+    }
+    void setMat3(const UniformName& name, const glm::mat3& mat) const
+    {
+        countedUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(const UniformName& name, const glm::mat4& mat) const
+    {
+        countedUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+private:
+    static const unsigned int CACHE_SIZE = 64;
+    static const std::size_t MAX_NAME_LENGTH = 48;
+
+    struct Entry
+    {
+        char name[MAX_NAME_LENGTH];     // empty in a free entry
+        unsigned int hash;
+        GLint location;
+    };
+
+    mutable Entry entries[CACHE_SIZE];
+};
+
+#endif
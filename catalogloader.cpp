@@ -0,0 +1,525 @@
+#include "catalogloader.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// chunks smaller than this are not worth a thread
+const std::size_t CATALOG_MIN_CHUNK_BYTES = 256 * 1024;
+
+/* LINES */
+
+// one line of the mapping without its line break, not null terminated
+struct LineView
+{
+    const char* text;
+    std::size_t length;
+};
+
+// function to cut the line starting at position, returns where the next one starts
+static std::size_t nextLine(const char* data, std::size_t end, std::size_t position, LineView& line)
+{
+    const char* start = data + position;
+    const char* newline = (const char*)memchr(start, '\n', end - position);
+    std::size_t next = newline != NULL ? (std::size_t)(newline - data) + 1 : end;
+    line.text = start;
+    line.length = (newline != NULL ? (std::size_t)(newline - start) : end - position);
+    if (line.length > 0 && start[line.length - 1] == '\r')
+        line.length--;
+    return next;
+}
+
+static bool isBlank(const LineView& line)
+{
+    for (std::size_t i = 0; i < line.length; i++)
+    {
+        if (line.text[i] != ' ' && line.text[i] != '\t')
+            return false;
+    }
+    return true;
+}
+
+static bool startsWith(const LineView& line, char first)
+{
+    return line.length > 1 && line.text[0] == first && line.text[1] == ' ';
+}
+
+// function to find the first line start at or after offset
+static std::size_t alignToLine(const char* data, std::size_t size, std::size_t offset)
+{
+    if (offset == 0 || offset >= size)
+        return std::min(offset, size);
+    if (data[offset - 1] == '\n')
+        return offset;
+    const char* newline = (const char*)memchr(data + offset, '\n', size - offset);
+    return newline != NULL ? (std::size_t)(newline - data) + 1 : size;
+}
+
+// function to find the start of the line that ends right before position, size when
+// position is the start of the file
+static std::size_t lineBefore(const char* data, std::size_t size, std::size_t position)
+{
+    if (position == 0 || position > size)
+        return size;
+    std::size_t start = position - 1;
+    while (start > 0 && data[start - 1] != '\n')
+        start--;
+    return start;
+}
+
+// function to find the first record start at or after offset: a line 1 directly
+// followed by a line 2, or the name line in front of such a pair. the name line may
+// start before offset, offset can fall inside it, so the line before the first line
+// start is looked at too. otherwise the name would be cut off from its record and
+// which names are lost would depend on the number of chunks
+static std::size_t alignToTwoLineRecord(const char* data, std::size_t size, std::size_t offset)
+{
+    std::size_t position = alignToLine(data, size, offset);
+    std::size_t previous = lineBefore(data, size, position);
+    while (position < size)
+    {
+        LineView line, following;
+        std::size_t next = nextLine(data, size, position, line);
+        if (startsWith(line, '1') && next < size)
+        {
+            nextLine(data, size, next, following);
+            if (startsWith(following, '2'))
+            {
+                if (previous != size)
+                {
+                    LineView name;
+                    nextLine(data, size, previous, name);
+                    if (!startsWith(name, '1') && !startsWith(name, '2') && !isBlank(name))
+                        return previous;
+                }
+                return position;
+            }
+        }
+        previous = position;
+        position = next;
+    }
+    return size;
+}
+
+
+
+/* CHUNK PARSERS */
+
+// what one thread produced from its chunk, line numbers are local to the chunk
+struct CatalogChunk
+{
+    std::size_t begin, end;
+    std::size_t lines;
+    std::size_t malformed;
+    std::vector<TwoLineElement> elements;
+    std::vector<CatalogRecordError> errors;
+};
+
+static void reportError(CatalogChunk& chunk, std::size_t line, const char* reason)
+{
+    chunk.malformed++;
+    if (chunk.errors.size() < CATALOG_MAX_REPORTED_ERRORS)
+    {
+        CatalogRecordError error = { line, reason };
+        chunk.errors.push_back(error);
+    }
+}
+
+static void copyName(const char* text, std::size_t length, TwoLineElement& tle)
+{
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t'))
+        length--;
+    // three line files put "0 " in front of the name
+    if (length > 1 && text[0] == '0' && text[1] == ' ')
+    {
+        text += 2;
+        length -= 2;
+    }
+    length = std::min(length, sizeof(tle.name) - 1);
+    if (length > 0)
+        memcpy(tle.name, text, length);
+    tle.name[length] = 0;
+}
+
+static void parseTwoLineChunk(const char* data, CatalogChunk& chunk)
+{
+    LineView name = { NULL, 0 };
+    LineView line1 = { NULL, 0 };
+    std::size_t line1Number = 0;
+    std::size_t position = chunk.begin;
+    chunk.elements.reserve((chunk.end - chunk.begin) / 140 + 1);
+
+    while (position < chunk.end)
+    {
+        LineView line;
+        position = nextLine(data, chunk.end, position, line);
+        chunk.lines++;
+        if (startsWith(line, '1'))
+        {
+            if (line1.text != NULL)
+                reportError(chunk, line1Number, "line 1 is not followed by a line 2");
+            line1 = line;
+            line1Number = chunk.lines;
+        }
+        else if (startsWith(line, '2'))
+        {
+            if (line1.text == NULL)
+            {
+                reportError(chunk, chunk.lines, "line 2 without a line 1");
+                continue;
+            }
+            TwoLineElement tle;
+            copyName(name.text, name.length, tle);
+            if (ParseTwoLineElement(line1.text, line1.length, line.text, line.length, tle))
+                chunk.elements.push_back(tle);
+            else
+                reportError(chunk, line1Number, "bad field, length or checksum");
+            line1.text = NULL;
+            name.length = 0;
+        }
+        else if (!isBlank(line))
+        {
+            if (line1.text != NULL)
+            {
+                reportError(chunk, line1Number, "line 1 is not followed by a line 2");
+                line1.text = NULL;
+            }
+            name = line;
+        }
+    }
+    if (line1.text != NULL)
+        reportError(chunk, line1Number, "line 1 is not followed by a line 2");
+}
+
+// the OMM fields the catalog needs, index of each in the CSV header
+enum OmmField
+{
+    OMM_OBJECT_NAME,
+    OMM_NORAD_CAT_ID,
+    OMM_EPOCH,
+    OMM_MEAN_MOTION,
+    OMM_ECCENTRICITY,
+    OMM_INCLINATION,
+    OMM_RA_OF_ASC_NODE,
+    OMM_ARG_OF_PERICENTER,
+    OMM_MEAN_ANOMALY,
+    OMM_BSTAR,
+    OMM_FIELD_COUNT
+};
+
+static const char* OMM_FIELD_NAMES[OMM_FIELD_COUNT] = { "OBJECT_NAME", "NORAD_CAT_ID", "EPOCH", "MEAN_MOTION",
+    "ECCENTRICITY", "INCLINATION", "RA_OF_ASC_NODE", "ARG_OF_PERICENTER", "MEAN_ANOMALY", "BSTAR" };
+
+struct OmmColumns
+{
+    int column[OMM_FIELD_COUNT];
+    int columnCount;
+};
+
+// function to split a CSV line into at most count fields, quotes around a field are dropped
+static int splitCsv(const LineView& line, LineView* fields, int count)
+{
+    int n = 0;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= line.length && n < count; i++)
+    {
+        if (i == line.length || line.text[i] == ',')
+        {
+            LineView field = { line.text + start, i - start };
+            if (field.length >= 2 && field.text[0] == '"' && field.text[field.length - 1] == '"')
+            {
+                field.text++;
+                field.length -= 2;
+            }
+            fields[n++] = field;
+            start = i + 1;
+        }
+    }
+    return n;
+}
+
+static bool readOmmHeader(const LineView& line, OmmColumns& columns)
+{
+    LineView fields[64];
+    columns.columnCount = splitCsv(line, fields, 64);
+    for (int f = 0; f < OMM_FIELD_COUNT; f++)
+    {
+        columns.column[f] = -1;
+        for (int c = 0; c < columns.columnCount; c++)
+        {
+            if (fields[c].length == strlen(OMM_FIELD_NAMES[f])
+                && memcmp(fields[c].text, OMM_FIELD_NAMES[f], fields[c].length) == 0)
+                columns.column[f] = c;
+        }
+        if (columns.column[f] < 0 && f != OMM_OBJECT_NAME)
+            return false;
+    }
+    return true;
+}
+
+// function to read a number field, copied out because the mapping is not null terminated
+static bool parseNumber(const LineView& field, double& value)
+{
+    char text[64];
+    if (field.length == 0 || field.length >= sizeof(text))
+        return false;
+    memcpy(text, field.text, field.length);
+    text[field.length] = 0;
+    char* end;
+    value = strtod(text, &end);
+    return *end == 0;
+}
+
+// function to read an ISO 8601 epoch like 2024-01-15T12:34:56.123456 as a julian date
+static bool parseIsoEpoch(const LineView& field, double& julianDate)
+{
+    static const int DAYS_BEFORE_MONTH[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    int year, month, day, hour, minute;
+    double second;
+    char text[64];
+    if (field.length < 19 || field.length >= sizeof(text))
+        return false;
+    memcpy(text, field.text, field.length);
+    text[field.length] = 0;
+    if (sscanf(text, "%4d-%2d-%2dT%2d:%2d:%lf", &year, &month, &day, &hour, &minute, &second) != 6
+        || month < 1 || month > 12 || day < 1 || day > 31)
+        return false;
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    double dayOfYear = DAYS_BEFORE_MONTH[month - 1] + (leap && month > 2 ? 1 : 0) + day
+                       + (hour + (minute + second / 60.0) / 60.0) / 24.0;
+    julianDate = JulianDateFromEpoch(year, dayOfYear);
+    return true;
+}
+
+static void parseOmmChunk(const char* data, const OmmColumns& columns, CatalogChunk& chunk)
+{
+    const double DEG = 3.14159265358979323846 / 180.0;
+    LineView fields[64];
+    std::size_t position = chunk.begin;
+    chunk.elements.reserve((chunk.end - chunk.begin) / 200 + 1);
+
+    while (position < chunk.end)
+    {
+        LineView line;
+        position = nextLine(data, chunk.end, position, line);
+        chunk.lines++;
+        if (isBlank(line))
+            continue;
+        if (splitCsv(line, fields, 64) != columns.columnCount)
+        {
+            reportError(chunk, chunk.lines, "wrong number of fields");
+            continue;
+        }
+
+        TwoLineElement tle;
+        double number, inclination, node, eccentricity, perigee, anomaly, motion;
+        if (!parseNumber(fields[columns.column[OMM_NORAD_CAT_ID]], number)
+            || !parseIsoEpoch(fields[columns.column[OMM_EPOCH]], tle.epoch)
+            || !parseNumber(fields[columns.column[OMM_MEAN_MOTION]], motion)
+            || !parseNumber(fields[columns.column[OMM_ECCENTRICITY]], eccentricity)
+            || !parseNumber(fields[columns.column[OMM_INCLINATION]], inclination)
+            || !parseNumber(fields[columns.column[OMM_RA_OF_ASC_NODE]], node)
+            || !parseNumber(fields[columns.column[OMM_ARG_OF_PERICENTER]], perigee)
+            || !parseNumber(fields[columns.column[OMM_MEAN_ANOMALY]], anomaly)
+            || !parseNumber(fields[columns.column[OMM_BSTAR]], tle.bstar))
+        {
+            reportError(chunk, chunk.lines, "bad field");
+            continue;
+        }
+        tle.name[0] = 0;
+        if (columns.column[OMM_OBJECT_NAME] >= 0)
+            copyName(fields[columns.column[OMM_OBJECT_NAME]].text, fields[columns.column[OMM_OBJECT_NAME]].length, tle);
+        tle.catalogNumber = (int)number;
+        tle.inclination = inclination * DEG;
+        tle.rightAscension = node * DEG;
+        tle.eccentricity = eccentricity;
+        tle.argumentOfPerigee = perigee * DEG;
+        tle.meanAnomaly = anomaly * DEG;
+        tle.meanMotion = motion * 2.0 * 3.14159265358979323846 / 1440.0;
+        chunk.elements.push_back(tle);
+    }
+}
+
+
+
+/* LOADER */
+
+bool LoadCatalogFile(const std::string& path, std::vector<TwoLineElement>& elements, CatalogLoadReport& report,
+                     unsigned int threads)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    report.opened = false;
+    report.bytes = 0;
+    report.records = 0;
+    report.malformed = 0;
+    report.chunks = 0;
+    report.seconds = 0.0;
+    report.errors.clear();
+
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    report.opened = true;
+    report.bytes = file.size;
+    const char* data = file.data;
+    std::size_t size = file.size;
+
+    // the first non blank line tells the format, an OMM CSV starts with its header
+    std::size_t body = 0;
+    std::size_t headerLines = 0;
+    LineView first = { NULL, 0 };
+    while (body < size)
+    {
+        body = nextLine(data, size, body, first);
+        headerLines++;
+        if (!isBlank(first))
+            break;
+    }
+    OmmColumns columns;
+    bool omm = first.text != NULL && !startsWith(first, '1') && memchr(first.text, ',', first.length) != NULL;
+    if (omm)
+    {
+        if (!readOmmHeader(first, columns))
+        {
+            CatalogRecordError error = { headerLines, "OMM header lacks a required field" };
+            report.errors.push_back(error);
+            report.malformed = 1;
+            return false;
+        }
+    }
+    else
+    {
+        body = 0;
+        headerLines = 0;
+    }
+
+    // one chunk per thread, boundaries moved forward to the next record
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t chunkCount = std::max<std::size_t>(1, std::min<std::size_t>(threads, (size - body) / CATALOG_MIN_CHUNK_BYTES));
+    std::vector<CatalogChunk> chunks(chunkCount);
+    std::size_t begin = body;
+    for (std::size_t c = 0; c < chunkCount; c++)
+    {
+        std::size_t end = size;
+        if (c + 1 < chunkCount)
+        {
+            std::size_t target = body + (size - body) / chunkCount * (c + 1);
+            end = omm ? alignToLine(data, size, target) : alignToTwoLineRecord(data, size, target);
+            end = std::max(end, begin);
+        }
+        chunks[c].begin = begin;
+        chunks[c].end = end;
+        chunks[c].lines = 0;
+        chunks[c].malformed = 0;
+        begin = end;
+    }
+
+    std::vector<std::thread> workers;
+    for (std::size_t c = 1; c < chunkCount; c++)
+    {
+        if (omm)
+            workers.push_back(std::thread(parseOmmChunk, data, std::cref(columns), std::ref(chunks[c])));
+        else
+            workers.push_back(std::thread(parseTwoLineChunk, data, std::ref(chunks[c])));
+    }
+    if (omm)
+        parseOmmChunk(data, columns, chunks[0]);
+    else
+        parseTwoLineChunk(data, chunks[0]);
+    for (std::size_t w = 0; w < workers.size(); w++)
+        workers[w].join();
+
+    // stitch the chunks in file order, local line numbers become file line numbers
+    std::size_t total = 0;
+    for (std::size_t c = 0; c < chunkCount; c++)
+        total += chunks[c].elements.size();
+    elements.reserve(elements.size() + total);
+    std::size_t lineOffset = headerLines;
+    for (std::size_t c = 0; c < chunkCount; c++)
+    {
+        elements.insert(elements.end(), chunks[c].elements.begin(), chunks[c].elements.end());
+        report.malformed += chunks[c].malformed;
+        for (std::size_t e = 0; e < chunks[c].errors.size() && report.errors.size() < CATALOG_MAX_REPORTED_ERRORS; e++)
+        {
+            CatalogRecordError error = chunks[c].errors[e];
+            error.line += lineOffset;
+            report.errors.push_back(error);
+        }
+        lineOffset += chunks[c].lines;
+    }
+    report.records = total;
+    report.chunks = (unsigned int)chunkCount;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void PrintCatalogLoadReport(const std::string& path, const CatalogLoadReport& report)
+{
+    if (!report.opened)
+    {
+        std::cout << "Failed to open catalog " << path << std::endl;
+        return;
+    }
+    std::cout << "Loaded " << report.records << " records from " << path << " (" << report.bytes / 1024 << " KB, "
+              << report.chunks << " chunks) in " << report.seconds * 1000.0 << " ms" << std::endl;
+    for (std::size_t e = 0; e < report.errors.size(); e++)
+        std::cout << "  line " << report.errors[e].line << ": " << report.errors[e].reason << std::endl;
+    if (report.malformed > report.errors.size())
+        std::cout << "  ... " << report.malformed - report.errors.size() << " more malformed records" << std::endl;
+}
+
+// function to tell if two loads read the same element sets, field by field
+static bool sameElements(const std::vector<TwoLineElement>& a, const std::vector<TwoLineElement>& b, std::size_t& index)
+{
+    for (index = 0; index < a.size() && index < b.size(); index++)
+    {
+        const TwoLineElement& x = a[index];
+        const TwoLineElement& y = b[index];
+        if (strcmp(x.name, y.name) != 0 || x.catalogNumber != y.catalogNumber || x.epoch != y.epoch ||
+            x.bstar != y.bstar || x.inclination != y.inclination || x.rightAscension != y.rightAscension ||
+            x.eccentricity != y.eccentricity || x.argumentOfPerigee != y.argumentOfPerigee ||
+            x.meanAnomaly != y.meanAnomaly || x.meanMotion != y.meanMotion)
+            return false;
+    }
+    return a.size() == b.size();
+}
+
+bool CheckCatalogChunking(const std::string& path)
+{
+    std::vector<TwoLineElement> reference;
+    CatalogLoadReport referenceReport;
+    if (!LoadCatalogFile(path, reference, referenceReport, 1))
+    {
+        PrintCatalogLoadReport(path, referenceReport);
+        return false;
+    }
+    std::size_t named = 0;
+    for (std::size_t i = 0; i < reference.size(); i++)
+        named += reference[i].name[0] != 0;
+    std::cout << "1 thread: " << reference.size() << " records, " << named << " named, "
+              << referenceReport.malformed << " malformed" << std::endl;
+
+    const unsigned int THREAD_COUNTS[] = { 2, 3, 4, 7, 8, 16, 32, 64 };
+    bool same = true;
+    for (unsigned int t = 0; t < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); t++)
+    {
+        std::vector<TwoLineElement> elements;
+        CatalogLoadReport report;
+        LoadCatalogFile(path, elements, report, THREAD_COUNTS[t]);
+        std::size_t index = 0;
+        bool matches = sameElements(reference, elements, index) && report.malformed == referenceReport.malformed;
+        std::cout << THREAD_COUNTS[t] << " threads (" << report.chunks << " chunks): ";
+        if (matches)
+            std::cout << "same" << std::endl;
+        else
+            std::cout << "differs at record " << index << ", " << elements.size() << " records, "
+                      << report.malformed << " malformed" << std::endl;
+        same = same && matches;
+    }
+    return same;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef CATALOGLOADER_H
+#define CATALOGLOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "sgp4.h"
+
+// a record that could not be read, line is the first line of the record (1 based)
+struct CatalogRecordError
+{
+    std::size_t line;
+    const char* reason;
+};
+
+// what a load did. only the first CATALOG_MAX_REPORTED_ERRORS errors are kept,
+// malformed counts all of them
+struct CatalogLoadReport
+{
+    bool opened;
+    std::size_t bytes;
+    std::size_t records;
+    std::size_t malformed;
+    unsigned int chunks;
+    double seconds;
+    std::vector<CatalogRecordError> errors;
+};
+
+const std::size_t CATALOG_MAX_REPORTED_ERRORS = 100;
+
+// function to read a catalog of two/three line element sets or a CCSDS OMM CSV
+// export (detected from the header line). the file is memory mapped, split into
+// record aligned chunks and every chunk is parsed on its own thread straight out
+// of the mapping. malformed records are reported and skipped, the rest is loaded
+bool LoadCatalogFile(const std::string& path, std::vector<TwoLineElement>& elements, CatalogLoadReport& report,
+                     unsigned int threads = 0);
+
+// function to print a report the way the program logs loads
+void PrintCatalogLoadReport(const std::string& path, const CatalogLoadReport& report);
+// function to load a file with one thread and again with several, false when a chunking
+// reads different records or finds a different number of malformed ones (--tle-check)
+bool CheckCatalogChunking(const std::string& path);
+
+#endif
@@ -0,0 +1,144 @@
+#include "constellation.h"
+
+// attribute location of the instance matrix in satellite.vs, the variant follows at + 4
+const GLuint INSTANCE_LOCATION = 3;
+
+Constellation::Constellation() : meshes(NULL), instanceVBO(0), capacity(0), count(0), culled(false), visibleCount(0), occludedCount(0)
+{
+    localBounds.center = glm::vec3(0.0f);
+    localBounds.radius = 0.0f;
+}
+
+Constellation::~Constellation()
+{
+    clear();
+}
+// function to create the instance buffer, capacity is the largest satellite count drawn
+void Constellation::init(MeshRegistry& meshes, unsigned int capacity)
+{
+    this->meshes = &meshes;
+    this->capacity = capacity;
+    instances.reserve(capacity);
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    countedBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SatelliteInstance), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+// function to add a part of the satellite model, partModel places it relative to the satellite
+// and meshBounds is the sphere around the part's mesh
+void Constellation::addPart(MeshHandle mesh, GLuint texture, const glm::mat4& partModel, const BoundingSphere& meshBounds)
+{
+    localBounds = MergeSpheres(localBounds, TransformSphere(meshBounds, partModel));
+    Part part;
+    // the part is drawn from a VAO of its own, the mesh's VAO is shared with other draws
+    part.mesh = meshes->addInstanced(mesh, instanceVBO, INSTANCE_LOCATION, sizeof(SatelliteInstance));
+    part.texture = texture;
+    part.model = partModel;
+    part.normal = glm::mat3(glm::transpose(glm::inverse(partModel)));
+    parts.push_back(part);
+}
+
+// function to set the satellite count, the instance buffer grows when count is above the capacity
+void Constellation::resize(unsigned int count)
+{
+    if (count > capacity)
+    {
+        capacity = count;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        countedBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SatelliteInstance), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    this->count = count;
+    instances.resize(count);
+    boundsX.resize(count);
+    boundsY.resize(count);
+    boundsZ.resize(count);
+    boundsRadius.resize(count);
+}
+
+void Constellation::setSatellite(unsigned int index, const glm::mat4& model, float variant)
+{
+    instances[index].model = model;
+    instances[index].variant = variant;
+    BoundingSphere bounds = TransformSphere(localBounds, model);
+    boundsX[index] = bounds.center.x;
+    boundsY[index] = bounds.center.y;
+    boundsZ[index] = bounds.center.z;
+    boundsRadius[index] = bounds.radius;
+}
+// function to keep the satellites whose bounding sphere is inside the frustum and, with an
+// occluder, not hidden behind it. they are copied together so the draw uploads them in one piece
+void Constellation::cull(const Frustum& frustum, const SphereOccluder* occluder)
+{
+    visibleIndices.resize(count);
+    visibleCount = count == 0 ? 0 : (unsigned int)CullSpheres(frustum, &boundsX[0], &boundsY[0], &boundsZ[0],
+        &boundsRadius[0], count, &visibleIndices[0]);
+    unsigned int inFrustum = visibleCount;
+    if (occluder != NULL && visibleCount > 0)
+    {
+        visibleCount = (unsigned int)CullOccluded(*occluder, &boundsX[0], &boundsY[0], &boundsZ[0], &boundsRadius[0],
+            &visibleIndices[0], visibleCount, &visibleIndices[0]);
+    }
+    occludedCount = inFrustum - visibleCount;
+    renderStats.frustumCulled += count - inFrustum;
+    renderStats.occlusionCulled += occludedCount;
+    visibleInstances.resize(visibleCount);
+    for (unsigned int i = 0; i < visibleCount; i++)
+        visibleInstances[i] = instances[visibleIndices[i]];
+    culled = true;
+}
+// function to upload the instance transforms and draw each part once for all satellites,
+// only the ones cull() kept when it was called since the last draw
+void Constellation::draw(CachedShader& shader)
+{
+    const std::vector<SatelliteInstance>& drawn = culled ? visibleInstances : instances;
+    visibleCount = culled ? visibleCount : count;
+    culled = false;
+    if (visibleCount == 0)
+        return;
+
+    // orphan the buffer so the driver does not wait on last frame's draws
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    countedBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SatelliteInstance), NULL, GL_STREAM_DRAW);
+    countedBufferSubData(GL_ARRAY_BUFFER, 0, visibleCount * sizeof(SatelliteInstance), &drawn[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    for (std::size_t i = 0; i < parts.size(); i++)
+    {
+        countedBindTexture(GL_TEXTURE_2D, parts[i].texture);
+        shader.setMat4("part", parts[i].model);
+        shader.setMat3("partNormal", parts[i].normal);
+        meshes->drawInstanced(parts[i].mesh, (GLsizei)visibleCount);
+    }
+    meshes->unbind();
+}
+
+void Constellation::clear()
+{
+    if (instanceVBO != 0)
+        glDeleteBuffers(1, &instanceVBO);
+    instanceVBO = 0;
+    parts.clear();
+    instances.clear();
+    visibleInstances.clear();
+    count = 0;
+    visibleCount = 0;
+    occludedCount = 0;
+    culled = false;
+}
+
+unsigned int Constellation::size() const
+{
+    return count;
+}
+
+unsigned int Constellation::getVisibleCount() const
+{
+    return visibleCount;
+}
+
+unsigned int Constellation::getOccludedCount() const
+{
+    return occludedCount;
+}
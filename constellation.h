@@ -0,0 +1,75 @@
+#pragma once
+#ifndef CONSTELLATION_H
+#define CONSTELLATION_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "cachedshader.h"
+#include "meshregistry.h"
+#include "frustum.h"
+#include "occlusion.h"
+
+// frame time we aim for with 10k satellites under Mesa llvmpipe: every part
+// type is one instanced draw, so the cost is vertex work, not draw calls.
+// --benchmark fails when the p95 frame time of a run with that many or more is over it
+const float CONSTELLATION_TARGET_MS = 16.6f;
+const unsigned int CONSTELLATION_TARGET_COUNT = 10000;
+
+// per satellite data in the instance buffer, read by satellite.vs
+struct SatelliteInstance
+{
+    glm::mat4 model;
+    float variant;
+};
+
+// draws many satellites with one instanced draw per part type (wings, body, dish, ...).
+// every satellite has a bounding sphere made from the bounds of its parts; cull() keeps
+// the satellites inside the view and not behind the earth, the next draw() only uploads
+// and draws those
+class Constellation
+{
+public:
+    Constellation();
+    ~Constellation();
+
+    void init(MeshRegistry& meshes, unsigned int capacity);
+    void addPart(MeshHandle mesh, GLuint texture, const glm::mat4& partModel, const BoundingSphere& meshBounds);
+    void resize(unsigned int count);
+    // may be called for different satellites from several threads at once
+    void setSatellite(unsigned int index, const glm::mat4& model, float variant);
+    void cull(const Frustum& frustum, const SphereOccluder* occluder = NULL);
+    void draw(CachedShader& shader);
+    void clear();
+    unsigned int size() const;
+    // satellites the last draw() drew, and of the others how many the last cull() found behind the occluder
+    unsigned int getVisibleCount() const;
+    unsigned int getOccludedCount() const;
+
+private:
+    struct Part
+    {
+        MeshHandle mesh;
+        GLuint texture;
+        glm::mat4 model;
+        glm::mat3 normal;
+    };
+
+    MeshRegistry* meshes;
+    std::vector<Part> parts;
+    std::vector<SatelliteInstance> instances;
+    GLuint instanceVBO;
+    unsigned int capacity;
+    unsigned int count;
+
+    // world space bounding sphere of every satellite, one array per component for CullSpheres
+    BoundingSphere localBounds;
+    std::vector<float> boundsX, boundsY, boundsZ, boundsRadius;
+    std::vector<unsigned int> visibleIndices;
+    std::vector<SatelliteInstance> visibleInstances;
+    bool culled;
+    unsigned int visibleCount;
+    unsigned int occludedCount;
+};
+
+#endif
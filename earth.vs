@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec3 aMorphPos;
+layout (location = 4) in vec2 aMorphTexCoords;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+// 0 puts every vertex where the next coarser lod level has it, 1 where this level has it
+uniform float morph;
+
+void main()
+{
+    FragPos = vec3(model * vec4(mix(aMorphPos, aPos, morph), 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoords = mix(aMorphTexCoords, aTexCoords, morph);
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,217 @@
+#include "earthlod.h"
+#include "icosphere.h"
+
+#include <cmath>
+#include <cfloat>
+
+const int FLOATS_PER_VERTEX = 13;
+// angle between the ends of an icosahedron edge, every subdivision halves it
+const float ICOSAHEDRON_EDGE_ANGLE = 1.10715f;
+// |y| of a direction treated as a pole, where the longitude is undefined
+const float POLE_Y = 0.999999f;
+
+// function to get the equirectangular tex coord of a direction, as Sphere lays the texture:
+// x = cos(2 pi u) sin(pi v), y = cos(pi v), z = sin(2 pi u) sin(pi v)
+static void DirectionTexCoord(float x, float y, float z, float& u, float& v)
+{
+    const float PI = 3.14159265359f;
+    u = std::atan2(z, x) / (2.0f * PI);
+    if (u < 0.0f)
+        u += 1.0f;
+    v = std::acos(y < -1.0f ? -1.0f : (y > 1.0f ? 1.0f : y)) / PI;
+}
+
+// function to bring b within half a turn of a, so u can be interpolated across the date line
+static float NearestTurn(float a, float b)
+{
+    if (b - a > 0.5f)
+        return b - 1.0f;
+    if (a - b > 0.5f)
+        return b + 1.0f;
+    return b;
+}
+
+// function to append a copy of a vertex, returns the index of the copy
+static unsigned int CopyVertex(std::vector<float>& vertices, unsigned int index)
+{
+    float vertex[FLOATS_PER_VERTEX];
+    for (int i = 0; i < FLOATS_PER_VERTEX; i++)
+        vertex[i] = vertices[index * FLOATS_PER_VERTEX + i];
+    vertices.insert(vertices.end(), vertex, vertex + FLOATS_PER_VERTEX);
+    return (unsigned int)(vertices.size() / FLOATS_PER_VERTEX - 1);
+}
+
+void BuildEarthLodMesh(int level, float radius, const glm::vec3& center, EarthLodMesh& mesh)
+{
+    Icosphere sphere(radius, level, true);
+    const float* positions = sphere.getVertices();
+    const unsigned int* triangles = sphere.getIndices();
+    std::vector<unsigned int> parents = sphere.computeParentEdges();
+    std::size_t vertexCount = sphere.getVertexCount();
+    std::size_t indexCount = sphere.getIndexCount();
+
+    // the icosphere has its poles on z, the earth on y: (x, y, z) -> (x, z, -y)
+    std::vector<float> directions(vertexCount * 3);
+    std::vector<float> texCoords(vertexCount * 2);
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        const float* p = positions + i * 3;
+        float length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        float* d = &directions[i * 3];
+        d[0] = p[0] / length;
+        d[1] = p[2] / length;
+        d[2] = -p[1] / length;
+        DirectionTexCoord(d[0], d[1], d[2], texCoords[i * 2], texCoords[i * 2 + 1]);
+    }
+
+    mesh.vertices.resize(vertexCount * FLOATS_PER_VERTEX);
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        const float* d = &directions[i * 3];
+        float u = texCoords[i * 2], v = texCoords[i * 2 + 1];
+        float* out = &mesh.vertices[i * FLOATS_PER_VERTEX];
+        out[0] = d[0] * radius + center.x;
+        out[1] = d[1] * radius + center.y;
+        out[2] = d[2] * radius + center.z;
+        out[3] = d[0];
+        out[4] = d[1];
+        out[5] = d[2];
+        out[6] = u;
+        out[7] = v;
+
+        // on the coarser level the vertex lies in the middle of its parent edge, with the
+        // tex coord halfway between the parents' (the vertex's own u stands in at a pole)
+        unsigned int a = parents[i * 2], b = parents[i * 2 + 1];
+        const float* pa = &directions[a * 3];
+        const float* pb = &directions[b * 3];
+        float ua = std::fabs(pa[1]) > POLE_Y ? u : NearestTurn(u, texCoords[a * 2]);
+        float ub = std::fabs(pb[1]) > POLE_Y ? u : NearestTurn(u, texCoords[b * 2]);
+        out[8] = (pa[0] + pb[0]) * 0.5f * radius + center.x;
+        out[9] = (pa[1] + pb[1]) * 0.5f * radius + center.y;
+        out[10] = (pa[2] + pb[2]) * 0.5f * radius + center.z;
+        out[11] = (ua + ub) * 0.5f;
+        out[12] = (texCoords[a * 2 + 1] + texCoords[b * 2 + 1]) * 0.5f;
+    }
+
+    // a triangle across the date line uses copies of its vertices west of it with u + 1,
+    // and a pole gets a copy per triangle with the u of the triangle's other two vertices
+    std::vector<unsigned int> wrapped(vertexCount, ~0u);
+    mesh.indices.resize(indexCount);
+    for (std::size_t t = 0; t < indexCount; t += 3)
+    {
+        bool pole[3];
+        float lowest = 1.0f, highest = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int index = triangles[t + k];
+            pole[k] = std::fabs(directions[index * 3 + 1]) > POLE_Y;
+            if (!pole[k])
+            {
+                float u = texCoords[index * 2];
+                lowest = u < lowest ? u : lowest;
+                highest = u > highest ? u : highest;
+            }
+        }
+        bool acrossDateLine = highest - lowest > 0.5f;
+
+        float us[3];
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int index = triangles[t + k];
+            mesh.indices[t + k] = index;
+            us[k] = texCoords[index * 2];
+            if (pole[k] || !acrossDateLine || us[k] >= 0.5f)
+                continue;
+            if (wrapped[index] == ~0u)
+            {
+                wrapped[index] = CopyVertex(mesh.vertices, index);
+                mesh.vertices[wrapped[index] * FLOATS_PER_VERTEX + 6] += 1.0f;
+                mesh.vertices[wrapped[index] * FLOATS_PER_VERTEX + 11] += 1.0f;
+            }
+            mesh.indices[t + k] = wrapped[index];
+            us[k] += 1.0f;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            if (!pole[k])
+                continue;
+            unsigned int index = triangles[t + k];
+            unsigned int copy = CopyVertex(mesh.vertices, index);
+            float u = (us[(k + 1) % 3] + us[(k + 2) % 3]) * 0.5f;
+            mesh.vertices[copy * FLOATS_PER_VERTEX + 6] = u;
+            mesh.vertices[copy * FLOATS_PER_VERTEX + 11] = u;
+            mesh.indices[t + k] = copy;
+        }
+    }
+}
+
+float ProjectedRadius(const glm::mat4& projection, const glm::mat4& view, const BoundingSphere& sphere, float viewportHeight)
+{
+    const glm::vec3& c = sphere.center;
+    float viewZ = view[0][2] * c.x + view[1][2] * c.y + view[2][2] * c.z + view[3][2];
+    // the clip w of the center: its depth in perspective, 1 in ortho
+    float w = projection[2][3] * viewZ + projection[3][3];
+    if (w <= sphere.radius * std::fabs(projection[2][3]))
+        return FLT_MAX;     // the sphere reaches the eye
+    return sphere.radius * std::fabs(projection[1][1]) / w * viewportHeight * 0.5f;
+}
+
+EarthLod::EarthLod() : meshes(NULL), level(EARTH_LOD_MIN_LEVEL), morph(1.0f)
+{
+    for (int i = 0; i < EARTH_LOD_LEVEL_COUNT; i++)
+        handles[i] = 0;
+    bounds.box.min = bounds.box.max = glm::vec3(0.0f);
+    bounds.sphere.center = glm::vec3(0.0f);
+    bounds.sphere.radius = 0.0f;
+}
+
+void EarthLod::init(MeshRegistry& meshes, const EarthLodMesh* levels)
+{
+    this->meshes = &meshes;
+    for (int i = 0; i < EARTH_LOD_LEVEL_COUNT; i++)
+    {
+        const EarthLodMesh& mesh = levels[i];
+        handles[i] = meshes.addIndexed(&mesh.vertices[0], mesh.vertices.size() * sizeof(GLfloat),
+            &mesh.indices[0], (GLsizei)mesh.indices.size(), LAYOUT_POSITION_NORMAL_TEXCOORD_MORPH);
+    }
+    // every level lies on the same sphere, the coarsest is the cheapest to measure
+    bounds = ComputeBounds(&levels[0].vertices[0], levels[0].vertices.size() / FLOATS_PER_VERTEX, FLOATS_PER_VERTEX);
+}
+// the silhouette of a level is off by about r (1 - cos(angle / 2)), r angle^2 / 8 pixels, where
+// angle is the edge angle of the level; ideal is the fractional level where that is the error
+// allowed. the level above it is drawn, morphed toward the one below by what ideal lacks
+void EarthLod::select(float screenRadius, float bias)
+{
+    float ideal = std::log2(ICOSAHEDRON_EDGE_ANGLE * std::sqrt(screenRadius / (8.0f * EARTH_LOD_ERROR_PIXELS))) + bias;
+    if (!(ideal > (float)EARTH_LOD_MIN_LEVEL))
+    {
+        level = EARTH_LOD_MIN_LEVEL;
+        morph = 1.0f;
+        return;
+    }
+    level = (int)std::ceil(ideal);
+    level = level > EARTH_LOD_MAX_LEVEL ? EARTH_LOD_MAX_LEVEL : level;
+    morph = ideal - (float)(level - 1);
+    morph = morph > 1.0f ? 1.0f : morph;
+}
+// function to draw the selected level with the shader bound by the caller
+void EarthLod::draw(CachedShader& shader) const
+{
+    shader.setFloat("morph", morph);
+    meshes->draw(handles[level - EARTH_LOD_MIN_LEVEL]);
+}
+
+int EarthLod::getLevel() const
+{
+    return level;
+}
+
+float EarthLod::getMorph() const
+{
+    return morph;
+}
+
+const Bounds& EarthLod::getBounds() const
+{
+    return bounds;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef EARTHLOD_H
+#define EARTHLOD_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "cachedshader.h"
+#include "meshregistry.h"
+#include "bounds.h"
+
+// icosphere subdivision levels of the earth, 320 to 1.3M triangles
+const int EARTH_LOD_MIN_LEVEL = 2;
+const int EARTH_LOD_MAX_LEVEL = 8;
+const int EARTH_LOD_LEVEL_COUNT = EARTH_LOD_MAX_LEVEL - EARTH_LOD_MIN_LEVEL + 1;
+// largest distance in pixels between a level's triangles and the true sphere
+const float EARTH_LOD_ERROR_PIXELS = 0.25f;
+
+// one level of the chain, 13 floats per vertex: position, normal and tex coord, then the
+// position and tex coord the vertex has on the next coarser level, for LAYOUT_POSITION_NORMAL_TEXCOORD_MORPH
+struct EarthLodMesh
+{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// function to build a level from a smooth icosphere, with equirectangular tex coords like
+// Sphere's and its poles on y. the vertices along the date line and at the poles are split
+// so the texture does not wrap backwards. safe to call from worker threads
+void BuildEarthLodMesh(int level, float radius, const glm::vec3& center, EarthLodMesh& mesh);
+// function to get the radius in pixels of a sphere drawn with view and projection into a
+// viewport viewportHeight pixels high, works for perspective and ortho projections
+float ProjectedRadius(const glm::mat4& projection, const glm::mat4& view, const BoundingSphere& sphere, float viewportHeight);
+
+// the earth drawn with the icosphere level whose error on screen is under EARTH_LOD_ERROR_PIXELS.
+// a level's new vertices slide from the coarser level's surface to their own as the earth
+// grows on screen (geomorphing, the morph uniform of earth.vs), so switching levels does not pop
+class EarthLod
+{
+public:
+    EarthLod();
+
+    // function to upload the levels, mesh[i] is level EARTH_LOD_MIN_LEVEL + i
+    void init(MeshRegistry& meshes, const EarthLodMesh* levels);
+    // function to pick the level and morph for the earth's radius on screen, bias adds whole levels
+    void select(float screenRadius, float bias = 0.0f);
+    void draw(CachedShader& shader) const;
+    int getLevel() const;
+    float getMorph() const;
+    // box and sphere around the vertices, in mesh space
+    const Bounds& getBounds() const;
+
+private:
+    MeshRegistry* meshes;
+    MeshHandle handles[EARTH_LOD_LEVEL_COUNT];
+    Bounds bounds;
+    int level;
+    float morph;
+};
+
+#endif
@@ -0,0 +1,495 @@
+#include "earthtiles.h"
+#include "frustum.h"
+#include "renderstats.h"
+#include "texturecache.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+const unsigned long long NO_TILE = ~0ULL;
+// the tiles of level 0, never evicted
+const unsigned int PINNED_TILES = 2;
+
+static bool FileExists(const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+    return file.good();
+}
+
+// function to get the direction of a point of the equirectangular imagery, as Sphere lays
+// the texture: x = cos(2 pi u) sin(pi v), y = cos(pi v), z = sin(2 pi u) sin(pi v)
+static glm::vec3 ImageDirection(float u, float v)
+{
+    const float PI = 3.14159265359f;
+    float ring = std::sin(v * PI);
+    return glm::vec3(std::cos(u * 2.0f * PI) * ring, std::cos(v * PI), std::sin(u * 2.0f * PI) * ring);
+}
+
+static float AngleBetween(const glm::vec3& a, const glm::vec3& b)
+{
+    float cosine = a.x * b.x + a.y * b.y + a.z * b.z;
+    return std::acos(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+}
+
+EarthTiles::EarthTiles() : maxLevel(0), tableWidth(0), tableHeight(0), tileTexture(0), tableTexture(0), frame(0),
+                           loading(NO_TILE), isLoading(false), stopping(false)
+{
+}
+
+EarthTiles::~EarthTiles()
+{
+    close();
+}
+
+EarthTiles::TileKey EarthTiles::makeKey(int level, int x, int y)
+{
+    return ((TileKey)level << 48) | ((TileKey)y << 24) | (TileKey)x;
+}
+
+std::string EarthTiles::tilePath(TileKey key) const
+{
+    int level = (int)(key >> 48), y = (int)((key >> 24) & 0xFFFFFF), x = (int)(key & 0xFFFFFF);
+    return directory + "/" + std::to_string(level) + "/" + std::to_string(x) + "_" + std::to_string(y) + extension;
+}
+// function to box filter the mip levels of a decoded tile below its full size
+static void BuildTileMips(const DecodedImage& image, std::vector<unsigned char>& mips)
+{
+    std::vector<unsigned char> level(image.pixels, image.pixels + (std::size_t)EARTH_TILE_SIZE * EARTH_TILE_SIZE * 4), half;
+    mips.clear();
+    for (unsigned int size = EARTH_TILE_SIZE; size > 1; size /= 2)
+    {
+        HalveImage(level, size, size, 4, half);
+        mips.insert(mips.end(), half.begin(), half.end());
+        level.swap(half);
+    }
+}
+// function to decode a tile and filter its mip levels on any thread, false when it is
+// missing or not a tile. every tile comes out as RGBA, grey ones included, the format of
+// the array texture's layers
+bool EarthTiles::decodeTile(TileKey key, DecodedImage& image, std::vector<unsigned char>& mips) const
+{
+    if (!DecodeImage(tilePath(key), image, 4))
+        return false;
+    if (image.width != EARTH_TILE_SIZE || image.height != EARTH_TILE_SIZE)
+    {
+        std::cout << "Earth tile " << image.path << " is not " << EARTH_TILE_SIZE << "x" << EARTH_TILE_SIZE << std::endl;
+        FreeImage(image);
+        return false;
+    }
+    BuildTileMips(image, mips);
+    return true;
+}
+
+bool EarthTiles::open(const std::string& directory)
+{
+    close();
+    this->directory = directory;
+    const char* EXTENSIONS[] = { ".jpg", ".png", ".ppm" };
+    extension.clear();
+    for (unsigned int i = 0; i < 3 && extension.empty(); i++)
+    {
+        if (FileExists(directory + "/0/0_0" + EXTENSIONS[i]))
+            extension = EXTENSIONS[i];
+    }
+    if (extension.empty())
+    {
+        std::cout << "No earth tiles under " << directory << ", expected " << directory << "/0/0_0.jpg" << std::endl;
+        return false;
+    }
+    maxLevel = 0;
+    while (maxLevel < EARTH_TILE_MAX_LEVEL && FileExists(directory + "/" + std::to_string(maxLevel + 1) + "/0_0" + extension))
+        maxLevel++;
+
+    tableWidth = 2 << maxLevel;
+    tableHeight = 1 << maxLevel;
+    table.assign((std::size_t)tableWidth * tableHeight * 2, 0);
+    Layer empty = { NO_TILE, 0, false };
+    layers.assign(EARTH_TILE_CACHE_LAYERS, empty);
+    resident.clear();
+    residentBelow.clear();
+    missing.clear();
+    frame = 0;
+
+    glGenTextures(1, &tileTexture);
+    countedBindTexture(GL_TEXTURE_2D_ARRAY, tileTexture);
+    // the tiles shrink when the earth is small on screen, without mip levels they would alias
+    for (int level = 0; level < EARTH_TILE_MIP_LEVELS; level++)
+    {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, EARTH_TILE_SIZE >> level, EARTH_TILE_SIZE >> level,
+            EARTH_TILE_CACHE_LAYERS, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, EARTH_TILE_MIP_LEVELS - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    countedBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // integer textures are only read with texelFetch, nearest keeps them complete
+    glGenTextures(1, &tableTexture);
+    countedBindTexture(GL_TEXTURE_2D, tableTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8UI, tableWidth, tableHeight, 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    countedBindTexture(GL_TEXTURE_2D, 0);
+
+    // level 0 is loaded here, everything else falls back to it
+    for (int x = 0; x < 2; x++)
+    {
+        DecodedImage image;
+        std::vector<unsigned char> mips;
+        bool loadedTile = decodeTile(makeKey(0, x, 0), image, mips) && uploadTile(makeKey(0, x, 0), image, mips, true);
+        FreeImage(image);
+        if (!loadedTile)
+        {
+            close();
+            return false;
+        }
+    }
+
+    stopping = false;
+    isLoading = false;
+    loader = std::thread(&EarthTiles::loaderLoop, this);
+    return true;
+}
+
+void EarthTiles::close()
+{
+    if (loader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        requestReady.notify_all();
+        loader.join();
+    }
+    requests.clear();
+    for (std::size_t i = 0; i < loaded.size(); i++)
+        FreeImage(loaded[i].image);
+    loaded.clear();
+    if (tileTexture != 0)
+    {
+        glDeleteTextures(1, &tileTexture);
+        glDeleteTextures(1, &tableTexture);
+    }
+    tileTexture = tableTexture = 0;
+    resident.clear();
+    residentBelow.clear();
+    layers.clear();
+    std::vector<unsigned char>().swap(table);
+}
+
+bool EarthTiles::isOpen() const
+{
+    return tileTexture != 0;
+}
+// the loader thread takes the oldest request, the most important one of the last update
+void EarthTiles::loaderLoop()
+{
+    for (;;)
+    {
+        TileKey key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requestReady.wait(lock, [this]() { return stopping || !requests.empty(); });
+            if (stopping)
+                return;
+            key = requests.front();
+            requests.pop_front();
+            loading = key;
+            isLoading = true;
+        }
+
+        LoadedTile tile;
+        tile.key = key;
+        decodeTile(key, tile.image, tile.mips);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded.push_back(std::move(tile));
+            isLoading = false;
+        }
+        tileReady.notify_all();
+    }
+}
+
+void EarthTiles::update(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& eye,
+                        const BoundingSphere& earth, float viewportHeight, bool wait)
+{
+    if (!isOpen())
+        return;
+    frame++;
+    selectTiles(projection, view, eye, earth, viewportHeight);
+
+    // the requests of the last frame that were not started are replaced by this frame's
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.clear();
+        for (std::size_t i = 0; i < selected.size(); i++)
+        {
+            TileKey key = selected[i];
+            std::unordered_map<TileKey, unsigned int>::iterator found = resident.find(key);
+            if (found != resident.end())
+            {
+                layers[found->second].lastUsed = frame;
+                continue;
+            }
+            if (missing.count(key) != 0 || (isLoading && loading == key))
+                continue;
+            bool decoded = false;
+            for (std::size_t j = 0; j < loaded.size() && !decoded; j++)
+                decoded = loaded[j].key == key;
+            if (!decoded)
+                requests.push_back(key);
+        }
+    }
+    requestReady.notify_one();
+
+    // a few finished tiles per frame, or all of them until nothing is left to load
+    unsigned int uploads = 0;
+    for (;;)
+    {
+        std::vector<LoadedTile> finished;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (wait)
+                tileReady.wait(lock, [this]() { return !loaded.empty() || (requests.empty() && !isLoading); });
+            std::size_t count = loaded.size();
+            if (!wait && count > EARTH_TILE_UPLOADS_PER_FRAME - uploads)
+                count = EARTH_TILE_UPLOADS_PER_FRAME - uploads;
+            finished.assign(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.begin() + count));
+            loaded.erase(loaded.begin(), loaded.begin() + count);
+        }
+        if (finished.empty())
+            break;
+        for (std::size_t i = 0; i < finished.size(); i++)
+        {
+            if (finished[i].image.pixels == NULL)
+                missing.insert(finished[i].key);
+            else if (resident.count(finished[i].key) == 0)
+                uploadTile(finished[i].key, finished[i].image, finished[i].mips, false);
+            FreeImage(finished[i].image);
+        }
+        uploads += (unsigned int)finished.size();
+        if (!wait)
+            break;
+    }
+    renderStats.tilesResident = (unsigned int)resident.size();
+}
+// breadth first from level 0: a tile in view and in front of the horizon whose texels are
+// larger on screen than EARTH_TILE_ERROR_PIXELS is replaced by its four children, as long as
+// the tiles picked still fit in the cache
+void EarthTiles::selectTiles(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& eye,
+                             const BoundingSphere& earth, float viewportHeight)
+{
+    const float PI = 3.14159265359f;
+    Frustum frustum;
+    ExtractFrustum(projection * view, frustum);
+    glm::vec3 toEye(eye.x - earth.center.x, eye.y - earth.center.y, eye.z - earth.center.z);
+    float eyeDistance = std::sqrt(toEye.x * toEye.x + toEye.y * toEye.y + toEye.z * toEye.z);
+    glm::vec3 eyeDirection(toEye.x / eyeDistance, toEye.y / eyeDistance, toEye.z / eyeDistance);
+    // a point of the surface is seen when its angle from the eye direction is under this
+    float horizon = eyeDistance > earth.radius ? std::acos(earth.radius / eyeDistance) : PI;
+    // pixels of a unit length at clip w 1, w grows with the distance in perspective only
+    float pixelsPerUnit = std::fabs(projection[1][1]) * viewportHeight * 0.5f;
+    const unsigned int BUDGET = EARTH_TILE_CACHE_LAYERS - PINNED_TILES;
+
+    selected.clear();
+    std::deque<TileKey> queue;
+    queue.push_back(makeKey(0, 0, 0));
+    queue.push_back(makeKey(0, 1, 0));
+    while (!queue.empty())
+    {
+        TileKey key = queue.front();
+        queue.pop_front();
+        int level = (int)(key >> 48), y = (int)((key >> 24) & 0xFFFFFF), x = (int)(key & 0xFFFFFF);
+        float columns = (float)(2 << level), rows = (float)(1 << level);
+
+        // the patch of the sphere under the tile: the direction of its middle and the angle to
+        // the farthest point of its border. the two top levels span a hemisphere or more
+        glm::vec3 middle = ImageDirection((x + 0.5f) / columns, (y + 0.5f) / rows);
+        float extent = PI;
+        if (level >= 2)
+        {
+            extent = 0.0f;
+            for (int k = 0; k < 9; k++)
+            {
+                if (k == 4)
+                    continue;
+                float angle = AngleBetween(middle, ImageDirection((x + (k % 3) * 0.5f) / columns, (y + (k / 3) * 0.5f) / rows));
+                extent = angle > extent ? angle : extent;
+            }
+        }
+        if (AngleBetween(middle, eyeDirection) - extent > horizon)
+            continue;
+        BoundingSphere patch;
+        patch.center = glm::vec3(earth.center.x + middle.x * earth.radius, earth.center.y + middle.y * earth.radius,
+                                 earth.center.z + middle.z * earth.radius);
+        patch.radius = 2.0f * earth.radius * std::sin(extent * 0.5f);
+        if (!SphereInFrustum(frustum, patch))
+            continue;
+
+        // a texel spans 2 pi / (columns * size) of the equator, less toward the poles
+        float texel = earth.radius * 2.0f * PI / (columns * EARTH_TILE_SIZE);
+        glm::vec3 toPatch(patch.center.x - eye.x, patch.center.y - eye.y, patch.center.z - eye.z);
+        float distance = std::sqrt(toPatch.x * toPatch.x + toPatch.y * toPatch.y + toPatch.z * toPatch.z) - patch.radius;
+        distance = distance > 1e-4f ? distance : 1e-4f;
+        float w = std::fabs(projection[2][3]) * distance + projection[3][3];
+        float pixels = texel * pixelsPerUnit / w;
+
+        if (pixels > EARTH_TILE_ERROR_PIXELS && level < maxLevel && selected.size() + queue.size() + 4 <= BUDGET)
+        {
+            for (int k = 0; k < 4; k++)
+                queue.push_back(makeKey(level + 1, x * 2 + (k & 1), y * 2 + (k >> 1)));
+        }
+        else
+            selected.push_back(key);
+    }
+}
+// function to put a tile into a free layer, or the one of the least recently used tile not
+// picked this frame. false when every layer is in use
+bool EarthTiles::uploadTile(TileKey key, const DecodedImage& image, const std::vector<unsigned char>& mips, bool pinned)
+{
+    unsigned int layer = EARTH_TILE_CACHE_LAYERS;
+    for (unsigned int i = 0; i < layers.size(); i++)
+    {
+        if (layers[i].key == NO_TILE)
+        {
+            layer = i;
+            break;
+        }
+        if (!layers[i].pinned && layers[i].lastUsed < frame &&
+            (layer == EARTH_TILE_CACHE_LAYERS || layers[i].lastUsed < layers[layer].lastUsed))
+            layer = i;
+    }
+    if (layer == EARTH_TILE_CACHE_LAYERS)
+        return false;
+
+    TileKey evicted = layers[layer].key;
+    if (evicted != NO_TILE)
+    {
+        resident.erase(evicted);
+        countDescendant(evicted, -1);
+    }
+    layers[layer].key = key;
+    layers[layer].lastUsed = frame;
+    layers[layer].pinned = pinned;
+    resident[key] = layer;
+    countDescendant(key, 1);
+
+    countedBindTexture(GL_TEXTURE_2D_ARRAY, tileTexture);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, EARTH_TILE_SIZE, EARTH_TILE_SIZE, 1,
+        GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+    const unsigned char* mip = mips.empty() ? NULL : &mips[0];
+    for (int level = 1; level < EARTH_TILE_MIP_LEVELS && mip != NULL; level++)
+    {
+        int size = EARTH_TILE_SIZE >> level;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, mip);
+        mip += (std::size_t)size * size * 4;
+    }
+    countedBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    renderStats.bytesUploaded += (unsigned long long)EARTH_TILE_SIZE * EARTH_TILE_SIZE * image.channels + mips.size();
+    renderStats.tilesUploaded++;
+
+    if (evicted != NO_TILE)
+        refreshTable(evicted);
+    refreshTable(key);
+    return true;
+}
+// function to rewrite the table under a tile that came or went: every texel gets the deepest
+// tile in the cache among the tile, its ancestors and the descendants above the texel
+void EarthTiles::refreshTable(TileKey key)
+{
+    int level = (int)(key >> 48), y = (int)((key >> 24) & 0xFFFFFF), x = (int)(key & 0xFFFFFF);
+    unsigned char layer = 0, layerLevel = 0;
+    for (int l = level - 1; l >= 0; l--)
+    {
+        std::unordered_map<TileKey, unsigned int>::const_iterator found = resident.find(makeKey(l, x >> (level - l), y >> (level - l)));
+        if (found != resident.end())
+        {
+            layer = (unsigned char)found->second;
+            layerLevel = (unsigned char)l;
+            break;
+        }
+    }
+    fillTable(level, x, y, layer, layerLevel);
+
+    int shift = maxLevel - level;
+    int size = 1 << shift;
+    countedBindTexture(GL_TEXTURE_2D, tableTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, tableWidth);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x << shift, y << shift, size, size, GL_RG_INTEGER, GL_UNSIGNED_BYTE,
+        &table[(((std::size_t)y << shift) * tableWidth + ((std::size_t)x << shift)) * 2]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    countedBindTexture(GL_TEXTURE_2D, 0);
+    renderStats.bytesUploaded += (unsigned long long)size * size * 2;
+}
+
+void EarthTiles::fillTable(int level, int x, int y, unsigned char layer, unsigned char layerLevel)
+{
+    std::unordered_map<TileKey, unsigned int>::const_iterator found = resident.find(makeKey(level, x, y));
+    if (found != resident.end())
+    {
+        layer = (unsigned char)found->second;
+        layerLevel = (unsigned char)level;
+    }
+    // with nothing deeper in the cache the whole tile gets this entry
+    if (level == maxLevel || !hasResidentBelow(level, x, y))
+    {
+        int shift = maxLevel - level;
+        for (int row = y << shift; row < (y + 1) << shift; row++)
+        {
+            unsigned char* texel = &table[((std::size_t)row * tableWidth + ((std::size_t)x << shift)) * 2];
+            for (int column = 0; column < 1 << shift; column++, texel += 2)
+            {
+                texel[0] = layer;
+                texel[1] = layerLevel;
+            }
+        }
+        return;
+    }
+    for (int k = 0; k < 4; k++)
+        fillTable(level + 1, x * 2 + (k & 1), y * 2 + (k >> 1), layer, layerLevel);
+}
+
+bool EarthTiles::hasResidentBelow(int level, int x, int y) const
+{
+    return residentBelow.count(makeKey(level, x, y)) != 0;
+}
+// function to count a tile that came into the cache (change 1) or left it (-1) at every
+// ancestor, a tile without resident descendants has no entry
+void EarthTiles::countDescendant(TileKey key, int change)
+{
+    int level = (int)(key >> 48), y = (int)((key >> 24) & 0xFFFFFF), x = (int)(key & 0xFFFFFF);
+    for (int l = level - 1; l >= 0; l--)
+    {
+        TileKey ancestor = makeKey(l, x >> (level - l), y >> (level - l));
+        if (change > 0)
+            residentBelow[ancestor]++;
+        else
+        {
+            std::unordered_map<TileKey, unsigned int>::iterator found = residentBelow.find(ancestor);
+            if (found != residentBelow.end() && --found->second == 0)
+                residentBelow.erase(found);
+        }
+    }
+}
+
+void EarthTiles::bind(GLenum tileUnit, GLenum tableUnit) const
+{
+    glActiveTexture(tileUnit);
+    countedBindTexture(GL_TEXTURE_2D_ARRAY, tileTexture);
+    glActiveTexture(tableUnit);
+    countedBindTexture(GL_TEXTURE_2D, tableTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+unsigned int EarthTiles::getResidentCount() const
+{
+    return (unsigned int)resident.size();
+}
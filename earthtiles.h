@@ -0,0 +1,119 @@
+#pragma once
+#ifndef EARTHTILES_H
+#define EARTHTILES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "cachedshader.h"
+#include "textureloader.h"
+#include "bounds.h"
+
+// the imagery pyramid is equirectangular like earth0.png: level L is 2^(L+1) x 2^L tiles of
+// EARTH_TILE_SIZE pixels, read from DIR/L/X_Y.jpg (or .png, .ppm) with tile 0_0 at the north
+// west corner. level 0 is the whole earth in two tiles
+const int EARTH_TILE_SIZE = 256;
+// deepest level used, its tiles are 76 m wide at the equator and the indirection table 2048 x 1024
+const int EARTH_TILE_MAX_LEVEL = 10;
+// layers of the tile cache, 85 MB of RGBA with their mip levels
+const unsigned int EARTH_TILE_CACHE_LAYERS = 256;
+// every layer has the full mip chain of its tile, 256 x 256 down to 1 x 1
+const int EARTH_TILE_MIP_LEVELS = 9;
+// tiles uploaded per frame at most, a tile is 256 KB
+const unsigned int EARTH_TILE_UPLOADS_PER_FRAME = 8;
+// largest size on screen, in pixels, of a texel of the tiles picked for a view
+const float EARTH_TILE_ERROR_PIXELS = 1.0f;
+
+// streams the earth imagery from a tile pyramid on disk. every frame update() picks the
+// tiles the view needs, by the size of their texels on screen, and queues the missing ones
+// for a loader thread that decodes them and filters their mip levels. the tiles go into the
+// layers of a mipmapped 2D array texture, the least recently used tile gives up its layer
+// when all are taken. an indirection table with a texel per tile of the deepest level
+// holds the layer and level of the most detailed tile in the cache covering it, earth.fs
+// samples through it. level 0 is loaded by open() and never evicted, so every part of the
+// earth has a tile
+class EarthTiles
+{
+public:
+    EarthTiles();
+    ~EarthTiles();
+
+    // function to find the levels under directory, load level 0 and start the loader thread.
+    // false when there is no pyramid there, the earth keeps its single texture then
+    bool open(const std::string& directory);
+    void close();
+    bool isOpen() const;
+    // function to pick and queue the tiles for a view and upload the ones the loader finished.
+    // eye is where the earth is seen from, viewportHeight the pixels the projection spans.
+    // with wait set it returns when every picked tile is in (headless frames and posters)
+    void update(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& eye,
+                const BoundingSphere& earth, float viewportHeight, bool wait);
+    // function to bind the tile array and the table to the units the shader's samplers use
+    void bind(GLenum tileUnit, GLenum tableUnit) const;
+    unsigned int getResidentCount() const;
+
+private:
+    typedef unsigned long long TileKey;
+
+    struct LoadedTile
+    {
+        TileKey key;
+        DecodedImage image;
+        std::vector<unsigned char> mips;    // levels 1 and down, one after the other
+    };
+
+    struct Layer
+    {
+        TileKey key;
+        unsigned long long lastUsed;        // frame the tile was last picked
+        bool pinned;
+    };
+
+    static TileKey makeKey(int level, int x, int y);
+    std::string tilePath(TileKey key) const;
+    bool decodeTile(TileKey key, DecodedImage& image, std::vector<unsigned char>& mips) const;
+    void loaderLoop();
+    void selectTiles(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& eye,
+                     const BoundingSphere& earth, float viewportHeight);
+    bool uploadTile(TileKey key, const DecodedImage& image, const std::vector<unsigned char>& mips, bool pinned);
+    void countDescendant(TileKey key, int change);
+    void refreshTable(TileKey key);
+    void fillTable(int level, int x, int y, unsigned char layer, unsigned char layerLevel);
+    bool hasResidentBelow(int level, int x, int y) const;
+
+    std::string directory;
+    std::string extension;
+    int maxLevel;
+    int tableWidth, tableHeight;
+    GLuint tileTexture, tableTexture;
+    std::vector<unsigned char> table;       // layer and level per texel, as the RG8UI table
+    std::vector<Layer> layers;
+    std::unordered_map<TileKey, unsigned int> resident;
+    std::unordered_map<TileKey, unsigned int> residentBelow;   // per tile, resident tiles under it
+    std::unordered_set<TileKey> missing;    // tiles that did not load, never asked for again
+    std::vector<TileKey> selected;
+    unsigned long long frame;
+
+    // shared with the loader thread
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable requestReady, tileReady;
+    std::deque<TileKey> requests;
+    std::vector<LoadedTile> loaded;
+    TileKey loading;
+    bool isLoading;
+    bool stopping;
+
+    // the thread and the GL objects are owned, so the tiles are not copied
+    EarthTiles(const EarthTiles&);
+    EarthTiles& operator=(const EarthTiles&);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "framebuffer.h"
+#include <iostream>
+
+Framebuffer::Framebuffer() : width(0), height(0), samples(0), drawFBO(0), colorRBO(0), depthRBO(0),
+    resolveFBO(0), resolveRBO(0)
+{
+
+}
+
+Framebuffer::~Framebuffer()
+{
+    release();
+}
+
+// function to create the renderbuffers, samples is clamped to what the driver supports
+bool Framebuffer::create(int width, int height, int samples)
+{
+    release();
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    if (samples > maxSamples)
+        samples = maxSamples;
+    if (samples < 2)
+        samples = 0;
+    this->width = width;
+    this->height = height;
+    this->samples = samples;
+
+    glGenFramebuffers(1, &drawFBO);
+    glGenRenderbuffers(1, &colorRBO);
+    glGenRenderbuffers(1, &depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete && samples > 0)
+    {
+        glGenFramebuffers(1, &resolveFBO);
+        glGenRenderbuffers(1, &resolveRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, resolveRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRBO);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        std::cout << "Failed to create a " << width << "x" << height << " framebuffer" << std::endl;
+        release();
+    }
+    return complete;
+}
+
+// function to draw into the framebuffer, the viewport covers all of it
+void Framebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFBO);
+    glViewport(0, 0, width, height);
+}
+
+// function to resolve the multisampled image, afterwards getReadFBO() is bound for reading
+void Framebuffer::resolve() const
+{
+    if (resolveFBO != 0)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, drawFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, getReadFBO());
+}
+
+void Framebuffer::release()
+{
+    if (drawFBO != 0)
+        glDeleteFramebuffers(1, &drawFBO);
+    if (resolveFBO != 0)
+        glDeleteFramebuffers(1, &resolveFBO);
+    GLuint renderbuffers[3] = { colorRBO, depthRBO, resolveRBO };
+    for (int i = 0; i < 3; i++)
+    {
+        if (renderbuffers[i] != 0)
+            glDeleteRenderbuffers(1, &renderbuffers[i]);
+    }
+    drawFBO = colorRBO = depthRBO = 0;
+    resolveFBO = resolveRBO = 0;
+    width = height = samples = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <glad/glad.h>
+
+// offscreen render target with a color and a depth/stencil renderbuffer.
+// with samples > 1 the scene is drawn multisampled and resolve() blits it
+// into a single sampled copy that can be read back
+class Framebuffer
+{
+public:
+    Framebuffer();
+    ~Framebuffer();
+
+    bool create(int width, int height, int samples = 0);
+    void bind() const;
+    void resolve() const;
+    void release();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    GLuint getDrawFBO() const { return drawFBO; }
+    GLuint getReadFBO() const { return resolveFBO != 0 ? resolveFBO : drawFBO; }
+
+private:
+    Framebuffer(const Framebuffer&);
+    Framebuffer& operator=(const Framebuffer&);
+
+    int width, height, samples;
+    GLuint drawFBO, colorRBO, depthRBO;
+    GLuint resolveFBO, resolveRBO;
+};
+
+#endif
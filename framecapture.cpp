@@ -0,0 +1,255 @@
+#include "framecapture.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+FrameCapture::FrameCapture() : width(0), height(0), format(CAPTURE_Y4M), output(NULL), pipe(false), head(0),
+    pending(0), frames(0), stopping(false)
+{
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++)
+    {
+        slots[i].pbo = 0;
+        slots[i].fence = 0;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    close();
+}
+
+// function to open the output, create the pixel pack buffers and start the writer thread
+bool FrameCapture::open(const std::string& path, int width, int height, double fps, CaptureFormat format)
+{
+    close();
+    pipe = !path.empty() && path[0] == '|';
+    output = pipe ? popen(path.c_str() + 1, "wb") : fopen(path.c_str(), "wb");
+    if (output == NULL)
+    {
+        std::cout << "Failed to open capture output " << path << std::endl;
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    this->format = format;
+    if (format == CAPTURE_Y4M)
+    {
+        // frame rate as a fraction, 29.97 becomes 30000:1001
+        unsigned int numerator = (unsigned int)(fps * 1001.0 + 0.5);
+        unsigned int denominator = 1001;
+        if (numerator % 1001 == 0)
+        {
+            numerator /= 1001;
+            denominator = 1;
+        }
+        fprintf(output, "YUV4MPEG2 W%d H%d F%u:%u Ip A1:1 C420jpeg\n", width, height, numerator, denominator);
+    }
+
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++)
+    {
+        glGenBuffers(1, &slots[i].pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, NULL, GL_STREAM_READ);
+        slots[i].fence = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    head = 0;
+    pending = 0;
+    frames = 0;
+    stopping = false;
+    writer = std::thread(&FrameCapture::writerLoop, this);
+    return true;
+}
+
+// function to read back the framebuffer bound for reading. glReadPixels only queues a copy
+// into the buffer of the next slot, the pixels are picked up frames later by collect()
+void FrameCapture::capture()
+{
+    if (output == NULL)
+        return;
+    // the ring is full only when the gpu is CAPTURE_RING_SIZE frames behind, then the oldest is waited for
+    collect(pending == CAPTURE_RING_SIZE);
+
+    Slot& slot = slots[head];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    head = (head + 1) % CAPTURE_RING_SIZE;
+    pending++;
+    frames++;
+}
+
+// function to hand every finished readback to the writer, oldest first. with wait
+// the oldest one is waited for, otherwise only fences that already signaled are taken
+void FrameCapture::collect(bool wait)
+{
+    while (pending > 0)
+    {
+        Slot& slot = slots[(head - pending + CAPTURE_RING_SIZE) % CAPTURE_RING_SIZE];
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+        if (status == GL_TIMEOUT_EXPIRED && wait)
+            continue;
+        if (status == GL_TIMEOUT_EXPIRED)
+            return;
+        wait = false;
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+        pending--;
+        if (status == GL_WAIT_FAILED)
+        {
+            std::cout << "Capture readback failed, a frame is missing" << std::endl;
+            continue;
+        }
+
+        // a spare buffer to copy into, if the writer is CAPTURE_MAX_QUEUED frames behind wait for it
+        std::vector<unsigned char> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]() { return queued.size() < CAPTURE_MAX_QUEUED; });
+            if (!spare.empty())
+            {
+                frame.swap(spare.back());
+                spare.pop_back();
+            }
+        }
+        frame.resize((std::size_t)width * height * 4);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)frame.size(), GL_MAP_READ_BIT);
+        if (pixels != NULL)
+        {
+            memcpy(&frame[0], pixels, frame.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::vector<unsigned char>());
+        queued.back().swap(frame);
+        changed.notify_all();
+    }
+}
+
+void FrameCapture::writerLoop()
+{
+    std::vector<unsigned char> frame;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!frame.empty())
+            {
+                spare.push_back(std::vector<unsigned char>());
+                spare.back().swap(frame);
+            }
+            changed.wait(lock, [this]() { return stopping || !queued.empty(); });
+            if (queued.empty())
+                return;
+            frame.swap(queued.front());
+            queued.pop_front();
+            changed.notify_all();
+        }
+        writeFrame(frame);
+    }
+}
+
+// function to write one frame, the readback is bottom row first
+void FrameCapture::writeFrame(const std::vector<unsigned char>& rgba)
+{
+    const std::size_t stride = (std::size_t)width * 4;
+    if (format == CAPTURE_RGB)
+    {
+        converted.resize((std::size_t)width * height * 3);
+        unsigned char* out = &converted[0];
+        for (int y = height - 1; y >= 0; y--)
+        {
+            const unsigned char* row = &rgba[y * stride];
+            for (int x = 0; x < width; x++, out += 3)
+            {
+                out[0] = row[x * 4];
+                out[1] = row[x * 4 + 1];
+                out[2] = row[x * 4 + 2];
+            }
+        }
+        fwrite(&converted[0], 1, converted.size(), output);
+        return;
+    }
+
+    // full range BT.601 (JPEG) YUV, chroma averaged over 2x2 pixels
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    converted.resize((std::size_t)width * height + 2 * (std::size_t)chromaWidth * chromaHeight);
+    unsigned char* luma = &converted[0];
+    unsigned char* cb = luma + (std::size_t)width * height;
+    unsigned char* cr = cb + (std::size_t)chromaWidth * chromaHeight;
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char* row = &rgba[(height - 1 - y) * stride];
+        unsigned char* out = luma + (std::size_t)y * width;
+        for (int x = 0; x < width; x++)
+            out[x] = (unsigned char)((77 * row[x * 4] + 150 * row[x * 4 + 1] + 29 * row[x * 4 + 2] + 128) >> 8);
+    }
+    for (int cy = 0; cy < chromaHeight; cy++)
+    {
+        int y0 = height - 1 - 2 * cy;
+        int y1 = y0 > 0 ? y0 - 1 : y0;
+        const unsigned char* rows[2] = { &rgba[y0 * stride], &rgba[y1 * stride] };
+        for (int cx = 0; cx < chromaWidth; cx++)
+        {
+            int x0 = 2 * cx * 4;
+            int x1 = 2 * cx + 1 < width ? x0 + 4 : x0;
+            int r = rows[0][x0] + rows[0][x1] + rows[1][x0] + rows[1][x1];
+            int g = rows[0][x0 + 1] + rows[0][x1 + 1] + rows[1][x0 + 1] + rows[1][x1 + 1];
+            int b = rows[0][x0 + 2] + rows[0][x1 + 2] + rows[1][x0 + 2] + rows[1][x1 + 2];
+            // sums of 4 pixels, hence >> 10 instead of >> 8
+            int u = ((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128;
+            int v = ((128 * r - 107 * g - 21 * b + 512) >> 10) + 128;
+            cb[(std::size_t)cy * chromaWidth + cx] = (unsigned char)(u < 0 ? 0 : (u > 255 ? 255 : u));
+            cr[(std::size_t)cy * chromaWidth + cx] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+    }
+    fputs("FRAME\n", output);
+    fwrite(&converted[0], 1, converted.size(), output);
+}
+
+// function to wait for the frames in flight, write them and close the output
+void FrameCapture::close()
+{
+    if (output == NULL)
+        return;
+    while (pending > 0)
+        collect(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    writer.join();
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++)
+    {
+        glDeleteBuffers(1, &slots[i].pbo);
+        slots[i].pbo = 0;
+    }
+    if (pipe)
+        pclose(output);
+    else
+        fclose(output);
+    output = NULL;
+    queued.clear();
+    spare.clear();
+}
+
+bool FrameCapture::isOpen() const
+{
+    return output != NULL;
+}
+
+unsigned int FrameCapture::getFrameCount() const
+{
+    return frames;
+}
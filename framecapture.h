@@ -0,0 +1,75 @@
+#pragma once
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// number of pixel pack buffers in flight, frame n is mapped while n + 1..3 render
+const int CAPTURE_RING_SIZE = 4;
+// frames read back but not yet written before capture() waits for the writer
+const std::size_t CAPTURE_MAX_QUEUED = 8;
+
+enum CaptureFormat
+{
+    CAPTURE_Y4M,        // YUV 4:2:0 (C420jpeg) with a YUV4MPEG2 header, ffmpeg and players read it as is
+    CAPTURE_RGB         // headerless rgb24 frames, top row first (ffmpeg -f rawvideo -pix_fmt rgb24)
+};
+
+// streams the rendered frames to a file or a pipe without stalling the render loop.
+// capture() starts an asynchronous glReadPixels into the next pixel pack buffer and
+// fences it; finished buffers are copied out once their fence signaled and handed to
+// a writer thread that converts and writes them. a path starting with '|' is a
+// command the frames are piped into, e.g. "|ffmpeg -y -i - orbit.mp4"
+class FrameCapture
+{
+public:
+    FrameCapture();
+    ~FrameCapture();
+
+    bool open(const std::string& path, int width, int height, double fps, CaptureFormat format);
+    void capture();
+    void close();
+    bool isOpen() const;
+    unsigned int getFrameCount() const;
+
+private:
+    FrameCapture(const FrameCapture&);
+    FrameCapture& operator=(const FrameCapture&);
+
+    struct Slot
+    {
+        GLuint pbo;
+        GLsync fence;
+    };
+
+    void collect(bool wait);
+    void writerLoop();
+    void writeFrame(const std::vector<unsigned char>& rgba);
+
+    int width, height;
+    CaptureFormat format;
+    FILE* output;
+    bool pipe;
+    Slot slots[CAPTURE_RING_SIZE];
+    int head;                   // next slot to read into
+    int pending;                // slots with a readback in flight, the oldest is head - pending
+    unsigned int frames;
+
+    // handed from the render thread to the writer thread
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<unsigned char> > queued;
+    std::vector<std::vector<unsigned char> > spare;
+    bool stopping;
+    std::vector<unsigned char> converted;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "frustum.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRUSTUM_SSE 1
+#include <emmintrin.h>
+#else
+#define FRUSTUM_SSE 0
+#endif
+
+void ExtractFrustum(const glm::mat4& m, Frustum& frustum)
+{
+    // row r of the matrix is (m[0][r], m[1][r], m[2][r], m[3][r]); the planes are
+    // w + x, w - x, w + y, w - y, w + z and w - z of the clip coordinates
+    for (int p = 0; p < 6; p++)
+    {
+        int row = p / 2;
+        float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+        float a = m[0][3] + sign * m[0][row];
+        float b = m[1][3] + sign * m[1][row];
+        float c = m[2][3] + sign * m[2][row];
+        float d = m[3][3] + sign * m[3][row];
+        float length = std::sqrt(a * a + b * b + c * c);
+        if (length > 0.0f)
+        {
+            a /= length;
+            b /= length;
+            c /= length;
+            d /= length;
+        }
+        frustum.a[p] = a;
+        frustum.b[p] = b;
+        frustum.c[p] = c;
+        frustum.d[p] = d;
+    }
+    for (int p = 6; p < 8; p++)
+    {
+        frustum.a[p] = frustum.a[0];
+        frustum.b[p] = frustum.b[0];
+        frustum.c[p] = frustum.c[0];
+        frustum.d[p] = frustum.d[0];
+    }
+}
+
+#if FRUSTUM_SSE
+
+bool SphereInFrustum(const Frustum& frustum, const BoundingSphere& sphere)
+{
+    __m128 x = _mm_set1_ps(sphere.center.x);
+    __m128 y = _mm_set1_ps(sphere.center.y);
+    __m128 z = _mm_set1_ps(sphere.center.z);
+    __m128 negativeRadius = _mm_set1_ps(-sphere.radius);
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < 8; p += 4)
+    {
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(frustum.a + p), x), _mm_mul_ps(_mm_loadu_ps(frustum.b + p), y)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(frustum.c + p), z), _mm_loadu_ps(frustum.d + p)));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+    }
+    return _mm_movemask_ps(outside) == 0;
+}
+// the corner of the box farthest along each plane normal is max(a min.x, a max.x) + ...,
+// the box is outside when even that corner is behind the plane
+bool AabbInFrustum(const Frustum& frustum, const Aabb& box)
+{
+    __m128 minX = _mm_set1_ps(box.min.x), maxX = _mm_set1_ps(box.max.x);
+    __m128 minY = _mm_set1_ps(box.min.y), maxY = _mm_set1_ps(box.max.y);
+    __m128 minZ = _mm_set1_ps(box.min.z), maxZ = _mm_set1_ps(box.max.z);
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < 8; p += 4)
+    {
+        __m128 a = _mm_loadu_ps(frustum.a + p);
+        __m128 b = _mm_loadu_ps(frustum.b + p);
+        __m128 c = _mm_loadu_ps(frustum.c + p);
+        __m128 distance = _mm_add_ps(_mm_max_ps(_mm_mul_ps(a, minX), _mm_mul_ps(a, maxX)),
+                                     _mm_max_ps(_mm_mul_ps(b, minY), _mm_mul_ps(b, maxY)));
+        distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(c, minZ), _mm_mul_ps(c, maxZ)));
+        distance = _mm_add_ps(distance, _mm_loadu_ps(frustum.d + p));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+    }
+    return _mm_movemask_ps(outside) == 0;
+}
+// four spheres per iteration against the six planes, the ones left over go one by one
+std::size_t CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                        std::size_t count, unsigned int* visible)
+{
+    std::size_t visibleCount = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.a[p]), px), _mm_mul_ps(_mm_set1_ps(frustum.b[p]), py)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.c[p]), pz), _mm_set1_ps(frustum.d[p])));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+        }
+        int inside = ~_mm_movemask_ps(outside) & 15;
+        for (unsigned int lane = 0; inside != 0; lane++, inside >>= 1)
+        {
+            if (inside & 1)
+                visible[visibleCount++] = (unsigned int)(i + lane);
+        }
+    }
+    for (; i < count; i++)
+    {
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(x[i], y[i], z[i]);
+        sphere.radius = radius[i];
+        if (SphereInFrustum(frustum, sphere))
+            visible[visibleCount++] = (unsigned int)i;
+    }
+    return visibleCount;
+}
+
+#else
+
+bool SphereInFrustum(const Frustum& frustum, const BoundingSphere& sphere)
+{
+    for (int p = 0; p < 6; p++)
+    {
+        float distance = frustum.a[p] * sphere.center.x + frustum.b[p] * sphere.center.y + frustum.c[p] * sphere.center.z + frustum.d[p];
+        if (distance < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+bool AabbInFrustum(const Frustum& frustum, const Aabb& box)
+{
+    for (int p = 0; p < 6; p++)
+    {
+        float distance = (frustum.a[p] > 0.0f ? frustum.a[p] * box.max.x : frustum.a[p] * box.min.x)
+                       + (frustum.b[p] > 0.0f ? frustum.b[p] * box.max.y : frustum.b[p] * box.min.y)
+                       + (frustum.c[p] > 0.0f ? frustum.c[p] * box.max.z : frustum.c[p] * box.min.z) + frustum.d[p];
+        if (distance < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+std::size_t CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                        std::size_t count, unsigned int* visible)
+{
+    std::size_t visibleCount = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(x[i], y[i], z[i]);
+        sphere.radius = radius[i];
+        if (SphereInFrustum(frustum, sphere))
+            visible[visibleCount++] = (unsigned int)i;
+    }
+    return visibleCount;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include "bounds.h"
+
+// the six planes of a view volume, a point is inside when a x + b y + c z + d >= 0 for
+// every plane. the coefficients are stored one array each so four planes are tested
+// per instruction; planes 6 and 7 repeat plane 0 to fill the second group of four
+struct Frustum
+{
+    float a[8];
+    float b[8];
+    float c[8];
+    float d[8];
+};
+
+// function to get the planes of projection * view in world space. the planes come from
+// the clip space bounds, so perspective, ortho and the poster's sub frusta all work
+void ExtractFrustum(const glm::mat4& viewProjection, Frustum& frustum);
+bool SphereInFrustum(const Frustum& frustum, const BoundingSphere& sphere);
+bool AabbInFrustum(const Frustum& frustum, const Aabb& box);
+// function to test count spheres, given as one array per component, four at a time.
+// the indices of the visible ones are written to visible in order, returns how many
+std::size_t CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                        std::size_t count, unsigned int* visible);
+
+#endif
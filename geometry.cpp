@@ -7,9 +7,9 @@
 #include"texture.h"
 #include <glm/glm.hpp>
 #include"geometry.h"
-std::vector<GLfloat> Geometry::GetBoxVertices()
-{
-    std::vector<GLfloat> boxVertices = {
+
+/* VERTEX TABLES, 3 floats per position, 3 per normal and 2 per tex coord (the skybox has positions only) */
+static constexpr GLfloat BOX_VERTICES[] = {
     -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
      0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
      0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
@@ -44,12 +44,8 @@ std::vector<GLfloat> Geometry::GetBoxVertices()
      0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
     -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
     -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
-    };
-    return boxVertices;
-}
-std::vector<GLfloat> Geometry::GetPyramidVertices()
-{
-    std::vector<GLfloat> pyramidVertices = {
+};
+static constexpr GLfloat PYRAMID_VERTICES[] = {
         // Positions          // Normals            // Texture Coords
         // Front face
         0.0f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,  0.5f,  1.0f,
@@ -72,38 +68,18 @@ std::vector<GLfloat> Geometry::GetPyramidVertices()
         1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
         1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
         -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f
-    };
-
-    return pyramidVertices;
-}
-std::vector<GLfloat> Geometry::GetCompassVertices()
-{
-    std::vector<GLfloat> compassVertices = {
+};
+static constexpr GLfloat COMPASS_VERTICES[] = {
          0.0f, 0.0f, 1.0f,     0.0f,  0.0f,  1.0f,     0.5f, 0.5f,
          0.5f, -0.5f, .5f,     0.0f,  0.0f,  1.0f,      0.0f, 0.0f,
-         0.5f, 0.5f, 0.5f,     0.0f,  0.0f,  1.0f,     1.0f, 0.0f,
-
-    };
-
-
-
-    return compassVertices;
-}
-std::vector<GLfloat> Geometry::GetCompass2Vertices()
-{
-    std::vector<GLfloat> compassVertices = {
+         0.5f, 0.5f, 0.5f,     0.0f,  0.0f,  1.0f,     1.0f, 0.0f
+};
+static constexpr GLfloat COMPASS2_VERTICES[] = {
         0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.5f, 0.5f,
         -0.5f, -0.5f, .5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-        -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
-    };
-
-
-return compassVertices;
-}
-std::vector<GLfloat> Geometry::GetCubeVertices() 
-{
-    /* VERTICES */
-    std::vector<GLfloat> vertices = {
+        -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f
+};
+static constexpr GLfloat CUBE_VERTICES[] = {
         // positions          // normals           // texture coords
         -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
          0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,   // this is a modufied cube z axis is my x axis and it is modified to be less tall
@@ -146,13 +122,8 @@ std::vector<GLfloat> Geometry::GetCubeVertices()
          0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
         -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
-    };
-    return vertices;
-}
-
-std::vector<GLfloat> Geometry::GetSkyboxVertices()
-{
-    std::vector<GLfloat> skyboxVertices = {
+};
+static constexpr GLfloat SKYBOX_VERTICES[] = {
        -1.0f,  1.0f, -1.0f,
        -1.0f, -1.0f, -1.0f,
         1.0f, -1.0f, -1.0f,
@@ -194,8 +165,77 @@ std::vector<GLfloat> Geometry::GetSkyboxVertices()
         1.0f, -1.0f, -1.0f,
        -1.0f, -1.0f,  1.0f,
         1.0f, -1.0f,  1.0f
-        };
-    return skyboxVertices;
+};
+// the pyramid stores its bottom face as a quad
+static constexpr GLuint PYRAMID_INDICES[] = {
+    0, 1, 2,  3, 4, 5,  6, 7, 8,  9, 10, 11,  12, 13, 14,  12, 14, 15
+};
+
+GeometryShapeData Geometry::GetShape(GeometryShape shape)
+{
+    GeometryShapeData data = { NULL, 0, 8, NULL, 0 };
+    switch (shape)
+    {
+    case SHAPE_BOX:
+        data.vertices = BOX_VERTICES;
+        data.vertexCount = sizeof(BOX_VERTICES) / sizeof(GLfloat) / 8;
+        break;
+    case SHAPE_CUBE:
+        data.vertices = CUBE_VERTICES;
+        data.vertexCount = sizeof(CUBE_VERTICES) / sizeof(GLfloat) / 8;
+        break;
+    case SHAPE_PYRAMID:
+        data.vertices = PYRAMID_VERTICES;
+        data.vertexCount = sizeof(PYRAMID_VERTICES) / sizeof(GLfloat) / 8;
+        data.indices = PYRAMID_INDICES;
+        data.indexCount = sizeof(PYRAMID_INDICES) / sizeof(GLuint);
+        break;
+    case SHAPE_COMPASS:
+        data.vertices = COMPASS_VERTICES;
+        data.vertexCount = sizeof(COMPASS_VERTICES) / sizeof(GLfloat) / 8;
+        break;
+    case SHAPE_COMPASS2:
+        data.vertices = COMPASS2_VERTICES;
+        data.vertexCount = sizeof(COMPASS2_VERTICES) / sizeof(GLfloat) / 8;
+        break;
+    default:
+        data.vertices = SKYBOX_VERTICES;
+        data.floatsPerVertex = 3;
+        data.vertexCount = sizeof(SKYBOX_VERTICES) / sizeof(GLfloat) / 3;
+        break;
+    }
+    return data;
+}
+// function to get the box and sphere around a shape, in the space of its vertex table
+Bounds Geometry::GetShapeBounds(GeometryShape shape)
+{
+    GeometryShapeData data = GetShape(shape);
+    return ComputeBounds(data.vertices, data.vertexCount, data.floatsPerVertex);
+}
+std::vector<GLfloat> Geometry::GetBoxVertices()
+{
+    return std::vector<GLfloat>(BOX_VERTICES, BOX_VERTICES + sizeof(BOX_VERTICES) / sizeof(GLfloat));
+}
+std::vector<GLfloat> Geometry::GetPyramidVertices()
+{
+    return std::vector<GLfloat>(PYRAMID_VERTICES, PYRAMID_VERTICES + sizeof(PYRAMID_VERTICES) / sizeof(GLfloat));
+}
+std::vector<GLfloat> Geometry::GetCompassVertices()
+{
+    return std::vector<GLfloat>(COMPASS_VERTICES, COMPASS_VERTICES + sizeof(COMPASS_VERTICES) / sizeof(GLfloat));
+}
+std::vector<GLfloat> Geometry::GetCompass2Vertices()
+{
+    return std::vector<GLfloat>(COMPASS2_VERTICES, COMPASS2_VERTICES + sizeof(COMPASS2_VERTICES) / sizeof(GLfloat));
+}
+std::vector<GLfloat> Geometry::GetCubeVertices()
+{
+    return std::vector<GLfloat>(CUBE_VERTICES, CUBE_VERTICES + sizeof(CUBE_VERTICES) / sizeof(GLfloat));
+}
+
+std::vector<GLfloat> Geometry::GetSkyboxVertices()
+{
+    return std::vector<GLfloat>(SKYBOX_VERTICES, SKYBOX_VERTICES + sizeof(SKYBOX_VERTICES) / sizeof(GLfloat));
 }
 glm::vec3* Geometry::GetPointLightPositions()
 {
@@ -234,4 +274,4 @@ glm::vec3 Geometry::GetLightPos()
 {
     glm::vec3 lightPos(-2.0f, 4.0f, -1.0f);
     return lightPos;
-}
\ No newline at end of file
+}
\ No newline at end of file
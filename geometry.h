@@ -10,10 +10,35 @@
 #include "stb_image.h"
 #include"texture.h"
 #include <glm/glm.hpp>
+#include "bounds.h"
+
+// the static shapes of the scene, packed into one buffer by StaticGeometry
+enum GeometryShape
+{
+    SHAPE_BOX,
+    SHAPE_CUBE,
+    SHAPE_PYRAMID,
+    SHAPE_COMPASS,
+    SHAPE_COMPASS2,
+    SHAPE_SKYBOX,
+    SHAPE_COUNT
+};
+
+// a view of one of the constexpr vertex tables, indices is NULL for plain triangle lists
+struct GeometryShapeData
+{
+    const GLfloat* vertices;
+    unsigned int vertexCount;
+    unsigned int floatsPerVertex;
+    const GLuint* indices;
+    unsigned int indexCount;
+};
 
 class Geometry
 {
 public:
+    static GeometryShapeData GetShape(GeometryShape shape);
+    static Bounds GetShapeBounds(GeometryShape shape);
     std::vector<GLfloat> GetBoxVertices(); 
     std::vector<GLfloat> GetSkyboxVertices();
     std::vector<GLfloat> GetCubeVertices();
@@ -26,4 +51,4 @@ public:
 };
 
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
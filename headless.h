@@ -0,0 +1,26 @@
+#pragma once
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// OpenGL 3.3 core context without a window or a display, for rendering on
+// render nodes. EGL with a surfaceless display (Mesa) or the default display,
+// the scene draws into a Framebuffer instead of a window
+class HeadlessContext
+{
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    bool create();
+    void destroy();
+    bool isCreated() const;
+
+private:
+    HeadlessContext(const HeadlessContext&);
+    HeadlessContext& operator=(const HeadlessContext&);
+
+    void* display;
+    void* context;
+};
+
+#endif
@@ -1,22 +1,14 @@
 #include "icosphere.h"
-#include "shader.h"
-#ifdef _WIN32
-#include <windows.h>  
-#endif
-#ifdef __APPLE__
-#include <OpenGL/gl.h>
-#else
-#include <GL/gl.h>
-#endif
-#include<map>
+#include "renderstats.h"
+#include "jobs.h"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <functional>
 
-Icosphere::Icosphere(float radius, int sub, bool smooth) : radius(radius), subdivision(sub), smooth(smooth), interleavedStride(32)
+Icosphere::Icosphere(float radius, int sub, bool smooth) : radius(radius), subdivision(sub), smooth(smooth), interleavedStride(32),
+                                                           vaoId(0), vboId(0), iboId(0), dirty(DIRTY_ALL)
 {
     if (smooth)
         buildVerticesSmooth();
@@ -24,6 +16,11 @@ Icosphere::Icosphere(float radius, int sub, bool smooth) : radius(radius), subdi
         buildVerticesFlat();
 }
 
+Icosphere::~Icosphere()
+{
+    release();
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -33,6 +30,7 @@ void Icosphere::setRadius(float radius)
 {
     this->radius = radius;
     updateRadius(); // update vertex positions only
+    dirty |= DIRTY_VERTICES;
 }
 
 void Icosphere::setSubdivision(int iteration)
@@ -43,6 +41,7 @@ void Icosphere::setSubdivision(int iteration)
         buildVerticesSmooth();
     else
         buildVerticesFlat();
+    dirty |= DIRTY_ALL;
 }
 
 void Icosphere::setSmooth(bool smooth)
@@ -55,6 +54,7 @@ void Icosphere::setSmooth(bool smooth)
         buildVerticesSmooth();
     else
         buildVerticesFlat();
+    dirty |= DIRTY_ALL;
 }
 
 void Icosphere::reverseNormals()
@@ -82,91 +82,45 @@ void Icosphere::reverseNormals()
         indices[i] = indices[i + 2];
         indices[i + 2] = tmp;
     }
+    dirty |= DIRTY_VERTICES | DIRTY_INDICES;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // draw a icosphere in VertexArray mode
-// OpenGL RC must be set before calling it
+// OpenGL RC must be set before calling it, the caller binds the shader
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::draw() const
 {
-    //this is commented out, it is optional but not optimal for performance
-    //unsigned int icoTexture = loadTexture("resources/textures/space/2.jpg");
-    Shader lightingShader("specular2.vs", "specular2.fs");
-    Shader lightCubeShader("lightbox.vs", "lightbox.fs");
-    Shader greenShader("lightbox.vs", "lightgreen.fs");
-    glm::vec3 icoPositions[] = {
-    glm::vec3(1.0f,  1.0f, 1.0f),
-    };
-    GLuint vboId;
-    glGenBuffers(1, &vboId);
-    glBindBuffer(GL_ARRAY_BUFFER, vboId);             // for vertex data
-    glBufferData(GL_ARRAY_BUFFER, getInterleavedVertexSize(), getInterleavedVertices(), GL_STATIC_DRAW);
-    // copy index data to VBO
-    GLuint iboId;
-    glGenBuffers(1, &iboId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboId);     // for index data
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize(), getIndices(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, vboId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboId);
-
-    glEnableVertexAttribArray(0);
-    int stride = getInterleavedStride();   //  32 bytes?
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    //glActiveTexture(GL_TEXTURE0);
-    //glBindTexture(GL_TEXTURE_2D, icoTexture);
-    glDrawElements(GL_TRIANGLES, getIndexCount(), GL_UNSIGNED_INT, (void*)0);
-    glPushMatrix();
-
-    for (unsigned int i = 0; i < 1; i++)
-    {
-        float angle = 20.0;
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glm::mat4 model = glm::mat4(1.0f);
-        lightingShader.setMat4("model", model);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, icoPositions[i]);
-        model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
-        model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
-    }
-    glPopMatrix();
+    if (dirty != 0)
+        upload();
+    countedBindVertexArray(vaoId);
+    countedDrawElements(GL_TRIANGLES, getIndexCount(), GL_UNSIGNED_INT, (void*)0);
+    countedBindVertexArray(0);
 }
 
 
-void Icosphere::drawLines(const float lineColor[4]) const
-{
-    // set line colour
-    glColor4fv(lineColor);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, lineColor);
 
-    // draw lines with VA
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
-
-    glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_TEXTURE_2D);
+///////////////////////////////////////////////////////////////////////////////
+// draw the edge lines with the line indices stored after the triangles
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::drawLines() const
+{
+    if (dirty != 0)
+        upload();
+    countedBindVertexArray(vaoId);
+    countedDrawElements(GL_LINES, getLineIndexCount(), GL_UNSIGNED_INT, (void*)(std::size_t)getIndexSize());
+    countedBindVertexArray(0);
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // draw a icosphere surfaces and lines on top of it
-// the caller must set the line width before call this
+// the caller must set the line width and colour before call this
 ///////////////////////////////////////////////////////////////////////////////
-void Icosphere::drawWithLines(const float lineColor[4]) const
+void Icosphere::drawWithLines() const
 {
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(1.0, 1.0f); // move polygon backward
@@ -174,7 +128,99 @@ void Icosphere::drawWithLines(const float lineColor[4]) const
     glDisable(GL_POLYGON_OFFSET_FILL);
 
     // draw lines with VA
-    drawLines(lineColor);
+    drawLines();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// delete the VAO and buffers, the next draw creates them again
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::release()
+{
+    if (vaoId != 0)
+    {
+        glDeleteVertexArrays(1, &vaoId);
+        glDeleteBuffers(1, &vboId);
+        glDeleteBuffers(1, &iboId);
+    }
+    vaoId = vboId = iboId = 0;
+    dirty = DIRTY_ALL;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the last subdivision turned every face (i1, i2, i3) of the coarser level into
+// the 12 indices i1 newI1 newI3, newI1 i2 newI2, newI1 newI2 newI3, newI3 newI2 i3
+// where newI1 splits i1-i2, newI2 splits i2-i3 and newI3 splits i1-i3
+///////////////////////////////////////////////////////////////////////////////
+std::vector<unsigned int> Icosphere::computeParentEdges() const
+{
+    std::size_t count = getVertexCount();
+    std::vector<unsigned int> parents(count * 2);
+    for (std::size_t i = 0; i < count; ++i)
+        parents[i * 2] = parents[i * 2 + 1] = (unsigned int)i;
+    if (!smooth || subdivision < 1)
+        return parents;
+
+    std::size_t faceCount = indices.size() / 12;
+    for (std::size_t f = 0; f < faceCount; ++f)
+    {
+        const unsigned int* tri = &indices[f * 12];
+        unsigned int i1 = tri[0], i2 = tri[4], i3 = tri[11];
+        parents[tri[1] * 2] = i1;   parents[tri[1] * 2 + 1] = i2;
+        parents[tri[5] * 2] = i2;   parents[tri[5] * 2 + 1] = i3;
+        parents[tri[2] * 2] = i1;   parents[tri[2] * 2 + 1] = i3;
+    }
+    return parents;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// send what changed since the last draw: a new radius only rewrites the
+// vertex buffer, reversed normals rewrite both buffers in place and a new
+// subdivision or shading mode reallocates them
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::upload() const
+{
+    if (vaoId == 0)
+    {
+        glGenVertexArrays(1, &vaoId);
+        glGenBuffers(1, &vboId);
+        glGenBuffers(1, &iboId);
+        dirty |= DIRTY_ALL;
+    }
+
+    countedBindVertexArray(vaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, vboId);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboId);   // recorded in the vao
+    if (dirty & DIRTY_ALL)
+    {
+        countedBufferData(GL_ARRAY_BUFFER, getInterleavedVertexSize(), getInterleavedVertices(), GL_STATIC_DRAW);
+        countedBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize() + getLineIndexSize(), NULL, GL_STATIC_DRAW);
+        countedBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, getIndexSize(), getIndices());
+        countedBufferSubData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize(), getLineIndexSize(), getLineIndices());
+
+        // interleaved V/N/T, stride is 32 bytes
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, interleavedStride, (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, interleavedStride, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, interleavedStride, (void*)(6 * sizeof(float)));
+    }
+    else
+    {
+        if (dirty & DIRTY_VERTICES)
+            countedBufferSubData(GL_ARRAY_BUFFER, 0, getInterleavedVertexSize(), getInterleavedVertices());
+        if (dirty & DIRTY_INDICES)
+            countedBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, getIndexSize(), getIndices());
+    }
+    countedBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirty = 0;
 }
 
 
@@ -395,7 +441,6 @@ void Icosphere::buildVerticesSmooth()
     std::vector<float>().swap(texCoords);
     std::vector<unsigned int>().swap(indices);
     std::vector<unsigned int>().swap(lineIndices);
-    std::map<std::pair<float, float>, unsigned int>().swap(sharedIndices);
 
     float v[3];                             // vertex
     float n[3];                             // normal
@@ -480,14 +525,12 @@ void Icosphere::buildVerticesSmooth()
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 2, T_STEP);
-    sharedIndices[std::make_pair(S_STEP * 2, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[9];  v[1] = tmpVertices[10]; v[2] = tmpVertices[11]; // v15 (shared)
     Icosphere::computeVertexNormal(v, n);
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 4, T_STEP);
-    sharedIndices[std::make_pair(S_STEP * 4, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[12]; v[1] = tmpVertices[13]; v[2] = tmpVertices[14]; // v16 (shared)
     scale = Icosphere::computeScaleForLength(v, 1);
@@ -495,42 +538,36 @@ void Icosphere::buildVerticesSmooth()
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 6, T_STEP);
-    sharedIndices[std::make_pair(S_STEP * 6, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[15]; v[1] = tmpVertices[16]; v[2] = tmpVertices[17]; // v17 (shared)
     Icosphere::computeVertexNormal(v, n);
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 8, T_STEP);
-    sharedIndices[std::make_pair(S_STEP * 8, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[21]; v[1] = tmpVertices[22]; v[2] = tmpVertices[23]; // v18 (shared)
     Icosphere::computeVertexNormal(v, n);
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 3, T_STEP * 2);
-    sharedIndices[std::make_pair(S_STEP * 3, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[24]; v[1] = tmpVertices[25]; v[2] = tmpVertices[26]; // v19 (shared)
     Icosphere::computeVertexNormal(v, n);
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 5, T_STEP * 2);
-    sharedIndices[std::make_pair(S_STEP * 5, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[27]; v[1] = tmpVertices[28]; v[2] = tmpVertices[29]; // v20 (shared)
     Icosphere::computeVertexNormal(v, n);
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 7, T_STEP * 2);
-    sharedIndices[std::make_pair(S_STEP * 7, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[30]; v[1] = tmpVertices[31]; v[2] = tmpVertices[32]; // v21 (shared)
     Icosphere::computeVertexNormal(v, n);
     addVertex(v[0], v[1], v[2]);
     addNormal(n[0], n[1], n[2]);
     addTexCoord(S_STEP * 9, T_STEP * 2);
-    sharedIndices[std::make_pair(S_STEP * 9, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     // build index list for icosahedron (20 triangles)
     addIndices(0, 10, 14);      // 1st row (5 tris)
@@ -595,90 +632,104 @@ void Icosphere::buildVerticesSmooth()
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// run fn(begin, end) over [0, count) on the job system's workers. small levels
+// run on the calling thread, and so does a sphere built inside a task when the
+// workers are busy with the other levels, nothing starts threads of its own
+///////////////////////////////////////////////////////////////////////////////
+static void parallelRanges(std::size_t count, const std::function<void(std::size_t, std::size_t)>& fn)
+{
+    const std::size_t MIN_PER_TASK = 4096;
+    jobs.parallelFor(count, MIN_PER_TASK, fn);
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // divide a trinage into 4 sub triangles and repeat N times
 // If subdivision=0, do nothing.
+// every triangle is independent, so the size of each level is known up front
+// (12 vertices and 14 line indices per parent triangle) and the triangles are
+// split in parallel straight into their slots of the preallocated arrays
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::subdivideVerticesFlat()
 {
     std::vector<float> tmpVertices;
     std::vector<float> tmpTexCoords;
     std::vector<unsigned int> tmpIndices;
-    int indexCount;
-    const float* v1, * v2, * v3;          // ptr to original vertices of a triangle
-    const float* t1, * t2, * t3;          // ptr to original texcoords of a triangle
-    float newV1[3], newV2[3], newV3[3]; // new vertex positions
-    float newT1[2], newT2[2], newT3[2]; // new texture coords
-    float normal[3];                    // new face normal
-    unsigned int index = 0;             // new index value
-    int i, j;
 
     // iteration
-    for (i = 1; i <= subdivision; ++i)
+    for (int i = 1; i <= subdivision; ++i)
     {
-        // copy prev arrays
-        tmpVertices = vertices;
-        tmpTexCoords = texCoords;
-        tmpIndices = indices;
-
-        // clear prev arrays
-        vertices.clear();
-        normals.clear();
-        texCoords.clear();
-        indices.clear();
-        lineIndices.clear();
-
-        index = 0;
-        indexCount = (int)tmpIndices.size();
-        for (j = 0; j < indexCount; j += 3)
+        // keep prev arrays, the swap costs nothing
+        tmpVertices.swap(vertices);
+        tmpTexCoords.swap(texCoords);
+        tmpIndices.swap(indices);
+
+        std::size_t faceCount = tmpIndices.size() / 3;
+        vertices.resize(faceCount * 12 * 3);
+        normals.resize(faceCount * 12 * 3);
+        texCoords.resize(faceCount * 12 * 2);
+        indices.resize(faceCount * 12);
+        lineIndices.resize(faceCount * 14);
+
+        parallelRanges(faceCount, [&](std::size_t begin, std::size_t end)
         {
-            // get 3 vertice and texcoords of a triangle
-            v1 = &tmpVertices[tmpIndices[j] * 3];
-            v2 = &tmpVertices[tmpIndices[j + 1] * 3];
-            v3 = &tmpVertices[tmpIndices[j + 2] * 3];
-            t1 = &tmpTexCoords[tmpIndices[j] * 2];
-            t2 = &tmpTexCoords[tmpIndices[j + 1] * 2];
-            t3 = &tmpTexCoords[tmpIndices[j + 2] * 2];
-
-            // get 3 new vertices by spliting half on each edge
-            computeHalfVertex(v1, v2, radius, newV1);
-            computeHalfVertex(v2, v3, radius, newV2);
-            computeHalfVertex(v1, v3, radius, newV3);
-            computeHalfTexCoord(t1, t2, newT1);
-            computeHalfTexCoord(t2, t3, newT2);
-            computeHalfTexCoord(t1, t3, newT3);
-
-            // add 4 new triangles
-            addVertices(v1, newV1, newV3);
-            addTexCoords(t1, newT1, newT3);
-            computeFaceNormal(v1, newV1, newV3, normal);
-            addNormals(normal, normal, normal);
-            addIndices(index, index + 1, index + 2);
-
-            addVertices(newV1, v2, newV2);
-            addTexCoords(newT1, t2, newT2);
-            computeFaceNormal(newV1, v2, newV2, normal);
-            addNormals(normal, normal, normal);
-            addIndices(index + 3, index + 4, index + 5);
-
-            addVertices(newV1, newV2, newV3);
-            addTexCoords(newT1, newT2, newT3);
-            computeFaceNormal(newV1, newV2, newV3, normal);
-            addNormals(normal, normal, normal);
-            addIndices(index + 6, index + 7, index + 8);
-
-            addVertices(newV3, newV2, v3);
-            addTexCoords(newT3, newT2, t3);
-            computeFaceNormal(newV3, newV2, v3, normal);
-            addNormals(normal, normal, normal);
-            addIndices(index + 9, index + 10, index + 11);
-
-            // add new line indices per iteration
-            addSubLineIndices(index, index + 1, index + 4, index + 5, index + 11, index + 9); //CCW
-
-            // next index
-            index += 12;
-        }
+            const float* v[6];                  // original and new vertices of a triangle
+            const float* t[6];                  // original and new texcoords of a triangle
+            float newV[3][3], newT[3][2];       // new vertex positions and texture coords
+            // vertices of the 4 new triangles, as offsets into v/t
+            static const int TRIANGLES[12] = { 0, 3, 5,  3, 1, 4,  3, 4, 5,  5, 4, 2 };
+
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                // get 3 vertice and texcoords of a triangle
+                for (int k = 0; k < 3; ++k)
+                {
+                    v[k] = &tmpVertices[tmpIndices[f * 3 + k] * 3];
+                    t[k] = &tmpTexCoords[tmpIndices[f * 3 + k] * 2];
+                }
+
+                // get 3 new vertices by spliting half on each edge
+                computeHalfVertex(v[0], v[1], radius, newV[0]);
+                computeHalfVertex(v[1], v[2], radius, newV[1]);
+                computeHalfVertex(v[0], v[2], radius, newV[2]);
+                computeHalfTexCoord(t[0], t[1], newT[0]);
+                computeHalfTexCoord(t[1], t[2], newT[1]);
+                computeHalfTexCoord(t[0], t[2], newT[2]);
+                for (int k = 0; k < 3; ++k)
+                {
+                    v[k + 3] = newV[k];
+                    t[k + 3] = newT[k];
+                }
+
+                // add 4 new triangles
+                unsigned int index = (unsigned int)(f * 12);
+                for (int k = 0; k < 12; k += 3)
+                {
+                    float normal[3];
+                    computeFaceNormal(v[TRIANGLES[k]], v[TRIANGLES[k + 1]], v[TRIANGLES[k + 2]], normal);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        unsigned int n = index + k + c;
+                        const float* p = v[TRIANGLES[k + c]];
+                        const float* uv = t[TRIANGLES[k + c]];
+                        vertices[n * 3] = p[0];
+                        vertices[n * 3 + 1] = p[1];
+                        vertices[n * 3 + 2] = p[2];
+                        normals[n * 3] = normal[0];
+                        normals[n * 3 + 1] = normal[1];
+                        normals[n * 3 + 2] = normal[2];
+                        texCoords[n * 2] = uv[0];
+                        texCoords[n * 2 + 1] = uv[1];
+                        indices[n] = n;
+                    }
+                }
+
+                // add new line indices per iteration
+                setSubLineIndices(&lineIndices[f * 14], index, index + 1, index + 4, index + 5, index + 11, index + 9); //CCW
+            }
+        });
     }
 }
 
@@ -694,72 +745,106 @@ void Icosphere::subdivideVerticesFlat()
 //      / \ / \         //
 //    v2---*---v3       //
 //        newV2         //
+// a middle vertex is shared by the 2 triangles of an edge. edges are keyed on
+// their (smaller, larger) vertex index pair, so the texture seams, where the
+// two sides use different copies of a vertex, get a middle vertex per side.
+// edges are numbered in one serial pass over a hash table, then the middle
+// vertices and the 4 new triangles of every face are filled in parallel
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::subdivideVerticesSmooth()
 {
     std::vector<unsigned int> tmpIndices;
-    int indexCount;
-    unsigned int i1, i2, i3;            // indices from original triangle
-    const float* v1, * v2, * v3;          // ptr to original vertices of a triangle
-    const float* t1, * t2, * t3;          // ptr to original texcoords of a triangle
-    float newV1[3], newV2[3], newV3[3]; // new subdivided vertex positions
-    float newN1[3], newN2[3], newN3[3]; // new subdivided normals
-    float newT1[2], newT2[2], newT3[2]; // new subdivided texture coords
-    unsigned int newI1, newI2, newI3;   // new subdivided indices
-    int i, j;
+    std::vector<unsigned long long> edgeKeys;       // open addressing table of (i1 << 32 | i2)
+    std::vector<unsigned int> edgeIds;
+    std::vector<unsigned int> faceEdges;            // middle vertex of the 3 edges of every face
+    std::vector<unsigned int> edgeEnds;             // the 2 vertices of every edge
+    const unsigned long long EMPTY = ~0ULL;
 
     // iteration for subdivision
-    for (i = 1; i <= subdivision; ++i)
+    for (int i = 1; i <= subdivision; ++i)
     {
-        // copy prev indices
-        tmpIndices = indices;
+        // keep prev indices, the swap costs nothing
+        tmpIndices.swap(indices);
+
+        std::size_t faceCount = tmpIndices.size() / 3;
+        std::size_t vertexCount = vertices.size() / 3;
+
+        // table at least twice the largest possible edge count, as a power of 2
+        std::size_t tableSize = 1;
+        while (tableSize < faceCount * 3 * 2)
+            tableSize <<= 1;
+        edgeKeys.assign(tableSize, EMPTY);
+        edgeIds.resize(tableSize);
+        faceEdges.resize(faceCount * 3);
+        edgeEnds.resize(faceCount * 3 * 2);
+
+        // number the unique edges in face order, so the output does not depend on the threads
+        unsigned int edgeCount = 0;
+        for (std::size_t f = 0; f < faceCount; ++f)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                // the edges are v1-v2, v2-v3 and v1-v3, matching newV1, newV2 and newV3
+                unsigned int a = tmpIndices[f * 3 + (k == 2 ? 0 : k)];
+                unsigned int b = tmpIndices[f * 3 + (k == 0 ? 1 : 2)];
+                unsigned long long key = a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+                std::size_t slot = (std::size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (tableSize - 1);
+                while (edgeKeys[slot] != EMPTY && edgeKeys[slot] != key)
+                    slot = (slot + 1) & (tableSize - 1);
+                if (edgeKeys[slot] == EMPTY)
+                {
+                    edgeKeys[slot] = key;
+                    edgeIds[slot] = edgeCount;
+                    edgeEnds[edgeCount * 2] = a;
+                    edgeEnds[edgeCount * 2 + 1] = b;
+                    edgeCount++;
+                }
+                faceEdges[f * 3 + k] = (unsigned int)vertexCount + edgeIds[slot];
+            }
+        }
 
-        // clear prev arrays
-        indices.clear();
-        lineIndices.clear();
+        // exact sizes of the new level, the old vertices stay where they are
+        vertices.resize((vertexCount + edgeCount) * 3);
+        normals.resize((vertexCount + edgeCount) * 3);
+        texCoords.resize((vertexCount + edgeCount) * 2);
+        indices.resize(faceCount * 12);
+        lineIndices.resize(faceCount * 14);
 
-        indexCount = (int)tmpIndices.size();
-        for (j = 0; j < indexCount; j += 3)
+        // middle vertex of every edge
+        parallelRanges(edgeCount, [&](std::size_t begin, std::size_t end)
         {
-            // get 3 indices of each triangle
-            i1 = tmpIndices[j];
-            i2 = tmpIndices[j + 1];
-            i3 = tmpIndices[j + 2];
-
-            // get 3 vertex attribs from prev triangle
-            v1 = &vertices[i1 * 3];
-            v2 = &vertices[i2 * 3];
-            v3 = &vertices[i3 * 3];
-            t1 = &texCoords[i1 * 2];
-            t2 = &texCoords[i2 * 2];
-            t3 = &texCoords[i3 * 2];
-
-            // get 3 new vertex attribs by spliting half on each edge
-            computeHalfVertex(v1, v2, radius, newV1);
-            computeHalfVertex(v2, v3, radius, newV2);
-            computeHalfVertex(v1, v3, radius, newV3);
-            computeHalfTexCoord(t1, t2, newT1);
-            computeHalfTexCoord(t2, t3, newT2);
-            computeHalfTexCoord(t1, t3, newT3);
-            computeVertexNormal(newV1, newN1);
-            computeVertexNormal(newV2, newN2);
-            computeVertexNormal(newV3, newN3);
-
-            // add new vertices/normals/texcoords to arrays
-            // It will check if it is shared/non-shared and return index
-            newI1 = addSubVertexAttribs(newV1, newN1, newT1);
-            newI2 = addSubVertexAttribs(newV2, newN2, newT2);
-            newI3 = addSubVertexAttribs(newV3, newN3, newT3);
-
-            // add 4 new triangle indices
-            addIndices(i1, newI1, newI3);
-            addIndices(newI1, i2, newI2);
-            addIndices(newI1, newI2, newI3);
-            addIndices(newI3, newI2, i3);
-
-            // add new line indices
-            addSubLineIndices(i1, newI1, i2, newI2, i3, newI3); //CCW
-        }
+            for (std::size_t e = begin; e < end; ++e)
+            {
+                unsigned int a = edgeEnds[e * 2];
+                unsigned int b = edgeEnds[e * 2 + 1];
+                std::size_t n = vertexCount + e;
+                computeHalfVertex(&vertices[a * 3], &vertices[b * 3], radius, &vertices[n * 3]);
+                computeHalfTexCoord(&texCoords[a * 2], &texCoords[b * 2], &texCoords[n * 2]);
+                computeVertexNormal(&vertices[n * 3], &normals[n * 3]);
+            }
+        });
+
+        // 4 new triangles and 7 lines of every face
+        parallelRanges(faceCount, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                unsigned int i1 = tmpIndices[f * 3];
+                unsigned int i2 = tmpIndices[f * 3 + 1];
+                unsigned int i3 = tmpIndices[f * 3 + 2];
+                unsigned int newI1 = faceEdges[f * 3];
+                unsigned int newI2 = faceEdges[f * 3 + 1];
+                unsigned int newI3 = faceEdges[f * 3 + 2];
+
+                unsigned int* tri = &indices[f * 12];
+                tri[0] = i1;     tri[1] = newI1;  tri[2] = newI3;
+                tri[3] = newI1;  tri[4] = i2;     tri[5] = newI2;
+                tri[6] = newI1;  tri[7] = newI2;  tri[8] = newI3;
+                tri[9] = newI3;  tri[10] = newI2; tri[11] = i3;
+
+                setSubLineIndices(&lineIndices[f * 14], i1, newI1, i2, newI2, i3, newI3); //CCW
+            }
+        });
     }
 }
 
@@ -771,23 +856,26 @@ void Icosphere::subdivideVerticesSmooth()
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::buildInterleavedVertices()
 {
-    std::vector<float>().swap(interleavedVertices);
+    std::size_t count = vertices.size() / 3;
+    interleavedVertices.resize(count * 8);
 
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for (i = 0, j = 0; i < count; i += 3, j += 2)
+    parallelRanges(count, [&](std::size_t begin, std::size_t end)
     {
-        interleavedVertices.push_back(vertices[i]);
-        interleavedVertices.push_back(vertices[i + 1]);
-        interleavedVertices.push_back(vertices[i + 2]);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            float* v = &interleavedVertices[i * 8];
+            v[0] = vertices[i * 3];
+            v[1] = vertices[i * 3 + 1];
+            v[2] = vertices[i * 3 + 2];
 
-        interleavedVertices.push_back(normals[i]);
-        interleavedVertices.push_back(normals[i + 1]);
-        interleavedVertices.push_back(normals[i + 2]);
+            v[3] = normals[i * 3];
+            v[4] = normals[i * 3 + 1];
+            v[5] = normals[i * 3 + 2];
 
-        interleavedVertices.push_back(texCoords[j]);
-        interleavedVertices.push_back(texCoords[j + 1]);
-    }
+            v[6] = texCoords[i * 2];
+            v[7] = texCoords[i * 2 + 1];
+        }
+    });
 }
 
 
@@ -891,78 +979,35 @@ void Icosphere::addIndices(unsigned int i1, unsigned int i2, unsigned int i3)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add 7 sub edge lines per triangle to array using 6 indices (CCW)
+// write 7 sub edge lines of a triangle using 6 indices (CCW)
 //     i1                                           //
 //     /            : (i1, i2)                      //
 //   i2---i6        : (i2, i6)                      //
 //   / \  /         : (i2, i3), (i2, i4), (i6, i4)  //
 // i3---i4---i5     : (i3, i4), (i4, i5)            //
 ///////////////////////////////////////////////////////////////////////////////
-void Icosphere::addSubLineIndices(unsigned int i1,
+void Icosphere::setSubLineIndices(unsigned int* lines,
+    unsigned int i1,
     unsigned int i2,
     unsigned int i3,
     unsigned int i4,
     unsigned int i5,
     unsigned int i6)
 {
-    lineIndices.push_back(i1);      // i1 - i2
-    lineIndices.push_back(i2);
-    lineIndices.push_back(i2);      // i2 - i6
-    lineIndices.push_back(i6);
-    lineIndices.push_back(i2);      // i2 - i3
-    lineIndices.push_back(i3);
-    lineIndices.push_back(i2);      // i2 - i4
-    lineIndices.push_back(i4);
-    lineIndices.push_back(i6);      // i6 - i4
-    lineIndices.push_back(i4);
-    lineIndices.push_back(i3);      // i3 - i4
-    lineIndices.push_back(i4);
-    lineIndices.push_back(i4);      // i4 - i5
-    lineIndices.push_back(i5);
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// add a subdivided vertex attribs (vertex, normal, texCoord) to arrays, then
-// return its index value
-// If it is a shared vertex, remember its index, so it can be re-used
-///////////////////////////////////////////////////////////////////////////////
-unsigned int Icosphere::addSubVertexAttribs(const float v[3], const float n[3], const float t[2])
-{
-    unsigned int index;     // return value;
-
-    // check if is shared vertex or not first
-    if (Icosphere::isSharedTexCoord(t))
-    {
-        // find if it does already exist in sharedIndices map using (s,t) key
-        // if not in the list, add the vertex attribs to arrays and return its index
-        // if exists, return the current index
-        std::pair<float, float> key = std::make_pair(t[0], t[1]);
-        std::map<std::pair<float, float>, unsigned int>::iterator iter = sharedIndices.find(key);
-        if (iter == sharedIndices.end())
-        {
-            addVertex(v[0], v[1], v[2]);
-            addNormal(n[0], n[1], n[2]);
-            addTexCoord(t[0], t[1]);
-            index = texCoords.size() / 2 - 1;
-            sharedIndices[key] = index;
-        }
-        else
-        {
-            index = iter->second;
-        }
-    }
-    // not shared
-    else
-    {
-        addVertex(v[0], v[1], v[2]);
-        addNormal(n[0], n[1], n[2]);
-        addTexCoord(t[0], t[1]);
-        index = texCoords.size() / 2 - 1;
-    }
-
-    return index;
+    lines[0] = i1;      // i1 - i2
+    lines[1] = i2;
+    lines[2] = i2;      // i2 - i6
+    lines[3] = i6;
+    lines[4] = i2;      // i2 - i3
+    lines[5] = i3;
+    lines[6] = i2;      // i2 - i4
+    lines[7] = i4;
+    lines[8] = i6;      // i6 - i4
+    lines[9] = i4;
+    lines[10] = i3;     // i3 - i4
+    lines[11] = i4;
+    lines[12] = i4;     // i4 - i5
+    lines[13] = i5;
 }
 
 
@@ -1058,79 +1103,3 @@ void Icosphere::computeHalfTexCoord(const float t1[2], const float t2[2], float
     newT[0] = (t1[0] + t2[0]) * 0.5f;
     newT[1] = (t1[1] + t2[1]) * 0.5f;
 }
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// This function used 20 non-shared line segments to determine if the given
-// texture coordinate is shared or no. If it is on the line segments, it is also
-// non-shared point
-//   00  01  02  03  04         //
-//   /\  /\  /\  /\  /\         //
-//  /  \/  \/  \/  \/  \        //
-// 05  06  07  08  09   \       //
-//   \   10  11  12  13  14     //
-//    \  /\  /\  /\  /\  /      //
-//     \/  \/  \/  \/  \/       //
-//      15  16  17  18  19      //
-///////////////////////////////////////////////////////////////////////////////
-bool Icosphere::isSharedTexCoord(const float t[2])
-{
-    // 20 non-shared line segments
-    const float S = 1.0f / 11;  // texture steps
-    const float T = 1.0f / 3;
-    static float segments[] = { S, 0,       0, T,       // 00 - 05
-                                S, 0,       S * 2, T,     // 00 - 06
-                                S * 3, 0,     S * 2, T,     // 01 - 06
-                                S * 3, 0,     S * 4, T,     // 01 - 07
-                                S * 5, 0,     S * 4, T,     // 02 - 07
-                                S * 5, 0,     S * 6, T,     // 02 - 08
-                                S * 7, 0,     S * 6, T,     // 03 - 08
-                                S * 7, 0,     S * 8, T,     // 03 - 09
-                                S * 9, 0,     S * 8, T,     // 04 - 09
-                                S * 9, 0,     1, T * 2,     // 04 - 14
-                                0, T,       S * 2, 1,     // 05 - 15
-                                S * 3, T * 2,   S * 2, 1,     // 10 - 15
-                                S * 3, T * 2,   S * 4, 1,     // 10 - 16
-                                S * 5, T * 2,   S * 4, 1,     // 11 - 16
-                                S * 5, T * 2,   S * 6, 1,     // 11 - 17
-                                S * 7, T * 2,   S * 6, 1,     // 12 - 17
-                                S * 7, T * 2,   S * 8, 1,     // 12 - 18
-                                S * 9, T * 2,   S * 8, 1,     // 13 - 18
-                                S * 9, T * 2,   S * 10, 1,    // 13 - 19
-                                1, T * 2,     S * 10, 1 };  // 14 - 19
-
-    // check the point with all 20 line segments
-    // if it is on the line segment, it is non-shared
-    int count = (int)(sizeof(segments) / sizeof(segments[0]));
-    for (int i = 0, j = 2; i < count; i += 4, j += 4)
-    {
-        if (Icosphere::isOnLineSegment(&segments[i], &segments[j], t))
-            return false;   // not shared
-    }
-
-    return true;
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// determine a point c is on the line segment a-b
-///////////////////////////////////////////////////////////////////////////////
-bool Icosphere::isOnLineSegment(const float a[2], const float b[2], const float c[2])
-{
-    const float EPSILON = 0.0001f;
-
-    // cross product must be 0 if c is on the line
-    float cross = ((b[0] - a[0]) * (c[1] - a[1])) - ((b[1] - a[1]) * (c[0] - a[0]));
-    if (cross > EPSILON || cross < -EPSILON)
-        return false;
-
-    // c must be within a-b
-    if ((c[0] > a[0] && c[0] > b[0]) || (c[0] < a[0] && c[0] < b[0]))
-        return false;
-    if ((c[1] > a[1] && c[1] > b[1]) || (c[1] < a[1] && c[1] < b[1]))
-        return false;
-
-    return true;    // all passed, it is on the line segment
-}
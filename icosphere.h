@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+// Icosphere.h
+// ===========
+// Polyhedron subdividing icosahedron (20 tris) by N-times iteration
+// The icosphere with N=1 (default) has 80 triangles by subdividing a triangle
+// of icosahedron into 4 triangles. If N=0, it is identical to icosahedron.
+//
+// the sphere owns its VAO/VBO/IBO. they are uploaded on the first draw and
+// again only when a setter changed the arrays, so a draw is a bind plus one
+// indexed draw
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#ifndef ICOSPHERE_H
+#define ICOSPHERE_H
+
+#include <glad/glad.h>
+#include <vector>
+#include "bounds.h"
+
+class Icosphere
+{
+public:
+    // ctor/dtor
+    Icosphere(float radius = 1.0f, int subdivision = 1, bool smooth = false);
+    ~Icosphere();
+
+    // the GL objects are owned, so an icosphere is not copied
+    Icosphere(const Icosphere&) = delete;
+    Icosphere& operator=(const Icosphere&) = delete;
+
+    // getters/setters
+    float getRadius() const { return radius; }
+    void setRadius(float radius);
+    int getSubdivision() const { return subdivision; }
+    void setSubdivision(int subdivision);
+    bool getSmooth() const { return smooth; }
+    void setSmooth(bool smooth);
+    void reverseNormals();
+
+    // for vertex data
+    unsigned int getVertexCount() const { return (unsigned int)vertices.size() / 3; }
+    Bounds getBounds() const { return ComputeBounds(vertices.data(), getVertexCount(), 3); }
+    unsigned int getNormalCount() const { return (unsigned int)normals.size() / 3; }
+    unsigned int getTexCoordCount() const { return (unsigned int)texCoords.size() / 2; }
+    unsigned int getIndexCount() const { return (unsigned int)indices.size(); }
+    unsigned int getLineIndexCount() const { return (unsigned int)lineIndices.size(); }
+    unsigned int getTriangleCount() const { return getIndexCount() / 3; }
+    unsigned int getVertexSize() const { return (unsigned int)vertices.size() * sizeof(float); }
+    unsigned int getNormalSize() const { return (unsigned int)normals.size() * sizeof(float); }
+    unsigned int getTexCoordSize() const { return (unsigned int)texCoords.size() * sizeof(float); }
+    unsigned int getIndexSize() const { return (unsigned int)indices.size() * sizeof(unsigned int); }
+    unsigned int getLineIndexSize() const { return (unsigned int)lineIndices.size() * sizeof(unsigned int); }
+    const float* getVertices() const { return vertices.data(); }
+    const float* getNormals() const { return normals.data(); }
+    const float* getTexCoords() const { return texCoords.data(); }
+    const unsigned int* getIndices() const { return indices.data(); }
+    const unsigned int* getLineIndices() const { return lineIndices.data(); }
+    // for geomorphing: the two ends of the edge the last subdivision split to make each
+    // vertex, or the vertex twice when the coarser level already had it. smooth spheres
+    // only (a flat one gets every vertex as its own parent), before reverseNormals
+    std::vector<unsigned int> computeParentEdges() const;
+
+    // for interleaved vertices: V/N/T
+    unsigned int getInterleavedVertexCount() const { return getVertexCount(); }    // # of vertices
+    unsigned int getInterleavedVertexSize() const { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
+    int getInterleavedStride() const { return interleavedStride; }   // should be 32 bytes
+    const float* getInterleavedVertices() const { return interleavedVertices.data(); }
+
+    // draw in VertexArray mode with the shader bound by the caller
+    void draw() const;                                  // draw surface
+    void drawLines() const;                             // draw lines only
+    void drawWithLines() const;                         // draw surface and lines
+    void release();                                     // delete the GL objects
+
+private:
+    // what the next draw has to send to GL
+    enum DirtyFlags
+    {
+        DIRTY_VERTICES = 1,     // same vertex count, new values
+        DIRTY_INDICES = 2,      // same index count, new values
+        DIRTY_ALL = 4           // new sizes, buffers are reallocated
+    };
+
+    // static functions
+    static void computeFaceNormal(const float v1[3], const float v2[3], const float v3[3], float normal[3]);
+    static void computeVertexNormal(const float v[3], float normal[3]);
+    static float computeScaleForLength(const float v[3], float length);
+    static void computeHalfVertex(const float v1[3], const float v2[3], float length, float newV[3]);
+    static void computeHalfTexCoord(const float t1[2], const float t2[2], float newT[2]);
+    static void setSubLineIndices(unsigned int* lines, unsigned int i1, unsigned int i2, unsigned int i3,
+                                  unsigned int i4, unsigned int i5, unsigned int i6);
+
+    // member functions
+    void updateRadius();
+    std::vector<float> computeIcosahedronVertices();
+    void buildVerticesFlat();
+    void buildVerticesSmooth();
+    void subdivideVerticesFlat();
+    void subdivideVerticesSmooth();
+    void buildInterleavedVertices();
+    void addVertex(float x, float y, float z);
+    void addVertices(const float v1[3], const float v2[3], const float v3[3]);
+    void addNormal(float nx, float ny, float nz);
+    void addNormals(const float n1[3], const float n2[3], const float n3[3]);
+    void addTexCoord(float s, float t);
+    void addTexCoords(const float t1[2], const float t2[2], const float t3[2]);
+    void addIndices(unsigned int i1, unsigned int i2, unsigned int i3);
+    void upload() const;
+
+    // memeber vars
+    float radius;                           // circumscribed radius
+    int subdivision;
+    bool smooth;
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> lineIndices;
+
+    // interleaved
+    std::vector<float> interleavedVertices;
+    int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
+
+    // GL objects, created and refreshed lazily by draw() so the sphere can be built without a context.
+    // the IBO holds the triangle indices followed by the line indices
+    mutable GLuint vaoId, vboId, iboId;
+    mutable unsigned int dirty;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "jobs.h"
+
+#include <algorithm>
+
+JobSystem jobs;
+
+// index of the calling thread's queue, -1 for threads that do not own one
+static thread_local int queueIndex = -1;
+// how many background tasks the calling thread is inside of
+static thread_local int backgroundDepth = 0;
+
+TaskGraph::TaskGraph() : remaining(0)
+{
+
+}
+
+TaskId TaskGraph::add(const std::function<void()>& fn, unsigned int flags)
+{
+    tasks.emplace_back();
+    Task& task = tasks.back();
+    task.fn = fn;
+    task.flags = flags;
+    task.dependencies = 0;
+    task.waiting = 0;
+    task.graph = this;
+    return (TaskId)(tasks.size() - 1);
+}
+
+void TaskGraph::depend(TaskId task, TaskId before)
+{
+    tasks[before].dependents.push_back(task);
+    tasks[task].dependencies++;
+}
+
+std::size_t TaskGraph::size() const
+{
+    return tasks.size();
+}
+
+void TaskGraph::clear()
+{
+    tasks.clear();
+}
+
+JobSystem::JobSystem() : queued(0), stopping(false), mainThread(std::this_thread::get_id())
+{
+    queues.emplace_back();
+}
+
+JobSystem::~JobSystem()
+{
+    shutdown();
+}
+
+void JobSystem::init(unsigned int workerCount)
+{
+    shutdown();
+    if (workerCount == 0)
+    {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+    mainThread = std::this_thread::get_id();
+    queueIndex = 0;
+    stopping = false;
+    while (queues.size() < workerCount + 1)
+        queues.emplace_back();
+    for (unsigned int i = 0; i < workerCount; i++)
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i + 1));
+}
+
+void JobSystem::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+    while (queues.size() > 1)
+        queues.pop_back();
+}
+
+unsigned int JobSystem::getWorkerCount() const
+{
+    return (unsigned int)workers.size();
+}
+// function to run a graph to the end
+void JobSystem::run(TaskGraph& graph)
+{
+    if (graph.tasks.empty())
+        return;
+    queueGraph(graph);
+    // inside a background task the wait may run other background tasks, it holds up nothing
+    waitFor(graph.remaining, backgroundDepth > 0);
+}
+
+void JobSystem::start(TaskGraph& graph)
+{
+    if (workers.empty())
+    {
+        run(graph);
+        return;
+    }
+    if (!graph.tasks.empty())
+        queueGraph(graph);
+}
+
+bool JobSystem::finished(const TaskGraph& graph) const
+{
+    return graph.remaining.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::wait(TaskGraph& graph)
+{
+    waitFor(graph.remaining, true);
+}
+
+void JobSystem::parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& fn)
+{
+    if (count == 0)
+        return;
+    // a few ranges per thread, so the stealing evens out ranges that take longer
+    std::size_t maxRanges = (workers.size() + 1) * 4;
+    grain = std::max<std::size_t>(grain, 1);
+    if ((count + grain - 1) / grain > maxRanges)
+        grain = (count + maxRanges - 1) / maxRanges;
+    if (workers.empty() || grain >= count)
+    {
+        fn(0, count);
+        return;
+    }
+
+    TaskGraph graph;
+    for (std::size_t begin = 0; begin < count; begin += grain)
+    {
+        std::size_t end = std::min(begin + grain, count);
+        graph.add([&fn, begin, end]() { fn(begin, end); });
+    }
+    run(graph);
+}
+
+// function to queue the tasks of a graph that wait for nothing. every waiting counter is
+// set before the first task is queued, a finishing task may already release its dependents
+void JobSystem::queueGraph(TaskGraph& graph)
+{
+    graph.remaining = graph.tasks.size();
+    for (std::size_t i = 0; i < graph.tasks.size(); i++)
+        graph.tasks[i].waiting = graph.tasks[i].dependencies;
+    for (std::size_t i = 0; i < graph.tasks.size(); i++)
+    {
+        if (graph.tasks[i].dependencies == 0)
+            push(&graph.tasks[i]);
+    }
+}
+
+void JobSystem::push(Task* task)
+{
+    if (task->flags & TASK_MAIN_THREAD)
+    {
+        std::lock_guard<std::mutex> lock(mainQueue.mutex);
+        mainQueue.tasks.push_back(task);
+        return;
+    }
+    if (backgroundDepth > 0)
+        task->flags |= TASK_BACKGROUND;
+    Queue& queue = (task->flags & TASK_BACKGROUND) ? backgroundQueue
+        : queues[queueIndex >= 0 && queueIndex < (int)queues.size() ? queueIndex : 0];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    queued++;
+    if (!workers.empty())
+    {
+        // taking the lock orders the push before a worker's check of queued
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+// function to take a task for the calling thread: main thread tasks first (on the main
+// thread), then the newest of its own queue, then the oldest of another queue and, with
+// background set, the oldest background task
+JobSystem::Task* JobSystem::find(bool background)
+{
+    if (std::this_thread::get_id() == mainThread)
+    {
+        std::lock_guard<std::mutex> lock(mainQueue.mutex);
+        if (!mainQueue.tasks.empty())
+        {
+            Task* task = mainQueue.tasks.front();
+            mainQueue.tasks.pop_front();
+            return task;
+        }
+    }
+
+    int own = queueIndex >= 0 && queueIndex < (int)queues.size() ? queueIndex : -1;
+    if (own >= 0)
+    {
+        Queue& queue = queues[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            Task* task = queue.tasks.back();
+            queue.tasks.pop_back();
+            queued--;
+            return task;
+        }
+    }
+    std::size_t count = queues.size();
+    std::size_t start = own >= 0 ? own + 1 : 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        Queue& victim = queues[(start + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            Task* task = victim.tasks.front();
+            victim.tasks.pop_front();
+            queued--;
+            return task;
+        }
+    }
+    if (background)
+    {
+        std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+        if (!backgroundQueue.tasks.empty())
+        {
+            Task* task = backgroundQueue.tasks.front();
+            backgroundQueue.tasks.pop_front();
+            queued--;
+            return task;
+        }
+    }
+    return NULL;
+}
+// function to run a task and release what waited for it. the graph may be gone as soon
+// as remaining reaches 0, so that is the last thing touched
+void JobSystem::execute(Task* task)
+{
+    bool background = (task->flags & TASK_BACKGROUND) != 0;
+    if (background)
+        backgroundDepth++;
+    task->fn();
+    if (background)
+        backgroundDepth--;
+    TaskGraph* graph = task->graph;
+    for (std::size_t i = 0; i < task->dependents.size(); i++)
+    {
+        Task* dependent = &graph->tasks[task->dependents[i]];
+        if (dependent->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            push(dependent);
+    }
+    graph->remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::waitFor(const std::atomic<std::size_t>& remaining, bool background)
+{
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        Task* task = find(background);
+        if (task != NULL)
+            execute(task);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    queueIndex = (int)index;
+    while (!stopping)
+    {
+        Task* task = find(true);
+        if (task != NULL)
+        {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return queued > 0 || stopping; });
+    }
+}
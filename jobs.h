@@ -0,0 +1,120 @@
+#pragma once
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// tasks with this flag only run on the main thread, the one that owns the GL context
+const unsigned int TASK_MAIN_THREAD = 1;
+// tasks with this flag (loading, cooking) run on the workers when they have nothing else
+// to do. a thread waiting on run() or parallelFor() leaves them alone, so a frame's
+// parallel work never waits behind one; only wait() on their own graph helps with them.
+// the tasks a background task queues are background tasks too
+const unsigned int TASK_BACKGROUND = 2;
+
+typedef unsigned int TaskId;
+
+// a set of tasks and the order between them, run as a whole by JobSystem::run.
+// a task starts once every task it depends on has finished
+class TaskGraph
+{
+public:
+    TaskGraph();
+
+    TaskId add(const std::function<void()>& fn, unsigned int flags = 0);
+    // function to make task wait until before has finished
+    void depend(TaskId task, TaskId before);
+    std::size_t size() const;
+    void clear();
+
+private:
+    TaskGraph(const TaskGraph&);
+    TaskGraph& operator=(const TaskGraph&);
+
+    friend class JobSystem;
+
+    struct Task
+    {
+        std::function<void()> fn;
+        unsigned int flags;
+        unsigned int dependencies;          // tasks this one waits for
+        std::atomic<unsigned int> waiting;  // of those, still running
+        std::vector<TaskId> dependents;
+        TaskGraph* graph;
+    };
+
+    // a deque, so the tasks (and their atomics) never move while the graph grows
+    std::deque<Task> tasks;
+    std::atomic<std::size_t> remaining;
+};
+
+// runs tasks on one worker thread per extra core. every worker takes the newest task
+// from its own queue and, when that is empty, steals the oldest from another one, and
+// only then the oldest TASK_BACKGROUND task; tasks queued while running a task go to the
+// queue of the thread running it. a thread waiting on run() or parallelFor() runs tasks
+// itself instead of blocking, the main thread also the TASK_MAIN_THREAD ones, so graphs
+// with GL tasks are run from the main thread.
+// without init() (or on one core) everything runs on the calling thread
+class JobSystem
+{
+public:
+    JobSystem();
+    ~JobSystem();
+
+    // function to start the workers, by default one less than the hardware threads.
+    // the calling thread becomes the main thread
+    void init(unsigned int workerCount = 0);
+    void shutdown();
+    unsigned int getWorkerCount() const;
+
+    void run(TaskGraph& graph);
+    // function to queue a graph's tasks and return, without workers it runs the graph at once.
+    // the graph must live until finished(). TASK_MAIN_THREAD tasks wait for a run() or wait()
+    void start(TaskGraph& graph);
+    bool finished(const TaskGraph& graph) const;
+    // function to run tasks on the calling thread until a started graph has finished,
+    // background ones included
+    void wait(TaskGraph& graph);
+    // function to call fn(begin, end) over [0, count) in ranges of about grain items
+    void parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& fn);
+
+private:
+    JobSystem(const JobSystem&);
+    JobSystem& operator=(const JobSystem&);
+
+    typedef TaskGraph::Task Task;
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+    };
+
+    void queueGraph(TaskGraph& graph);
+    void push(Task* task);
+    Task* find(bool background);
+    void execute(Task* task);
+    void waitFor(const std::atomic<std::size_t>& remaining, bool background);
+    void workerLoop(unsigned int index);
+
+    std::deque<Queue> queues;           // 0 belongs to the main thread, i + 1 to worker i
+    Queue mainQueue;                    // TASK_MAIN_THREAD tasks
+    Queue backgroundQueue;              // TASK_BACKGROUND tasks, oldest first
+    std::vector<std::thread> workers;
+    std::atomic<int> queued;            // tasks in queues, workers sleep while it is 0
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping;
+    std::thread::id mainThread;
+};
+
+extern JobSystem jobs;
+
+#endif
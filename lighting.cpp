@@ -0,0 +1,78 @@
+#include "lighting.h"
+#include "renderstats.h"
+#include <cstring>
+
+LightingBlock::LightingBlock() : UBO(0), dirtyBegin(0), dirtyEnd(0)
+{
+    memset((void*)&data, 0, sizeof(data));
+}
+// function to create the uniform buffer and attach it to its binding point
+void LightingBlock::init()
+{
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    countedBufferData(GL_UNIFORM_BUFFER, sizeof(LightingStd140), &data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferRange(GL_UNIFORM_BUFFER, LIGHTING_BINDING, UBO, 0, sizeof(LightingStd140));
+    dirtyBegin = dirtyEnd = 0;
+}
+// function to point the Lighting block of a program at the shared buffer
+void LightingBlock::bind(GLuint program) const
+{
+    GLuint blockIndex = glGetUniformBlockIndex(program, "Lighting");
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, blockIndex, LIGHTING_BINDING);
+}
+
+void LightingBlock::setViewPos(const glm::vec3& viewPos)
+{
+    if (data.viewPos == viewPos)
+        return;
+    data.viewPos = viewPos;
+    markDirty(offsetof(LightingStd140, viewPos), sizeof(glm::vec3));
+}
+
+void LightingBlock::setSpotLight(const glm::vec3& position, const glm::vec3& direction)
+{
+    if (data.spotLight.position == position && data.spotLight.direction == direction)
+        return;
+    data.spotLight.position = position;
+    data.spotLight.direction = direction;
+    markDirty(offsetof(LightingStd140, spotLight), offsetof(SpotLightStd140, cutOff));
+}
+// function to grow the range of bytes sent by the next upload
+void LightingBlock::markDirty(std::size_t offset, std::size_t size)
+{
+    if (dirtyBegin == dirtyEnd)
+    {
+        dirtyBegin = offset;
+        dirtyEnd = offset + size;
+        return;
+    }
+    if (offset < dirtyBegin)
+        dirtyBegin = offset;
+    if (offset + size > dirtyEnd)
+        dirtyEnd = offset + size;
+}
+
+void LightingBlock::markAllDirty()
+{
+    markDirty(0, sizeof(LightingStd140));
+}
+// function to send the dirty range with a single glBufferSubData
+void LightingBlock::upload()
+{
+    if (dirtyBegin == dirtyEnd)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    countedBufferSubData(GL_UNIFORM_BUFFER, dirtyBegin, dirtyEnd - dirtyBegin, (const char*)&data + dirtyBegin);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void LightingBlock::clear()
+{
+    if (UBO != 0)
+        glDeleteBuffers(1, &UBO);
+    UBO = 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+
+#define NR_POINT_LIGHTS 4
+
+// uniform buffer binding of the Lighting block in specular.fs (Matrices uses 0)
+const GLuint LIGHTING_BINDING = 1;
+
+// c++ mirrors of the std140 structs in specular.fs, the padding floats
+// line every vec3 up on 16 bytes the way std140 lays them out
+struct DirLightStd140
+{
+    glm::vec3 direction;    float pad0;
+    glm::vec3 ambient;      float pad1;
+    glm::vec3 diffuse;      float pad2;
+    glm::vec3 specular;     float pad3;
+};
+
+struct PointLightStd140
+{
+    glm::vec3 position;
+    float constant;
+    float linear;
+    float quadratic;        float pad0[2];
+    glm::vec3 ambient;      float pad1;
+    glm::vec3 diffuse;      float pad2;
+    glm::vec3 specular;     float pad3;
+};
+
+struct SpotLightStd140
+{
+    glm::vec3 position;     float pad0;
+    glm::vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    glm::vec3 ambient;      float pad1;
+    glm::vec3 diffuse;      float pad2;
+    glm::vec3 specular;     float pad3;
+};
+
+// the values that follow the camera come first so the per frame update is one small range
+struct LightingStd140
+{
+    glm::vec3 viewPos;      float pad0;
+    SpotLightStd140 spotLight;
+    DirLightStd140 dirLight;
+    PointLightStd140 pointLights[NR_POINT_LIGHTS];
+};
+
+static_assert(sizeof(DirLightStd140) == 64, "DirLight must match std140");
+static_assert(sizeof(PointLightStd140) == 80, "PointLight must match std140");
+static_assert(sizeof(SpotLightStd140) == 96, "SpotLight must match std140");
+static_assert(offsetof(LightingStd140, dirLight) == 112, "Lighting block must match std140");
+static_assert(sizeof(LightingStd140) == 496, "Lighting block must match std140");
+
+// one uniform buffer with the lighting of the scene, shared by every lit program.
+// setters only mark the bytes they change and upload() sends the dirty range
+class LightingBlock
+{
+public:
+    LightingStd140 data;
+
+    LightingBlock();
+    void init();
+    void bind(GLuint program) const;
+    void setViewPos(const glm::vec3& viewPos);
+    void setSpotLight(const glm::vec3& position, const glm::vec3& direction);
+    void markDirty(std::size_t offset, std::size_t size);
+    void markAllDirty();
+    void upload();
+    void clear();
+
+private:
+    GLuint UBO;
+    std::size_t dirtyBegin, dirtyEnd;
+};
+
+#endif
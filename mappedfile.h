@@ -0,0 +1,37 @@
+#pragma once
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// read only mapping of a whole file, unmapped when it goes out of scope
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // function to map path, false when it cannot be opened. an empty file maps to NULL data
+    bool open(const std::string& path);
+    void close();
+
+    const char* data;
+    std::size_t size;
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+#endif
@@ -7,6 +7,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.h"
+#include "renderstats.h"
+#include "bounds.h"
 
 #include <string>
 #include <vector>
@@ -54,20 +56,69 @@ public:
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
+        buildSamplerNames();
     }
 
     // render the mesh
     void Draw(Shader &shader) 
     {
-        // bind appropriate textures
+        // the sampler locations are looked up once per program, after that a draw
+        // only sets the units and binds the textures
+        if (samplerProgram != shader.ID)
+            resolveSamplers(shader.ID);
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit
+            countedUniform1i(samplerLocations[i], i);
+            // and finally bind the texture
+            countedBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+        
+        // draw mesh
+        countedBindVertexArray(VAO);
+        countedDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        countedBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // delete the vao and the buffers, the mesh can't be drawn after this
+    void release()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+
+    // box and sphere around the vertex positions, in model space
+    Bounds getBounds() const
+    {
+        return ComputeBounds(vertices.empty() ? NULL : &vertices[0].Position.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+
+private:
+    // render data 
+    unsigned int VBO, EBO;
+    // sampler name of each texture (texture_diffuseN ...), built once at load time
+    vector<string> samplerNames;
+    vector<GLint>  samplerLocations;
+    unsigned int   samplerProgram = 0;
+
+    // builds the sampler name of every texture, the N in texture_diffuseN counts per type
+    void buildSamplerNames()
+    {
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        samplerNames.resize(textures.size());
+        samplerLocations.resize(textures.size());
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
+            // retrieve texture number (the N in texture_diffuseN)
             string number;
             string name = textures[i].type;
             if(name == "texture_diffuse")
@@ -78,25 +129,17 @@ public:
                 number = std::to_string(normalNr++); // transfer unsigned int to string
              else if(name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            samplerNames[i] = name + number;
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
+    // looks the sampler locations up for a program, only when the program changes
+    void resolveSamplers(unsigned int program)
+    {
+        for(unsigned int i = 0; i < samplerNames.size(); i++)
+            samplerLocations[i] = glGetUniformLocation(program, samplerNames[i].c_str());
+        samplerProgram = program;
+    }
 
     // initializes all the buffer objects/arrays
     void setupMesh()
@@ -106,16 +149,16 @@ private:
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        countedBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        countedBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        countedBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -140,7 +183,7 @@ private:
 		// weights
 		glEnableVertexAttribArray(6);
 		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        countedBindVertexArray(0);
     }
 };
 #endif
@@ -0,0 +1,227 @@
+#include "meshregistry.h"
+#include "renderstats.h"
+
+MeshRegistry::MeshRegistry() : boundVAO(0)
+{
+
+}
+
+MeshRegistry::~MeshRegistry()
+{
+    clear();
+}
+// function to register a non-indexed mesh, the vertex count is taken from the buffer size
+MeshHandle MeshRegistry::addArrays(const GLfloat* vertices, GLsizeiptr size, VertexLayout layout, GLenum mode)
+{
+    return upload(vertices, size, NULL, 0, layout, mode);
+}
+// function to register an indexed mesh
+MeshHandle MeshRegistry::addIndexed(const GLfloat* vertices, GLsizeiptr size, const GLuint* indices, GLsizei indexCount,
+                                    VertexLayout layout, GLenum mode)
+{
+    return upload(vertices, size, indices, indexCount, layout, mode);
+}
+// function to register a range of an indexed mesh, drawn from the parent's VAO with a base vertex
+MeshHandle MeshRegistry::addSubMesh(MeshHandle parent, GLuint firstIndex, GLsizei indexCount, GLint baseVertex, GLenum mode)
+{
+    MeshEntry mesh = meshes[parent];
+    mesh.mode = mode;
+    mesh.count = indexCount;
+    mesh.firstIndex = firstIndex;
+    mesh.baseVertex = baseVertex;
+    mesh.ownsBuffers = false;
+    meshes.push_back(mesh);
+    return (MeshHandle)(meshes.size() - 1);
+}
+// function to replace the vertices and indices of an indexed mesh, its layout and mode stay the same
+void MeshRegistry::update(MeshHandle handle, const GLfloat* vertices, GLsizeiptr size, const GLuint* indices, GLsizei indexCount)
+{
+    MeshEntry& mesh = meshes[handle];
+    bind(mesh.VAO);     // the element buffer binding is part of the vao
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    countedBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    countedBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mesh.count = indexCount;
+}
+// function to draw a registered mesh, no buffers are created here
+void MeshRegistry::draw(MeshHandle handle) const
+{
+    const MeshEntry& mesh = meshes[handle];
+    bind(mesh.VAO);
+    if (mesh.EBO != 0)
+        countedDrawElementsBaseVertex(mesh.mode, mesh.count, GL_UNSIGNED_INT,
+                                 (void*)(mesh.firstIndex * sizeof(GLuint)), mesh.baseVertex);
+    else
+        countedDrawArrays(mesh.mode, 0, mesh.count);
+}
+
+// function to draw every instance of a registered mesh with one call
+void MeshRegistry::drawInstanced(MeshHandle handle, GLsizei instanceCount) const
+{
+    const MeshEntry& mesh = meshes[handle];
+    bind(mesh.VAO);
+    if (mesh.EBO != 0)
+        countedDrawElementsInstancedBaseVertex(mesh.mode, mesh.count, GL_UNSIGNED_INT,
+                                          (void*)(mesh.firstIndex * sizeof(GLuint)), instanceCount, mesh.baseVertex);
+    else
+        countedDrawArraysInstanced(mesh.mode, 0, mesh.count, instanceCount);
+}
+// function to register an instanced copy of a mesh: a VAO of its own reading the mesh's
+// buffers plus, from instanceVBO, a mat4 in 4 consecutive locations starting at location
+// followed by one float at location + 4. the mesh's own VAO keeps only its vertex
+// attributes, so the other draws of a shared VAO (the props) are not given instance divisors
+MeshHandle MeshRegistry::addInstanced(MeshHandle handle, GLuint instanceVBO, GLuint location, GLsizei stride)
+{
+    MeshEntry mesh = meshes[handle];
+    mesh.ownsBuffers = false;
+    GLuint source = mesh.VAO;
+    mesh.VAO = 0;
+    for (std::size_t i = 0; i < instancedVAOs.size() && mesh.VAO == 0; i++)
+    {
+        if (instancedVAOs[i].source == source && instancedVAOs[i].instanceVBO == instanceVBO)
+            mesh.VAO = instancedVAOs[i].VAO;
+    }
+    if (mesh.VAO == 0)
+    {
+        glGenVertexArrays(1, &mesh.VAO);
+        countedBindVertexArray(mesh.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        setAttributes(mesh.layout);
+        if (mesh.EBO != 0)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (GLuint i = 0; i < 4; i++)
+        {
+            glEnableVertexAttribArray(location + i);
+            glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, stride, (void*)(i * 4 * sizeof(float)));
+            glVertexAttribDivisor(location + i, 1);
+        }
+        glEnableVertexAttribArray(location + 4);
+        glVertexAttribPointer(location + 4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(16 * sizeof(float)));
+        glVertexAttribDivisor(location + 4, 1);
+        countedBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        boundVAO = 0;
+
+        InstancedVAO instanced;
+        instanced.source = source;
+        instanced.instanceVBO = instanceVBO;
+        instanced.VAO = mesh.VAO;
+        instancedVAOs.push_back(instanced);
+    }
+    meshes.push_back(mesh);
+    return (MeshHandle)(meshes.size() - 1);
+}
+
+GLuint MeshRegistry::getVAO(MeshHandle handle) const
+{
+    return meshes[handle].VAO;
+}
+// function to unbind the current VAO. always reaches GL, so it also resyncs the
+// registry after code outside it (Mesh, the text quad) has bound its own VAOs
+void MeshRegistry::unbind() const
+{
+    countedBindVertexArray(0);
+    boundVAO = 0;
+}
+// function to bind a VAO only when it is not bound already, the props sharing one VAO bind it once
+void MeshRegistry::bind(GLuint VAO) const
+{
+    if (boundVAO == VAO)
+        return;
+    countedBindVertexArray(VAO);
+    boundVAO = VAO;
+}
+// function to delete every vao and buffer owned by the registry
+void MeshRegistry::clear()
+{
+    for (std::size_t i = 0; i < meshes.size(); i++)
+    {
+        if (!meshes[i].ownsBuffers)
+            continue;
+        glDeleteVertexArrays(1, &meshes[i].VAO);
+        glDeleteBuffers(1, &meshes[i].VBO);
+        if (meshes[i].EBO != 0)
+            glDeleteBuffers(1, &meshes[i].EBO);
+    }
+    for (std::size_t i = 0; i < instancedVAOs.size(); i++)
+        glDeleteVertexArrays(1, &instancedVAOs[i].VAO);
+    meshes.clear();
+    instancedVAOs.clear();
+    boundVAO = 0;
+}
+
+MeshHandle MeshRegistry::upload(const GLfloat* vertices, GLsizeiptr size, const GLuint* indices, GLsizei indexCount,
+                                VertexLayout layout, GLenum mode)
+{
+    MeshEntry mesh;
+    GLsizei stride = strideOf(layout);
+    mesh.layout = layout;
+    mesh.mode = mode;
+    mesh.EBO = 0;
+    mesh.firstIndex = 0;
+    mesh.baseVertex = 0;
+    mesh.ownsBuffers = true;
+    mesh.count = indices != NULL ? indexCount : (GLsizei)(size / stride);
+
+    // generate vao and vbo and upload the vertices once
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    countedBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    countedBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    if (indices != NULL)
+    {
+        glGenBuffers(1, &mesh.EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        countedBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+    }
+
+    // bind vbo attribute pointers to the vao
+    setAttributes(layout);
+    countedBindVertexArray(0);
+    boundVAO = 0;
+
+    meshes.push_back(mesh);
+    return (MeshHandle)(meshes.size() - 1);
+}
+
+// function to point the vertex attributes of the bound VAO at the bound vertex buffer
+void MeshRegistry::setAttributes(VertexLayout layout)
+{
+    GLsizei stride = strideOf(layout);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    if (layout == LAYOUT_POSITION_TEXCOORD)
+    {
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    }
+    else if (layout == LAYOUT_POSITION_NORMAL_TEXCOORD || layout == LAYOUT_POSITION_NORMAL_TEXCOORD_MORPH)
+    {
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    }
+    if (layout == LAYOUT_POSITION_NORMAL_TEXCOORD_MORPH)
+    {
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, stride, (void*)(11 * sizeof(float)));
+    }
+}
+
+GLsizei MeshRegistry::strideOf(VertexLayout layout)
+{
+    if (layout == LAYOUT_POSITION)
+        return 3 * sizeof(float);
+    if (layout == LAYOUT_POSITION_TEXCOORD)
+        return 5 * sizeof(float);
+    if (layout == LAYOUT_POSITION_NORMAL_TEXCOORD_MORPH)
+        return 13 * sizeof(float);
+    return 8 * sizeof(float);
+}
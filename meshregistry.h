@@ -0,0 +1,73 @@
+#pragma once
+#ifndef MESHREGISTRY_H
+#define MESHREGISTRY_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+// vertex layouts used by the scene, matching the attribute locations of the shaders
+enum VertexLayout
+{
+    LAYOUT_POSITION,                   // 3 floats per position (skybox, light cubes)
+    LAYOUT_POSITION_TEXCOORD,          // 3 floats per position, 2 per tex coord
+    LAYOUT_POSITION_NORMAL_TEXCOORD,   // 3 floats per position, 3 per normal, 2 per tex coord
+    LAYOUT_POSITION_NORMAL_TEXCOORD_MORPH  // the same followed by a morph target position and tex coord (earth lod)
+};
+
+typedef unsigned int MeshHandle;
+
+// owns every VAO/VBO/EBO of the scene for the life of the process.
+// meshes are uploaded once at startup and drawn through a stable handle,
+// the draw path only binds and draws so nothing is allocated per frame
+class MeshRegistry
+{
+public:
+    MeshRegistry();
+    ~MeshRegistry();
+
+    MeshHandle addArrays(const GLfloat* vertices, GLsizeiptr size, VertexLayout layout, GLenum mode = GL_TRIANGLES);
+    MeshHandle addIndexed(const GLfloat* vertices, GLsizeiptr size, const GLuint* indices, GLsizei indexCount,
+                          VertexLayout layout, GLenum mode = GL_TRIANGLES);
+    MeshHandle addSubMesh(MeshHandle parent, GLuint firstIndex, GLsizei indexCount, GLint baseVertex,
+                          GLenum mode = GL_TRIANGLES);
+    void update(MeshHandle handle, const GLfloat* vertices, GLsizeiptr size, const GLuint* indices, GLsizei indexCount);
+    void draw(MeshHandle handle) const;
+    void drawInstanced(MeshHandle handle, GLsizei instanceCount) const;
+    MeshHandle addInstanced(MeshHandle handle, GLuint instanceVBO, GLuint location, GLsizei stride);
+    GLuint getVAO(MeshHandle handle) const;
+    void unbind() const;
+    void clear();
+
+private:
+    // sub meshes share the VAO and buffers of their parent and only own a range of its indices
+    struct MeshEntry
+    {
+        GLuint VAO, VBO, EBO;
+        VertexLayout layout;
+        GLenum mode;
+        GLsizei count;
+        GLuint firstIndex;
+        GLint baseVertex;
+        bool ownsBuffers;
+    };
+
+    // VAO reading the buffers of a mesh plus an instance buffer, one per pair so the
+    // sub meshes of one parent share it the way they share the parent's VAO
+    struct InstancedVAO
+    {
+        GLuint source, instanceVBO, VAO;
+    };
+
+    std::vector<MeshEntry> meshes;
+    std::vector<InstancedVAO> instancedVAOs;
+    mutable GLuint boundVAO;
+
+    void bind(GLuint VAO) const;
+    MeshHandle upload(const GLfloat* vertices, GLsizeiptr size, const GLuint* indices, GLsizei indexCount,
+                      VertexLayout layout, GLenum mode);
+    static void setAttributes(VertexLayout layout);
+    static GLsizei strideOf(VertexLayout layout);
+};
+
+#endif
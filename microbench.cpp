@@ -0,0 +1,348 @@
+/*
+CPU microbenchmarks for the code that runs before or outside the frame: icosphere
+subdivision, the parametric Sphere/Ufo tessellation, Model loading, texture decoding
+and the per frame transform chains. Every case reports the time, the number of heap
+allocations and the bytes allocated per operation, counted over all threads.
+
+This file has its own main and is built as a separate executable together with
+icosphere.cpp, renderstats.cpp, headless.cpp, textureloader.cpp, texturecache.cpp, mappedfile.cpp,
+jobs.cpp, scenetransforms.cpp, geometry.cpp and glad (not source.cpp and not stb_image.cpp, the
+stb_image implementation is compiled here so its allocations are counted):
+
+    microbench [--filter TEXT] [--min-time SECONDS] [--json FILE] [--model FILE]...
+
+--model loads an assimp model per run (needs an EGL context for the mesh uploads).
+The textures the program ships with are decoded from memory when they are found
+under resources/textures.
+*/
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+/* ALLOCATION COUNTING */
+// every operator new and every stb_image malloc of the process goes through here.
+// the counters are process wide on purpose: a case that hands work to the job
+// system (the texture decodes of a model load) is charged for the allocations of
+// the workers too. the workers don't allocate while they are idle, so the other
+// cases only see their own thread
+static std::atomic<std::size_t> allocationCount(0);
+static std::atomic<std::size_t> allocationBytes(0);
+
+static void* CountedMalloc(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size);
+}
+
+static void* CountedRealloc(void* p, std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    return realloc(p, size);
+}
+
+void* operator new(std::size_t size)
+{
+    void* p = CountedMalloc(size != 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedMalloc(size != 0 ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedMalloc(size != 0 ? size : 1);
+}
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+    free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size) CountedMalloc(size)
+#define STBI_REALLOC(p, size) CountedRealloc(p, size)
+#define STBI_FREE(p) free(p)
+#include "stb_image.h"
+
+#include "icosphere.h"
+#include "sphere.h"
+#include "ufo.h"
+#include "parametric.h"
+#include "headless.h"
+#include "jobs.h"
+#include "scenetransforms.h"
+#include "model.h"
+
+/* HARNESS */
+struct MicroResult
+{
+    std::string name;
+    std::size_t iterations;
+    double nsPerOp;
+    double allocationsPerOp;
+    double bytesPerOp;
+};
+
+// results are folded into this so the compiler cannot drop the work
+static volatile std::size_t sink;
+
+static std::vector<MicroResult> results;
+static std::string filter;
+static double minSeconds = 0.25;
+
+// function to run op until minSeconds passed (at least 3 times, after one untimed run)
+// and record the time and the allocations of the timed runs
+template <class Op>
+void Run(const std::string& name, Op op)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+
+    sink = sink + op();
+    std::size_t startCount = allocationCount.load();
+    std::size_t startBytes = allocationBytes.load();
+    std::size_t iterations = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (iterations < 3 || elapsed < minSeconds)
+    {
+        sink = sink + op();
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    MicroResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = elapsed * 1e9 / iterations;
+    result.allocationsPerOp = (double)(allocationCount.load() - startCount) / iterations;
+    result.bytesPerOp = (double)(allocationBytes.load() - startBytes) / iterations;
+    results.push_back(result);
+
+    char line[200];
+    snprintf(line, sizeof(line), "%-36s %12.3f us/op %10.1f allocs/op %14.0f B/op  (%zu runs)", name.c_str(),
+        result.nsPerOp / 1000.0, result.allocationsPerOp, result.bytesPerOp, iterations);
+    std::cout << line << std::endl;
+}
+
+static void WriteJson(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == NULL)
+    {
+        std::cout << "Failed to open " << path << std::endl;
+        return;
+    }
+    fprintf(file, "[\n");
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        fprintf(file, "  {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f}%s\n",
+            results[i].name.c_str(), results[i].iterations, results[i].nsPerOp, results[i].allocationsPerOp,
+            results[i].bytesPerOp, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "]\n");
+    fclose(file);
+}
+
+static bool ReadFile(const std::string& path, std::vector<unsigned char>& data)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file)
+        return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+/* CASES */
+static void BenchIcosphere()
+{
+    for (int level = 0; level <= 8; level++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "icosphere/smooth/%d", level);
+        Run(name, [level]() { Icosphere sphere(1.0f, level, true); return (std::size_t)sphere.getIndexCount(); });
+        snprintf(name, sizeof(name), "icosphere/flat/%d", level);
+        Run(name, [level]() { Icosphere sphere(1.0f, level, false); return (std::size_t)sphere.getIndexCount(); });
+    }
+}
+
+static void BenchParametric()
+{
+    for (unsigned int segments = 8; segments <= 1024; segments *= 2)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "parametric/sphere/%u", segments);
+        Run(name, [segments]() {
+            ParametricSurface surface;
+            GenerateParametricSurface<SphereShape>(segments, .15f, glm::vec3(0.0f, 2.7f, .25f), surface);
+            return surface.vertices.size();
+        });
+        snprintf(name, sizeof(name), "parametric/ufo/%u", segments);
+        Run(name, [segments]() {
+            ParametricSurface surface;
+            GenerateParametricSurface<UfoShape>(segments, .15f, glm::vec3(0.0f), surface);
+            return surface.vertices.size();
+        });
+    }
+    // what Sphere and Ufo cost once the level is in the cache, as on every tessellation change back
+    Run("sphere/cached/64", []() { Sphere sphere(64); return sphere.GetVertices().size(); });
+    Run("ufo/cached/64", []() { Ufo ufo(64); return ufo.GetVertices().size(); });
+}
+
+static void BenchTextures()
+{
+    const char* textures[] = {
+        "resources/textures/earth0.png",
+        "resources/textures/satellite.png",
+        "resources/textures/satellite2.png",
+        "resources/textures/box.png",
+        "resources/textures/AdobeStock_257170070.jpg",
+        "resources/textures/AdobeStock_235275603.jpg",
+        "resources/textures/background5.jpg",
+        "resources/textures/right.jpg",
+    };
+    for (std::size_t i = 0; i < sizeof(textures) / sizeof(textures[0]); i++)
+    {
+        // the file is read once, the runs only decode
+        std::vector<unsigned char> file;
+        if (!ReadFile(textures[i], file))
+        {
+            std::cout << "skipping " << textures[i] << " (not found)" << std::endl;
+            continue;
+        }
+        std::string path(textures[i]);
+        Run("stb_image/" + path.substr(path.find_last_of('/') + 1), [&file]() {
+            int width, height, channels;
+            unsigned char* pixels = stbi_load_from_memory(&file[0], (int)file.size(), &width, &height, &channels, 0);
+            std::size_t size = pixels != NULL ? (std::size_t)width * height * channels : 0;
+            stbi_image_free(pixels);
+            return size;
+        });
+    }
+}
+
+static void BenchModels(const std::vector<std::string>& models)
+{
+    if (models.empty())
+        return;
+    // the meshes and their textures are uploaded while loading, that needs a context
+    HeadlessContext context;
+    if (!context.create())
+    {
+        std::cout << "skipping the models, no GL context" << std::endl;
+        return;
+    }
+    // every run loads the textures again, their timing lines would bury the results
+    textureLoader.setReporting(false);
+    for (std::size_t i = 0; i < models.size(); i++)
+    {
+        std::string path = models[i];
+        Run("model/" + path.substr(path.find_last_of('/') + 1), [&path]() {
+            Model model(path);
+            std::size_t vertices = 0;
+            for (std::size_t m = 0; m < model.meshes.size(); m++)
+            {
+                vertices += model.meshes[m].vertices.size();
+                model.meshes[m].release();
+            }
+            for (std::size_t t = 0; t < model.textures_loaded.size(); t++)
+                glDeleteTextures(1, &model.textures_loaded[t].id);
+            return vertices;
+        });
+    }
+    context.destroy();
+}
+
+// the chains the render loop builds every frame, for the default 10k satellite constellation.
+// they are the functions source.cpp calls, run on one thread
+static void BenchTransforms()
+{
+    const unsigned int count = 10000;
+    std::vector<glm::mat4> models(count);
+    std::vector<float> positions(count * 3);
+    for (unsigned int i = 0; i < count * 3; i++)
+        positions[i] = (float)((i * 2654435761u) % 1000) / 500.0f - 1.0f;
+
+    Run("transforms/satellites-sgp4/10000", [&]() {
+        glm::mat4 body = SatelliteBodyMatrix();
+        for (unsigned int i = 0; i < count; i++)
+            models[i] = Sgp4SatelliteMatrix(&positions[i * 3], body);
+        return (std::size_t)models[count - 1][3][0];
+    });
+    Run("transforms/satellites-orbit/10000", [&]() {
+        float trajectory = 1.0f;
+        for (unsigned int i = 0; i < count; i++)
+            models[i] = OrbitSatelliteMatrix(i, count, trajectory);
+        return (std::size_t)models[count - 1][0][0];
+    });
+    Run("transforms/lights", [&]() {
+        double sceneTime = 1.5;
+        std::size_t sum = 0;
+        for (unsigned int i = 0; i < ORBITING_LIGHT_COUNT; i++)
+            sum += (std::size_t)OrbitingLightMatrix(i, sceneTime)[3][0];
+        return sum;
+    });
+}
+
+int main(int argc, char** argv)
+{
+    std::string jsonPath;
+    std::vector<std::string> models;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc)
+            minSeconds = atof(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (arg == "--model" && i + 1 < argc)
+            models.push_back(argv[++i]);
+    }
+
+    // the icosphere levels and the texture decodes run on the workers like in the program
+    jobs.init();
+    BenchIcosphere();
+    BenchParametric();
+    BenchTextures();
+    BenchModels(models);
+    BenchTransforms();
+    jobs.shutdown();
+
+    if (!jsonPath.empty())
+        WriteJson(jsonPath);
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "occlusion.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OCCLUSION_SSE 1
+#include <emmintrin.h>
+#else
+#define OCCLUSION_SSE 0
+#endif
+
+SphereOccluder MakeSphereOccluder(const glm::vec3& eye, const BoundingSphere& occluder)
+{
+    SphereOccluder result;
+    result.eye = eye;
+    result.axis = glm::vec3(0.0f, 0.0f, 1.0f);
+    result.sinAngle = 0.0f;
+    result.cosAngle = 1.0f;
+    result.horizon = 0.0f;
+    result.active = false;
+
+    glm::vec3 toCenter(occluder.center.x - eye.x, occluder.center.y - eye.y, occluder.center.z - eye.z);
+    float distance = std::sqrt(toCenter.x * toCenter.x + toCenter.y * toCenter.y + toCenter.z * toCenter.z);
+    if (distance <= occluder.radius)
+        return result;
+    result.axis = glm::vec3(toCenter.x / distance, toCenter.y / distance, toCenter.z / distance);
+    result.sinAngle = occluder.radius / distance;
+    result.cosAngle = std::sqrt(distance * distance - occluder.radius * occluder.radius) / distance;
+    // the horizon circle is where the cone touches the sphere, its plane is R^2 / d before the center
+    result.horizon = distance - occluder.radius * occluder.radius / distance;
+    result.active = true;
+    return result;
+}
+// t is the distance along the axis and h the distance from it: t sin - h cos is how far the
+// center is inside the cone's surface, t - r how far the sphere starts past the eye
+bool SphereOccluded(const SphereOccluder& occluder, const BoundingSphere& sphere)
+{
+    if (!occluder.active)
+        return false;
+    float vx = sphere.center.x - occluder.eye.x;
+    float vy = sphere.center.y - occluder.eye.y;
+    float vz = sphere.center.z - occluder.eye.z;
+    float t = vx * occluder.axis.x + vy * occluder.axis.y + vz * occluder.axis.z;
+    float h2 = vx * vx + vy * vy + vz * vz - t * t;
+    float h = std::sqrt(h2 > 0.0f ? h2 : 0.0f);
+    return t - sphere.radius >= occluder.horizon && t * occluder.sinAngle - h * occluder.cosAngle >= sphere.radius;
+}
+
+#if OCCLUSION_SSE
+
+std::size_t CullOccluded(const SphereOccluder& occluder, const float* x, const float* y, const float* z,
+                         const float* radius, const unsigned int* indices, std::size_t count, unsigned int* visible)
+{
+    if (!occluder.active)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            visible[i] = indices[i];
+        return count;
+    }
+    __m128 eyeX = _mm_set1_ps(occluder.eye.x), eyeY = _mm_set1_ps(occluder.eye.y), eyeZ = _mm_set1_ps(occluder.eye.z);
+    __m128 axisX = _mm_set1_ps(occluder.axis.x), axisY = _mm_set1_ps(occluder.axis.y), axisZ = _mm_set1_ps(occluder.axis.z);
+    __m128 sinAngle = _mm_set1_ps(occluder.sinAngle), cosAngle = _mm_set1_ps(occluder.cosAngle);
+    __m128 horizon = _mm_set1_ps(occluder.horizon);
+
+    std::size_t visibleCount = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // the indices are gathered first, visible may overwrite them
+        unsigned int i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2], i3 = indices[i + 3];
+        __m128 vx = _mm_sub_ps(_mm_setr_ps(x[i0], x[i1], x[i2], x[i3]), eyeX);
+        __m128 vy = _mm_sub_ps(_mm_setr_ps(y[i0], y[i1], y[i2], y[i3]), eyeY);
+        __m128 vz = _mm_sub_ps(_mm_setr_ps(z[i0], z[i1], z[i2], z[i3]), eyeZ);
+        __m128 r = _mm_setr_ps(radius[i0], radius[i1], radius[i2], radius[i3]);
+
+        __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, axisX), _mm_mul_ps(vy, axisY)), _mm_mul_ps(vz, axisZ));
+        __m128 l2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 h = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(l2, _mm_mul_ps(t, t)), _mm_setzero_ps()));
+        __m128 pastHorizon = _mm_cmpge_ps(_mm_sub_ps(t, r), horizon);
+        __m128 insideCone = _mm_cmpge_ps(_mm_sub_ps(_mm_mul_ps(t, sinAngle), _mm_mul_ps(h, cosAngle)), r);
+        int hidden = _mm_movemask_ps(_mm_and_ps(pastHorizon, insideCone));
+
+        unsigned int lanes[4] = { i0, i1, i2, i3 };
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (!(hidden & (1 << lane)))
+                visible[visibleCount++] = lanes[lane];
+        }
+    }
+    for (; i < count; i++)
+    {
+        unsigned int index = indices[i];
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(x[index], y[index], z[index]);
+        sphere.radius = radius[index];
+        if (!SphereOccluded(occluder, sphere))
+            visible[visibleCount++] = index;
+    }
+    return visibleCount;
+}
+
+#else
+
+std::size_t CullOccluded(const SphereOccluder& occluder, const float* x, const float* y, const float* z,
+                         const float* radius, const unsigned int* indices, std::size_t count, unsigned int* visible)
+{
+    std::size_t visibleCount = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        unsigned int index = indices[i];
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(x[index], y[index], z[index]);
+        sphere.radius = radius[index];
+        if (!SphereOccluded(occluder, sphere))
+            visible[visibleCount++] = index;
+    }
+    return visibleCount;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include "bounds.h"
+
+// a sphere (the earth) seen from the camera, set up once per view. everything inside
+// the cone from the camera around it and past the plane of its horizon circle is
+// behind it; an object is hidden when its whole bounding sphere is in that region
+struct SphereOccluder
+{
+    glm::vec3 eye;
+    glm::vec3 axis;         // unit vector from the eye to the occluder's center
+    float sinAngle;         // half angle of the cone
+    float cosAngle;
+    float horizon;          // distance along the axis of the horizon circle's plane
+    bool active;            // false with the eye inside the occluder, nothing is hidden then
+};
+
+// function to set the occluder up for an eye position
+SphereOccluder MakeSphereOccluder(const glm::vec3& eye, const BoundingSphere& occluder);
+bool SphereOccluded(const SphereOccluder& occluder, const BoundingSphere& sphere);
+// function to drop the hidden spheres from a list of indices (the output of CullSpheres),
+// four at a time. visible may be the same array as indices, returns how many are left
+std::size_t CullOccluded(const SphereOccluder& occluder, const float* x, const float* y, const float* z,
+                         const float* radius, const unsigned int* indices, std::size_t count, unsigned int* visible);
+
+#endif
@@ -0,0 +1,197 @@
+#pragma once
+#ifndef PARAMETRIC_H
+#define PARAMETRIC_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// profile of a surface of revolution at v in [0, 1]: distance from the axis,
+// height along the axis and their derivatives along v, used for the normals
+struct SurfaceProfile
+{
+    float ring;
+    float height;
+    float dRing;
+    float dHeight;
+};
+
+// the earth
+struct SphereShape
+{
+    static const int ID = 0;
+
+    static SurfaceProfile profile(float v)
+    {
+        const float PI = 3.14159265359f;
+        SurfaceProfile p;
+        p.ring = std::sin(v * PI);
+        p.height = std::cos(v * PI);
+        p.dRing = PI * std::cos(v * PI);
+        p.dHeight = -PI * std::sin(v * PI);
+        return p;
+    }
+};
+
+// the satellite dish, a sphere whose height only runs from cos(.1) to cos(1.1)
+struct UfoShape
+{
+    static const int ID = 1;
+
+    static SurfaceProfile profile(float v)
+    {
+        const float PI = 3.14159265359f;
+        SurfaceProfile p;
+        p.ring = std::sin(v * PI);
+        p.height = std::cos(v + .1f);
+        p.dRing = PI * std::cos(v * PI);
+        p.dHeight = -std::sin(v + .1f);
+        return p;
+    }
+};
+
+// interleaved position/normal/tex coord vertices and the indices to draw them with mode
+struct ParametricSurface
+{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    GLenum mode;
+    unsigned int segments;
+};
+
+// function to tessellate a surface of revolution into segments x segments quads.
+// the sin/cos of every column and the profile of every row are computed once,
+// so each vertex is a few multiply-adds written straight into the vertex buffer
+template <class Shape>
+void GenerateParametricSurface(unsigned int segments, float radius, const glm::vec3& offset, ParametricSurface& surface)
+{
+    const float PI = 3.14159265359f;
+    const unsigned int columns = segments + 1;
+    const unsigned int rows = segments + 1;
+
+    std::vector<float> sinU(columns), cosU(columns);
+    for (unsigned int x = 0; x < columns; ++x)
+    {
+        float angle = (float)x / (float)segments * 2.0f * PI;
+        sinU[x] = std::sin(angle);
+        cosU[x] = std::cos(angle);
+    }
+
+    surface.segments = segments;
+    surface.vertices.resize(rows * columns * 8);
+    float* vertex = &surface.vertices[0];
+    for (unsigned int y = 0; y < rows; ++y)
+    {
+        float v = (float)y / (float)segments;
+        SurfaceProfile p = Shape::profile(v);
+
+        // outward normal of the surface of revolution, the same for every column up to the rotation
+        float length = std::sqrt(p.dHeight * p.dHeight + p.dRing * p.dRing);
+        float normalRing = length > 0.0f ? -p.dHeight / length : 0.0f;
+        float normalHeight = length > 0.0f ? p.dRing / length : 1.0f;
+        float ring = p.ring * radius;
+        float height = p.height * radius + offset.y;
+
+        for (unsigned int x = 0; x < columns; ++x)
+        {
+            vertex[0] = cosU[x] * ring + offset.x;
+            vertex[1] = height;
+            vertex[2] = sinU[x] * ring + offset.z;
+            vertex[3] = cosU[x] * normalRing;
+            vertex[4] = normalHeight;
+            vertex[5] = sinU[x] * normalRing;
+            vertex[6] = (float)x / (float)segments;
+            vertex[7] = v;
+            vertex += 8;
+        }
+    }
+
+    // one triangle strip that snakes through the rows, alternating direction
+    surface.mode = GL_TRIANGLE_STRIP;
+    surface.indices.resize(segments * columns * 2);
+    unsigned int* index = &surface.indices[0];
+    for (unsigned int y = 0; y < segments; ++y)
+    {
+        if (y % 2 == 0)
+        {
+            for (unsigned int x = 0; x < columns; ++x)
+            {
+                *index++ = y * columns + x;
+                *index++ = (y + 1) * columns + x;
+            }
+        }
+        else
+        {
+            for (int x = (int)segments; x >= 0; --x)
+            {
+                *index++ = (y + 1) * columns + x;
+                *index++ = y * columns + x;
+            }
+        }
+    }
+}
+
+// generated surfaces keyed by (shape, segments, radius, offset), so changing
+// the tessellation back and forth at runtime only generates each level once.
+// get() may be called from several threads, surfaces are generated outside the lock
+// and the first one in is kept; the references stay valid until clear()
+class ParametricCache
+{
+public:
+    template <class Shape>
+    const ParametricSurface& get(unsigned int segments, float radius, const glm::vec3& offset)
+    {
+        Key key = { Shape::ID, segments, radius, offset.x, offset.y, offset.z };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            typename std::map<Key, ParametricSurface>::iterator found = surfaces.find(key);
+            if (found != surfaces.end())
+                return found->second;
+        }
+
+        ParametricSurface surface;
+        GenerateParametricSurface<Shape>(segments, radius, offset, surface);
+        std::lock_guard<std::mutex> lock(mutex);
+        return surfaces.insert(std::make_pair(key, std::move(surface))).first->second;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        surfaces.clear();
+    }
+
+    // the cache used by Sphere and Ufo
+    static ParametricCache& shared()
+    {
+        static ParametricCache cache;
+        return cache;
+    }
+
+private:
+    struct Key
+    {
+        int shape;
+        unsigned int segments;
+        float radius, x, y, z;
+
+        bool operator<(const Key& other) const
+        {
+            if (shape != other.shape) return shape < other.shape;
+            if (segments != other.segments) return segments < other.segments;
+            if (radius != other.radius) return radius < other.radius;
+            if (x != other.x) return x < other.x;
+            if (y != other.y) return y < other.y;
+            return z < other.z;
+        }
+    };
+
+    std::map<Key, ParametricSurface> surfaces;
+    std::mutex mutex;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "poster.h"
+#include "framebuffer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#ifdef _WIN32
+#define fseeko _fseeki64
+#endif
+
+ProjectionBounds PerspectiveBounds(float fovy, float aspect, float zNear, float zFar)
+{
+    ProjectionBounds bounds;
+    bounds.top = zNear * std::tan(fovy * 0.5f);
+    bounds.bottom = -bounds.top;
+    bounds.right = bounds.top * aspect;
+    bounds.left = -bounds.right;
+    bounds.zNear = zNear;
+    bounds.zFar = zFar;
+    bounds.perspective = true;
+    return bounds;
+}
+
+ProjectionBounds OrthoBounds(float left, float right, float bottom, float top, float zNear, float zFar)
+{
+    ProjectionBounds bounds = { left, right, bottom, top, zNear, zFar, false };
+    return bounds;
+}
+
+glm::mat4 TileProjection(const ProjectionBounds& bounds, int imageWidth, int imageHeight,
+                         int x, int y, int width, int height)
+{
+    // image rows go down, the near plane's y goes up
+    float spanX = (bounds.right - bounds.left) / (float)imageWidth;
+    float spanY = (bounds.top - bounds.bottom) / (float)imageHeight;
+    float left = bounds.left + spanX * (float)x;
+    float right = bounds.left + spanX * (float)(x + width);
+    float top = bounds.top - spanY * (float)y;
+    float bottom = bounds.top - spanY * (float)(y + height);
+    if (bounds.perspective)
+        return glm::frustum(left, right, bottom, top, bounds.zNear, bounds.zFar);
+    return glm::ortho(left, right, bottom, top, bounds.zNear, bounds.zFar);
+}
+
+/* POSTER WRITER */
+
+PosterWriter::PosterWriter() : file(NULL), width(0), height(0), headerSize(0), failed(false)
+{
+
+}
+
+PosterWriter::~PosterWriter()
+{
+    close();
+}
+
+bool PosterWriter::open(const std::string& path, int width, int height)
+{
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        std::cout << "Failed to open poster output " << path << std::endl;
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    failed = false;
+    headerSize = fprintf(file, "P6\n%d %d\n255\n", width, height);
+    // size the file up front so every tile is a write into the middle of it
+    long long last = headerSize + (long long)width * height * 3 - 1;
+    failed = headerSize <= 0 || fseeko(file, last, SEEK_SET) != 0 || fputc(0, file) == EOF;
+    return !failed;
+}
+
+// function to write a tile read back with glReadPixels: RGBA, bottom row first
+void PosterWriter::writeTile(int x, int y, int width, int height, const unsigned char* rgba)
+{
+    if (file == NULL || failed)
+        return;
+    row.resize((std::size_t)width * 3);
+    for (int r = 0; r < height; r++)
+    {
+        const unsigned char* source = rgba + (std::size_t)(height - 1 - r) * width * 4;
+        for (int c = 0; c < width; c++)
+        {
+            row[c * 3] = source[c * 4];
+            row[c * 3 + 1] = source[c * 4 + 1];
+            row[c * 3 + 2] = source[c * 4 + 2];
+        }
+        long long offset = headerSize + ((long long)(y + r) * this->width + x) * 3;
+        if (fseeko(file, offset, SEEK_SET) != 0 || fwrite(&row[0], 1, row.size(), file) != row.size())
+        {
+            failed = true;
+            return;
+        }
+    }
+}
+
+bool PosterWriter::close()
+{
+    if (file == NULL)
+        return !failed;
+    if (fclose(file) != 0)
+        failed = true;
+    file = NULL;
+    return !failed;
+}
+
+/* TILED RENDERING */
+
+bool RenderPoster(const std::string& path, int width, int height, int tileSize, const ProjectionBounds& bounds,
+                  const std::function<void(const glm::mat4&)>& drawScene)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+    tileSize = std::max(16, std::min(tileSize, (int)maxSize));
+    int tileWidth = std::min(tileSize, width);
+    int tileHeight = std::min(tileSize, height);
+
+    Framebuffer tile;
+    PosterWriter writer;
+    if (!tile.create(tileWidth, tileHeight, 4) || !writer.open(path, width, height))
+        return false;
+    std::vector<unsigned char> pixels((std::size_t)tileWidth * tileHeight * 4);
+
+    int columns = (width + tileWidth - 1) / tileWidth;
+    int rows = (height + tileHeight - 1) / tileHeight;
+    for (int ty = 0; ty < rows; ty++)
+    {
+        for (int tx = 0; tx < columns; tx++)
+        {
+            // the last row and column are narrower, the viewport shrinks with the frustum
+            int x = tx * tileWidth;
+            int y = ty * tileHeight;
+            int w = std::min(tileWidth, width - x);
+            int h = std::min(tileHeight, height - y);
+            tile.bind();
+            glViewport(0, 0, w, h);
+            drawScene(TileProjection(bounds, width, height, x, y, w, h));
+            tile.resolve();
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+            writer.writeTile(x, y, w, h, &pixels[0]);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    bool written = writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (written)
+        std::cout << "Wrote " << width << "x" << height << " poster " << path << " from " << columns * rows << " tiles of "
+                  << tileWidth << "x" << tileHeight << " in " << seconds << " s" << std::endl;
+    else
+        std::cout << "Failed to write poster " << path << std::endl;
+    return written;
+}
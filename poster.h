@@ -0,0 +1,55 @@
+#pragma once
+#ifndef POSTER_H
+#define POSTER_H
+
+#include <glm/glm.hpp>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// the near plane rectangle and depth range of a projection, so it can be cut into tiles
+struct ProjectionBounds
+{
+    float left, right, bottom, top;
+    float zNear, zFar;
+    bool perspective;
+};
+
+ProjectionBounds PerspectiveBounds(float fovy, float aspect, float zNear, float zFar);
+ProjectionBounds OrthoBounds(float left, float right, float bottom, float top, float zNear, float zFar);
+
+// function to build the projection of the tile whose top left pixel is (x, y) in an
+// imageWidth x imageHeight image: glm::frustum or glm::ortho over that part of bounds
+glm::mat4 TileProjection(const ProjectionBounds& bounds, int imageWidth, int imageHeight,
+                         int x, int y, int width, int height);
+
+// binary PPM written tile by tile at the tiles' offsets in the file, so memory holds one
+// tile whatever the size of the image. the file is preallocated by writing the last byte
+class PosterWriter
+{
+public:
+    PosterWriter();
+    ~PosterWriter();
+
+    bool open(const std::string& path, int width, int height);
+    void writeTile(int x, int y, int width, int height, const unsigned char* rgba);
+    bool close();
+
+private:
+    PosterWriter(const PosterWriter&);
+    PosterWriter& operator=(const PosterWriter&);
+
+    FILE* file;
+    int width, height;
+    long long headerSize;
+    bool failed;
+    std::vector<unsigned char> row;
+};
+
+// function to render the scene as tileSize x tileSize tiles and stream them into a PPM.
+// drawScene clears and draws the whole scene with the projection it is given
+bool RenderPoster(const std::string& path, int width, int height, int tileSize, const ProjectionBounds& bounds,
+                  const std::function<void(const glm::mat4&)>& drawScene);
+
+#endif
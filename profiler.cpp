@@ -0,0 +1,272 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+Profiler profiler;
+
+ProfileRing::ProfileRing() : head(0), tail(0)
+{
+    for (std::size_t i = 0; i < PROFILER_RING_SIZE; i++)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+// function to queue a sample, false when the ring is full. a slot is free for position pos
+// when its sequence is pos and holds a sample for the reader when it is pos + 1
+bool ProfileRing::push(const ProfileSample& sample)
+{
+    std::size_t pos = head.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        slot = &slots[pos & (PROFILER_RING_SIZE - 1)];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+        if (diff == 0)
+        {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = head.load(std::memory_order_relaxed);
+    }
+    slot->sample = sample;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool ProfileRing::pop(ProfileSample& sample)
+{
+    std::size_t pos = tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        slot = &slots[pos & (PROFILER_RING_SIZE - 1)];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(pos + 1);
+        if (diff == 0)
+        {
+            if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = tail.load(std::memory_order_relaxed);
+    }
+    sample = slot->sample;
+    slot->sequence.store(pos + PROFILER_RING_SIZE, std::memory_order_release);
+    return true;
+}
+
+Profiler::Profiler() : gpuDepth(0), frame(0), frameStart(0), dropped(0), totalFrames(0), trace(NULL)
+{
+    for (unsigned int i = 0; i < PROFILER_QUERY_SETS; i++)
+        queriesUsed[i] = 0;
+}
+
+Profiler::~Profiler()
+{
+    stopTrace();
+}
+
+std::uint64_t Profiler::now()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+// function to number the threads in the order they first record something, 0 is the gpu
+std::uint32_t Profiler::threadId()
+{
+    static std::atomic<std::uint32_t> nextThread(1);
+    thread_local std::uint32_t id = nextThread++;
+    return id;
+}
+
+void Profiler::beginFrame()
+{
+    frame++;
+    collectQueries(frame % PROFILER_QUERY_SETS);
+    frameStart = now();
+}
+
+void Profiler::endFrame()
+{
+    addCpuSample("frame", frameStart, now());
+
+    ProfileSample sample;
+    while (ring.pop(sample))
+        record(sample);
+
+    if (++totalFrames < PROFILER_SUMMARY_FRAMES)
+        return;
+    summary.clear();
+    for (std::size_t i = 0; i < totals.size(); i++)
+    {
+        char line[128];
+        double cpuMs = totals[i].cpu / 1e6 / totalFrames;
+        if (totals[i].hasGpu)
+            snprintf(line, sizeof(line), "%-12s cpu %7.3f ms  gpu %7.3f ms", totals[i].name, cpuMs, totals[i].gpu / 1e6 / totalFrames);
+        else
+            snprintf(line, sizeof(line), "%-12s cpu %7.3f ms", totals[i].name, cpuMs);
+        summary.push_back(line);
+        totals[i].cpu = 0;
+        totals[i].gpu = 0;
+    }
+    totalFrames = 0;
+}
+
+void Profiler::addCpuSample(const char* name, std::uint64_t start, std::uint64_t end)
+{
+    ProfileSample sample;
+    sample.name = name;
+    sample.start = start;
+    sample.duration = end - start;
+    sample.frame = frame;
+    sample.thread = threadId();
+    if (!ring.push(sample))
+        dropped++;
+}
+// function to start a GL_TIME_ELAPSED query out of this frame's set, the set grows to
+// the number of gpu scopes in a frame and is then reused
+void Profiler::beginGpu(const char* name)
+{
+    if (gpuDepth++ > 0)
+        return;
+    unsigned int set = frame % PROFILER_QUERY_SETS;
+    if (queriesUsed[set] == queries[set].size())
+    {
+        GpuQuery query;
+        glGenQueries(1, &query.id);
+        queries[set].push_back(query);
+    }
+    GpuQuery& query = queries[set][queriesUsed[set]++];
+    query.name = name;
+    query.start = now();
+    query.frame = frame;
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+}
+
+void Profiler::endGpu()
+{
+    if (gpuDepth == 0 || --gpuDepth > 0)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+}
+// function to read back a set of queries issued PROFILER_QUERY_SETS frames ago. a result
+// that is still not available is dropped instead of waited for
+void Profiler::collectQueries(unsigned int set)
+{
+    for (std::size_t i = 0; i < queriesUsed[set]; i++)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(queries[set][i].id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            dropped++;
+            continue;
+        }
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[set][i].id, GL_QUERY_RESULT, &elapsed);
+        ProfileSample sample;
+        sample.name = queries[set][i].name;
+        sample.start = queries[set][i].start;
+        sample.duration = elapsed;
+        sample.frame = queries[set][i].frame;
+        sample.thread = 0;
+        record(sample);
+    }
+    queriesUsed[set] = 0;
+}
+// function to add a sample to the running totals of its section and to the trace
+void Profiler::record(const ProfileSample& sample)
+{
+    std::size_t i = 0;
+    while (i < totals.size() && totals[i].name != sample.name && strcmp(totals[i].name, sample.name) != 0)
+        i++;
+    if (i == totals.size())
+    {
+        Totals section = { sample.name, 0, 0, false };
+        totals.push_back(section);
+    }
+    if (sample.thread == 0)
+    {
+        totals[i].gpu += sample.duration;
+        totals[i].hasGpu = true;
+    }
+    else
+        totals[i].cpu += sample.duration;
+
+    if (trace != NULL)
+        writeEvent(sample);
+}
+
+bool Profiler::startTrace(const std::string& path)
+{
+    stopTrace();
+    trace = fopen(path.c_str(), "w");
+    if (trace == NULL)
+    {
+        std::cout << "Failed to open trace file " << path << std::endl;
+        return false;
+    }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", trace);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}", trace);
+    return true;
+}
+
+void Profiler::stopTrace()
+{
+    if (trace == NULL)
+        return;
+    // samples pushed since the last frame end still belong in the trace
+    ProfileSample sample;
+    while (ring.pop(sample))
+        record(sample);
+    fputs("\n]}\n", trace);
+    fclose(trace);
+    trace = NULL;
+}
+// function to write a complete ("X") event, timestamps in the format are microseconds
+void Profiler::writeEvent(const ProfileSample& sample)
+{
+    fprintf(trace, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%u}}",
+        sample.name, sample.thread == 0 ? "gpu" : "cpu", sample.start / 1e3, sample.duration / 1e3,
+        sample.thread, sample.frame);
+}
+
+const std::vector<std::string>& Profiler::getSummary() const
+{
+    return summary;
+}
+
+void Profiler::printSummary() const
+{
+    for (std::size_t i = 0; i < summary.size(); i++)
+        std::cout << summary[i] << std::endl;
+    if (dropped > 0)
+        std::cout << dropped.load() << " profiler samples dropped" << std::endl;
+}
+
+std::size_t Profiler::getDropped() const
+{
+    return dropped;
+}
+
+void Profiler::clear()
+{
+    for (unsigned int i = 0; i < PROFILER_QUERY_SETS; i++)
+    {
+        for (std::size_t q = 0; q < queries[i].size(); q++)
+            glDeleteQueries(1, &queries[i][q].id);
+        queries[i].clear();
+        queriesUsed[i] = 0;
+    }
+    gpuDepth = 0;
+}
+
+#endif
@@ -0,0 +1,176 @@
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// the profiler is built in unless the program is compiled with -DPROFILER_ENABLED=0,
+// then every PROFILE_ macro expands to nothing and profiler.cpp compiles to an empty unit
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#if PROFILER_ENABLED
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// one timed section. name must be a string literal (only the pointer is stored),
+// start is in ns since the profiler started. gpu samples are stamped with the cpu time
+// their pass was issued at, GL_TIME_ELAPSED only measures the duration
+struct ProfileSample
+{
+    const char* name;
+    std::uint64_t start;
+    std::uint64_t duration;
+    std::uint32_t frame;
+    std::uint32_t thread;       // 0 is the gpu
+};
+
+// ring size in samples, a power of two. samples that do not fit are dropped and counted
+const std::size_t PROFILER_RING_SIZE = 1 << 14;
+// sets of timer queries, frame n reads set n % 2 back right before reusing it (two frames later)
+const unsigned int PROFILER_QUERY_SETS = 2;
+// the summary is averaged over this many frames
+const unsigned int PROFILER_SUMMARY_FRAMES = 60;
+
+// bounded lock free queue (Vyukov's), any thread pushes, the render thread pops
+class ProfileRing
+{
+public:
+    ProfileRing();
+
+    bool push(const ProfileSample& sample);
+    bool pop(ProfileSample& sample);
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        ProfileSample sample;
+    };
+    Slot slots[PROFILER_RING_SIZE];
+    alignas(64) std::atomic<std::size_t> head;
+    alignas(64) std::atomic<std::size_t> tail;
+};
+
+class Profiler
+{
+public:
+    Profiler();
+    ~Profiler();
+
+    // function to mark the frame boundaries, begin also collects the timer queries of
+    // two frames ago and end moves the ring into the summary and the trace
+    void beginFrame();
+    void endFrame();
+
+    // function to stream every sample into a Chrome trace / Perfetto JSON file until stopTrace
+    bool startTrace(const std::string& path);
+    void stopTrace();
+
+    void addCpuSample(const char* name, std::uint64_t start, std::uint64_t end);
+    void beginGpu(const char* name);
+    void endGpu();
+
+    // function to get the summary, one line per section with its cpu and gpu ms per frame
+    // averaged over the last PROFILER_SUMMARY_FRAMES frames
+    const std::vector<std::string>& getSummary() const;
+    void printSummary() const;
+    std::size_t getDropped() const;
+    // function to release the query objects, needs the context that created them
+    void clear();
+
+    static std::uint64_t now();
+    static std::uint32_t threadId();
+
+private:
+    struct GpuQuery
+    {
+        GLuint id;
+        const char* name;
+        std::uint64_t start;
+        std::uint32_t frame;
+    };
+    struct Totals
+    {
+        const char* name;
+        std::uint64_t cpu;
+        std::uint64_t gpu;
+        bool hasGpu;
+    };
+
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+
+    void collectQueries(unsigned int set);
+    void record(const ProfileSample& sample);
+    void writeEvent(const ProfileSample& sample);
+
+    ProfileRing ring;
+    std::vector<GpuQuery> queries[PROFILER_QUERY_SETS];
+    std::size_t queriesUsed[PROFILER_QUERY_SETS];
+    unsigned int gpuDepth;
+    std::atomic<std::uint32_t> frame;   // read by the threads that add samples
+    std::uint64_t frameStart;
+    std::atomic<std::size_t> dropped;
+    std::vector<Totals> totals;
+    unsigned int totalFrames;
+    std::vector<std::string> summary;
+    FILE* trace;
+};
+
+extern Profiler profiler;
+
+// times the enclosing block on the calling thread
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) : name(name), start(Profiler::now()) {}
+    ~ProfileScope() { profiler.addCpuSample(name, start, Profiler::now()); }
+
+private:
+    ProfileScope(const ProfileScope&);
+    ProfileScope& operator=(const ProfileScope&);
+
+    const char* name;
+    std::uint64_t start;
+};
+
+// times the GL commands of the enclosing block with a GL_TIME_ELAPSED query. these
+// queries cannot nest, a gpu scope opened inside another one is ignored
+class GpuProfileScope
+{
+public:
+    explicit GpuProfileScope(const char* name) { profiler.beginGpu(name); }
+    ~GpuProfileScope() { profiler.endGpu(); }
+
+private:
+    GpuProfileScope(const GpuProfileScope&);
+    GpuProfileScope& operator=(const GpuProfileScope&);
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_JOIN(gpuProfileScope, __LINE__)(name)
+// a render pass, timed on both the cpu and the gpu
+#define PROFILE_PASS(name) PROFILE_SCOPE(name); PROFILE_GPU_SCOPE(name)
+#define PROFILE_BEGIN_FRAME() profiler.beginFrame()
+#define PROFILE_END_FRAME() profiler.endFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_PASS(name)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#include "renderstats.h"
+
+RenderStats renderStats = RenderStats();
+
+// the program countedUseProgram bound last, every program switch of the scene goes through it
+static GLuint currentProgram = 0;
+
+void countedUseProgram(GLuint program)
+{
+    renderStats.programBinds++;
+    if (program == currentProgram)
+        renderStats.redundantProgramBinds++;
+    currentProgram = program;
+    glUseProgram(program);
+}
+
+RenderStats FinishRenderStatsFrame()
+{
+    RenderStats finished = renderStats;
+    renderStats = RenderStats();
+    return finished;
+}
+
+void FormatRenderStats(const RenderStats& stats, std::vector<std::string>& lines)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "draws %u  programs %u (%u redundant)", stats.drawCalls, stats.programBinds,
+        stats.redundantProgramBinds);
+    lines.push_back(line);
+    snprintf(line, sizeof(line), "textures %u  vaos %u  uniforms %u", stats.textureBinds, stats.vaoBinds, stats.uniformCalls);
+    lines.push_back(line);
+    snprintf(line, sizeof(line), "buffer allocations %u  uploaded %.1f KB", stats.bufferAllocations,
+        stats.bytesUploaded / 1024.0);
+    lines.push_back(line);
+    snprintf(line, sizeof(line), "culled %u outside the view  %u behind the earth", stats.frustumCulled, stats.occlusionCulled);
+    lines.push_back(line);
+    if (stats.tilesResident != 0)
+    {
+        snprintf(line, sizeof(line), "earth tiles %u cached  %u uploaded", stats.tilesResident, stats.tilesUploaded);
+        lines.push_back(line);
+    }
+}
+
+void WriteRenderStatsJson(FILE* file, unsigned int frame, const RenderStats& stats)
+{
+    fprintf(file, "{\"frame\":%u,\"draw_calls\":%u,\"program_binds\":%u,\"redundant_program_binds\":%u,"
+        "\"texture_binds\":%u,\"vao_binds\":%u,\"buffer_allocations\":%u,\"bytes_uploaded\":%llu,\"uniform_calls\":%u,"
+        "\"frustum_culled\":%u,\"occlusion_culled\":%u,\"tiles_uploaded\":%u,\"tiles_resident\":%u}\n",
+        frame, stats.drawCalls, stats.programBinds, stats.redundantProgramBinds, stats.textureBinds, stats.vaoBinds,
+        stats.bufferAllocations, stats.bytesUploaded, stats.uniformCalls, stats.frustumCulled, stats.occlusionCulled,
+        stats.tilesUploaded, stats.tilesResident);
+    fflush(file);
+}
@@ -0,0 +1,134 @@
+#pragma once
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// what the GL calls of one frame did. every counted* function below forwards to the GL
+// function of the same name and adds to renderStats, the render code calls those instead
+struct RenderStats
+{
+    unsigned int drawCalls;
+    unsigned int programBinds;
+    unsigned int redundantProgramBinds;     // binds of the program that was already in use
+    unsigned int textureBinds;
+    unsigned int vaoBinds;
+    unsigned int bufferAllocations;         // glBufferData, a new (or orphaned) store
+    unsigned int uniformCalls;
+    unsigned long long bytesUploaded;       // buffer and texture data from the cpu
+    unsigned int frustumCulled;             // objects and satellites skipped outside the view
+    unsigned int occlusionCulled;           // and skipped behind the earth
+    unsigned int tilesUploaded;             // earth imagery tiles put into the tile cache
+    unsigned int tilesResident;             // and tiles in it after the frame's update
+};
+
+// the frame being drawn
+extern RenderStats renderStats;
+
+// function to take the counters of the frame that ended and start the next one at zero
+RenderStats FinishRenderStatsFrame();
+// function to print the counters as a few lines of overlay text
+void FormatRenderStats(const RenderStats& stats, std::vector<std::string>& lines);
+// function to append the counters as one JSON object per line, for diffing runs
+void WriteRenderStatsJson(FILE* file, unsigned int frame, const RenderStats& stats);
+
+// glUseProgram, counting a bind of the program already in use as redundant
+void countedUseProgram(GLuint program);
+
+inline void countedDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    renderStats.drawCalls++;
+    glDrawArrays(mode, first, count);
+}
+inline void countedDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    renderStats.drawCalls++;
+    glDrawArraysInstanced(mode, first, count, instances);
+}
+inline void countedDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+    renderStats.drawCalls++;
+    glDrawElements(mode, count, type, indices);
+}
+inline void countedDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex)
+{
+    renderStats.drawCalls++;
+    glDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+inline void countedDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                                   GLsizei instances, GLint baseVertex)
+{
+    renderStats.drawCalls++;
+    glDrawElementsInstancedBaseVertex(mode, count, type, indices, instances, baseVertex);
+}
+
+inline void countedBindTexture(GLenum target, GLuint texture)
+{
+    renderStats.textureBinds++;
+    glBindTexture(target, texture);
+}
+inline void countedBindVertexArray(GLuint vao)
+{
+    renderStats.vaoBinds++;
+    glBindVertexArray(vao);
+}
+
+inline void countedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    renderStats.bufferAllocations++;
+    if (data != NULL)
+        renderStats.bytesUploaded += (unsigned long long)size;
+    glBufferData(target, size, data, usage);
+}
+inline void countedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    renderStats.bytesUploaded += (unsigned long long)size;
+    glBufferSubData(target, offset, size, data);
+}
+
+inline void countedUniform1i(GLint location, GLint value)
+{
+    renderStats.uniformCalls++;
+    glUniform1i(location, value);
+}
+inline void countedUniform1f(GLint location, GLfloat value)
+{
+    renderStats.uniformCalls++;
+    glUniform1f(location, value);
+}
+inline void countedUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    renderStats.uniformCalls++;
+    glUniform2fv(location, count, value);
+}
+inline void countedUniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+    renderStats.uniformCalls++;
+    glUniform3f(location, x, y, z);
+}
+inline void countedUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    renderStats.uniformCalls++;
+    glUniform3fv(location, count, value);
+}
+inline void countedUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    renderStats.uniformCalls++;
+    glUniform4fv(location, count, value);
+}
+inline void countedUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+    renderStats.uniformCalls++;
+    glUniformMatrix3fv(location, count, transpose, value);
+}
+inline void countedUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+    renderStats.uniformCalls++;
+    glUniformMatrix4fv(location, count, transpose, value);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstance;
+layout (location = 7) in float aVariant;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out float Variant;
+
+uniform mat4 part;
+uniform mat3 partNormal;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    // instance matrices rotate, translate and scale by SATELLITE_SCALE on every axis.
+    // a uniform scale only changes the normal's length, which specular.fs normalizes
+    // away, so mat3(aInstance) after the part's normal matrix is enough
+    FragPos = vec3(aInstance * part * vec4(aPos, 1.0));
+    Normal = mat3(aInstance) * (partNormal * aNormal);
+    TexCoords = aTexCoords;
+    Variant = aVariant;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,42 @@
+#include "scenetransforms.h"
+#include "geometry.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// degrees per second the light cubes circle at, the second one the other way round
+const float LIGHT_ORBIT_SPEED = 45.0f;
+
+static Geometry geometry;
+static const glm::vec3* lightPositions = geometry.GetLightPositions();
+
+glm::mat4 SatelliteBodyMatrix()
+{
+    glm::mat4 body = glm::scale(glm::mat4(1.0f), glm::vec3(SATELLITE_SCALE));
+    return glm::translate(body, -SATELLITE_BODY);
+}
+
+glm::mat4 Sgp4SatelliteMatrix(const float* position, const glm::mat4& body)
+{
+    glm::vec3 scenePosition = EARTH_CENTER + glm::vec3(position[0], position[2], -position[1]);
+    return glm::translate(glm::mat4(1.0f), scenePosition) * body;
+}
+
+glm::mat4 OrbitSatelliteMatrix(unsigned int index, unsigned int count, float trajectory)
+{
+    glm::mat4 satellite = glm::mat4(1.0f);
+    satellite = glm::rotate(satellite, glm::radians(index * 137.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    satellite = glm::rotate(satellite, glm::radians(trajectory * 50 + index * 360.0f / count), glm::vec3(0.0f, 1.0f, 1.00f));
+    return satellite;
+}
+
+glm::mat4 OrbitingLightMatrix(unsigned int light, double sceneTime)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    // code to orbit the lights around the scene
+    if (light == 1)
+        model = glm::rotate(model, (float)sceneTime * glm::radians(LIGHT_ORBIT_SPEED) * -1.0f * 2.0f, glm::vec3(0.0f, 1.0f, 0.f));
+    else
+        model = glm::rotate(model, (float)sceneTime * glm::radians(LIGHT_ORBIT_SPEED) * 2.0f, glm::vec3(0.0f, 1.5f, 0.f));
+    model = glm::translate(model, lightPositions[light]);
+    return glm::scale(model, glm::vec3(.25f));
+}
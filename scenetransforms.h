@@ -0,0 +1,29 @@
+#pragma once
+#ifndef SCENETRANSFORMS_H
+#define SCENETRANSFORMS_H
+
+#include <glm/glm.hpp>
+
+// where the earth ends up in the scene and where the satellite model was built,
+// used to place SGP4 satellites around the earth
+const glm::vec3 EARTH_CENTER(-.411121f, -1.2892f, -.65606f);
+const float EARTH_RADIUS = 2.55f;
+const glm::vec3 SATELLITE_BODY(-2.3804f, -0.855599f, 0.629999f);
+const float SATELLITE_SCALE = .02f;
+// the light cubes that circle the scene, the first two of Geometry::GetLightPositions
+const unsigned int ORBITING_LIGHT_COUNT = 2;
+
+// the model matrices the render loop builds every frame, microbench times these same functions
+
+// function to get the matrix that shrinks the satellite model and moves its body to the origin
+glm::mat4 SatelliteBodyMatrix();
+// function to put the satellite at an SGP4 position (x, y, z in TEME, z is the earth axis
+// and the scene's earth axis is y), body is SatelliteBodyMatrix()
+glm::mat4 Sgp4SatelliteMatrix(const float* position, const glm::mat4& body);
+// function to place satellite index of count without a catalog, every satellite orbits like
+// the original one, spread over orbit planes and phases
+glm::mat4 OrbitSatelliteMatrix(unsigned int index, unsigned int count, float trajectory);
+// function to get the model matrix of a light cube at sceneTime seconds
+glm::mat4 OrbitingLightMatrix(unsigned int light, double sceneTime);
+
+#endif
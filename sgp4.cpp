@@ -0,0 +1,644 @@
+#include "sgp4.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SGP4_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define SGP4_X86 0
+#endif
+
+/* SCALAR KERNEL, ALSO USED FOR THE OBJECTS LEFT OVER AFTER THE LAST FULL VECTOR */
+namespace sgp4scalar
+{
+    struct Vec
+    {
+        static const std::size_t WIDTH = 1;
+        double v;
+
+        Vec() {}
+        Vec(double v) : v(v) {}
+        static Vec load(const double* p) { return Vec(*p); }
+        void store(double* p) const { *p = v; }
+    };
+    typedef bool Mask;
+
+    inline Vec operator+(const Vec& a, const Vec& b) { return a.v + b.v; }
+    inline Vec operator-(const Vec& a, const Vec& b) { return a.v - b.v; }
+    inline Vec operator*(const Vec& a, const Vec& b) { return a.v * b.v; }
+    inline Vec operator/(const Vec& a, const Vec& b) { return a.v / b.v; }
+    inline Vec operator-(const Vec& a) { return -a.v; }
+    inline Mask operator<(const Vec& a, const Vec& b) { return a.v < b.v; }
+    inline Mask operator>(const Vec& a, const Vec& b) { return a.v > b.v; }
+    inline Mask operator>=(const Vec& a, const Vec& b) { return a.v >= b.v; }
+    inline Vec vsqrt(const Vec& a) { return std::sqrt(a.v); }
+    inline Vec vabs(const Vec& a) { return std::fabs(a.v); }
+    inline Vec vfloor(const Vec& a) { return std::floor(a.v); }
+    inline Vec vmin(const Vec& a, const Vec& b) { return a.v < b.v ? a.v : b.v; }
+    inline Vec vmax(const Vec& a, const Vec& b) { return a.v > b.v ? a.v : b.v; }
+    inline Vec vfma(const Vec& a, const Vec& b, const Vec& c) { return a.v * b.v + c.v; }
+    inline Vec vselect(Mask m, const Vec& a, const Vec& b) { return m ? a : b; }
+    inline bool vall(Mask m) { return m; }
+
+#include "sgp4kernel.inl"
+}
+
+#if SGP4_X86
+/* SSE2 KERNEL, 2 OBJECTS PER INSTRUCTION, PART OF EVERY X86-64 CPU */
+namespace sgp4sse2
+{
+    struct Vec
+    {
+        static const std::size_t WIDTH = 2;
+        __m128d v;
+
+        Vec() {}
+        Vec(__m128d v) : v(v) {}
+        Vec(double d) : v(_mm_set1_pd(d)) {}
+        static Vec load(const double* p) { return _mm_loadu_pd(p); }
+        void store(double* p) const { _mm_storeu_pd(p, v); }
+    };
+    struct Mask
+    {
+        __m128d m;
+
+        Mask(__m128d m) : m(m) {}
+    };
+
+    inline Vec operator+(const Vec& a, const Vec& b) { return _mm_add_pd(a.v, b.v); }
+    inline Vec operator-(const Vec& a, const Vec& b) { return _mm_sub_pd(a.v, b.v); }
+    inline Vec operator*(const Vec& a, const Vec& b) { return _mm_mul_pd(a.v, b.v); }
+    inline Vec operator/(const Vec& a, const Vec& b) { return _mm_div_pd(a.v, b.v); }
+    inline Vec operator-(const Vec& a) { return _mm_xor_pd(a.v, _mm_set1_pd(-0.0)); }
+    inline Mask operator<(const Vec& a, const Vec& b) { return _mm_cmplt_pd(a.v, b.v); }
+    inline Mask operator>(const Vec& a, const Vec& b) { return _mm_cmpgt_pd(a.v, b.v); }
+    inline Mask operator>=(const Vec& a, const Vec& b) { return _mm_cmpge_pd(a.v, b.v); }
+    inline Mask operator&(const Mask& a, const Mask& b) { return _mm_and_pd(a.m, b.m); }
+    inline Vec vsqrt(const Vec& a) { return _mm_sqrt_pd(a.v); }
+    inline Vec vabs(const Vec& a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+    inline Vec vmin(const Vec& a, const Vec& b) { return _mm_min_pd(a.v, b.v); }
+    inline Vec vmax(const Vec& a, const Vec& b) { return _mm_max_pd(a.v, b.v); }
+    inline Vec vfma(const Vec& a, const Vec& b, const Vec& c) { return _mm_add_pd(_mm_mul_pd(a.v, b.v), c.v); }
+    inline Vec vselect(const Mask& m, const Vec& a, const Vec& b) { return _mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v)); }
+    inline bool vall(const Mask& m) { return _mm_movemask_pd(m.m) == 3; }
+
+    // SSE2 has no floor: round to nearest with the 1.5 * 2^52 trick, then step down where that rounded up
+    inline Vec vfloor(const Vec& a)
+    {
+        const __m128d MAGIC = _mm_set1_pd(6755399441055744.0);
+        __m128d rounded = _mm_sub_pd(_mm_add_pd(a.v, MAGIC), MAGIC);
+        return _mm_sub_pd(rounded, _mm_and_pd(_mm_cmpgt_pd(rounded, a.v), _mm_set1_pd(1.0)));
+    }
+
+#include "sgp4kernel.inl"
+}
+
+/* AVX2 KERNEL, 4 OBJECTS PER INSTRUCTION, ONLY CALLED WHEN THE CPU HAS AVX2 AND FMA */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace sgp4avx2
+{
+    struct Vec
+    {
+        static const std::size_t WIDTH = 4;
+        __m256d v;
+
+        Vec() {}
+        Vec(__m256d v) : v(v) {}
+        Vec(double d) : v(_mm256_set1_pd(d)) {}
+        static Vec load(const double* p) { return _mm256_loadu_pd(p); }
+        void store(double* p) const { _mm256_storeu_pd(p, v); }
+    };
+    struct Mask
+    {
+        __m256d m;
+
+        Mask(__m256d m) : m(m) {}
+    };
+
+    inline Vec operator+(const Vec& a, const Vec& b) { return _mm256_add_pd(a.v, b.v); }
+    inline Vec operator-(const Vec& a, const Vec& b) { return _mm256_sub_pd(a.v, b.v); }
+    inline Vec operator*(const Vec& a, const Vec& b) { return _mm256_mul_pd(a.v, b.v); }
+    inline Vec operator/(const Vec& a, const Vec& b) { return _mm256_div_pd(a.v, b.v); }
+    inline Vec operator-(const Vec& a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+    inline Mask operator<(const Vec& a, const Vec& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+    inline Mask operator>(const Vec& a, const Vec& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+    inline Mask operator>=(const Vec& a, const Vec& b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ); }
+    inline Mask operator&(const Mask& a, const Mask& b) { return _mm256_and_pd(a.m, b.m); }
+    inline Vec vsqrt(const Vec& a) { return _mm256_sqrt_pd(a.v); }
+    inline Vec vabs(const Vec& a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+    inline Vec vfloor(const Vec& a) { return _mm256_floor_pd(a.v); }
+    inline Vec vmin(const Vec& a, const Vec& b) { return _mm256_min_pd(a.v, b.v); }
+    inline Vec vmax(const Vec& a, const Vec& b) { return _mm256_max_pd(a.v, b.v); }
+    inline Vec vfma(const Vec& a, const Vec& b, const Vec& c) { return _mm256_fmadd_pd(a.v, b.v, c.v); }
+    inline Vec vselect(const Mask& m, const Vec& a, const Vec& b) { return _mm256_blendv_pd(b.v, a.v, m.m); }
+    inline bool vall(const Mask& m) { return _mm256_movemask_pd(m.m) == 15; }
+
+#include "sgp4kernel.inl"
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// function to ask the cpu and the os whether the AVX2 kernel can run
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif
+
+
+
+/* TWO LINE ELEMENTS */
+
+// function to read the columns first to last (1 based, as the format documents count them) as a number.
+// the fields are plain decimals like "-12.3456", read as one integer and a power of ten, without strtod
+static bool parseColumns(const char* line, std::size_t length, int first, int last, double& value)
+{
+    static const double POWERS[16] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+    if ((std::size_t)last > length)
+        return false;
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int decimals = -1;
+    bool negative = false;
+    for (int c = first - 1; c < last; c++)
+    {
+        char ch = line[c];
+        if (ch >= '0' && ch <= '9')
+        {
+            mantissa = mantissa * 10 + (unsigned long long)(ch - '0');
+            digits++;
+            if (decimals >= 0)
+                decimals++;
+        }
+        else if (ch == '.' && decimals < 0)
+            decimals = 0;
+        else if ((ch == '-' || ch == '+') && digits == 0 && decimals < 0)
+            negative = ch == '-';
+        else if (ch != ' ')
+            return false;
+    }
+    if (digits == 0 || digits > 15)
+        return false;
+    value = (double)mantissa / POWERS[decimals > 0 ? decimals : 0];
+    if (negative)
+        value = -value;
+    return true;
+}
+
+// function to read an exponent field like " 12345-4" (= 0.12345e-4), used for bstar
+static bool parseExponent(const char* line, std::size_t length, int first, double& value)
+{
+    if ((std::size_t)first + 7 > length)
+        return false;
+    const char* field = line + first - 1;
+    double mantissa = 0;
+    for (int i = 1; i <= 5; i++)
+    {
+        char c = field[i] == ' ' ? '0' : field[i];
+        if (c < '0' || c > '9')
+            return false;
+        mantissa = mantissa * 10 + (c - '0');
+    }
+    char exponent = field[7] == ' ' ? '0' : field[7];
+    if (exponent < '0' || exponent > '9' || (field[6] != '-' && field[6] != '+' && field[6] != ' ' && field[6] != '0'))
+        return false;
+    value = mantissa * 1.0e-5 * std::pow(10.0, field[6] == '-' ? -(exponent - '0') : (exponent - '0'));
+    if (field[0] == '-')
+        value = -value;
+    return true;
+}
+
+// function to check the modulo 10 checksum in column 69, lines without one are accepted
+static bool checksumMatches(const char* line, std::size_t length)
+{
+    if (length < 69 || line[68] < '0' || line[68] > '9')
+        return true;
+    int sum = 0;
+    for (int c = 0; c < 68; c++)
+    {
+        if (line[c] >= '0' && line[c] <= '9')
+            sum += line[c] - '0';
+        else if (line[c] == '-')
+            sum += 1;
+    }
+    return sum % 10 == line[68] - '0';
+}
+
+bool ParseTwoLineElement(const char* line1, std::size_t length1, const char* line2, std::size_t length2, TwoLineElement& tle)
+{
+    const double DEG = 3.14159265358979323846 / 180.0;
+    if (length1 < 61 || length2 < 63 || line1[0] != '1' || line2[0] != '2')
+        return false;
+    if (!checksumMatches(line1, length1) || !checksumMatches(line2, length2))
+        return false;
+
+    // catalog numbers above 99999 use the alpha-5 form, a letter (without I and O) for the leading digits
+    double number;
+    char lead = line1[2];
+    if (lead >= 'A' && lead <= 'Z')
+    {
+        if (!parseColumns(line1, length1, 4, 7, number))
+            return false;
+        int letter = 10 + (lead - 'A') - (lead > 'I' ? 1 : 0) - (lead > 'O' ? 1 : 0);
+        number += letter * 10000;
+    }
+    else if (!parseColumns(line1, length1, 3, 7, number))
+        return false;
+    tle.catalogNumber = (int)number;
+
+    double year, day, value;
+    if (!parseColumns(line1, length1, 19, 20, year) || !parseColumns(line1, length1, 21, 32, day))
+        return false;
+    tle.epoch = JulianDateFromEpoch(year < 57 ? 2000 + (int)year : 1900 + (int)year, day);
+    if (!parseExponent(line1, length1, 54, tle.bstar))
+        return false;
+
+    if (!parseColumns(line2, length2, 9, 16, value))
+        return false;
+    tle.inclination = value * DEG;
+    if (!parseColumns(line2, length2, 18, 25, value))
+        return false;
+    tle.rightAscension = value * DEG;
+    if (!parseColumns(line2, length2, 27, 33, value))
+        return false;
+    tle.eccentricity = value * 1.0e-7;
+    if (!parseColumns(line2, length2, 35, 42, value))
+        return false;
+    tle.argumentOfPerigee = value * DEG;
+    if (!parseColumns(line2, length2, 44, 51, value))
+        return false;
+    tle.meanAnomaly = value * DEG;
+    if (!parseColumns(line2, length2, 53, 63, value))
+        return false;
+    tle.meanMotion = value * 2.0 * 3.14159265358979323846 / 1440.0;
+    return true;
+}
+
+double JulianDateFromEpoch(int year, double dayOfYear)
+{
+    // julian date of january 0 of the year, valid from 1901 to 2099
+    return 367.0 * year - std::floor(7.0 * year * 0.25) + 30.0 + 1721013.5 + dayOfYear;
+}
+
+double JulianDateNow()
+{
+    double seconds = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return 2440587.5 + seconds / 86400.0;
+}
+
+
+
+/* CATALOG */
+
+Sgp4Catalog::Sgp4Catalog() : count(0), deepSpaceCount(0), kernel(SGP4_KERNEL_SCALAR)
+{
+    setKernel(SGP4_KERNEL_AUTO);
+}
+
+void Sgp4Catalog::clear()
+{
+    elements = Sgp4Elements();
+    catalogNumbers.clear();
+    count = 0;
+    deepSpaceCount = 0;
+}
+
+// the fields of Sgp4Elements in one list
+#define SGP4_ELEMENT_FIELDS(X) \
+    X(epoch) X(meanAnomaly) X(meanAnomalyRate) X(perigee) X(perigeeRate) X(node) X(nodeRate) X(nodeDrag) \
+    X(meanMotion) X(eccentricity) X(semiMajorAxis) X(cc1) X(bstarCc4) X(bstarCc5) X(t2cof) X(t3cof) \
+    X(t4cof) X(t5cof) X(d2) X(d3) X(d4) X(omgcof) X(xmcof) X(eta) X(delmo) X(sinmao) X(aycof) X(xlcof) \
+    X(con41) X(x1mth2) X(x7thm1) X(inclination) X(sinInclination) X(cosInclination)
+
+void Sgp4Catalog::reserve(std::size_t capacity)
+{
+#define SGP4_RESERVE(field) elements.field.reserve(capacity);
+    SGP4_ELEMENT_FIELDS(SGP4_RESERVE)
+#undef SGP4_RESERVE
+    catalogNumbers.reserve(capacity);
+}
+
+// function to compute the SGP4 constants of an object (sgp4init of the Spacetrack report #3
+// revision by Vallado et al., near earth branch) and append them to the arrays
+bool Sgp4Catalog::add(const TwoLineElement& tle)
+{
+    const double PI = 3.14159265358979323846;
+    const double XKE = 0.0743669161331734132;
+    const double J2 = 0.001082616;
+    const double J3OJ2 = -0.00000253881 / J2;
+    const double J4 = -0.00000165597;
+    const double RE = SGP4_EARTH_RADIUS_KM;
+    const double X2O3 = 2.0 / 3.0;
+
+    double ecco = tle.eccentricity;
+    double inclo = tle.inclination;
+    double argpo = tle.argumentOfPerigee;
+    double mo = tle.meanAnomaly;
+    double bstar = tle.bstar;
+    if (ecco < 0.0 || ecco >= 1.0 || tle.meanMotion <= 0.0)
+        return false;
+
+    // un-kozai the mean motion
+    double omeosq = 1.0 - ecco * ecco;
+    double rteosq = std::sqrt(omeosq);
+    double cosio = std::cos(inclo);
+    double sinio = std::sin(inclo);
+    double cosio2 = cosio * cosio;
+    double ak = std::pow(XKE / tle.meanMotion, X2O3);
+    double d1 = 0.75 * J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+    double del = d1 / (ak * ak);
+    double adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+    del = d1 / (adel * adel);
+    double no = tle.meanMotion / (1.0 + del);
+    double ao = std::pow(XKE / no, X2O3);
+    double po = ao * omeosq;
+    double con42 = 1.0 - 5.0 * cosio2;
+    double con41 = -con42 - cosio2 - cosio2;
+    double pinvsq = 1.0 / (po * po);
+    double rp = ao * (1.0 - ecco);
+    if (rp < 1.0)
+        return false;
+
+    bool deepSpace = 2.0 * PI / no >= 225.0;
+    bool simple = deepSpace || rp < 220.0 / RE + 1.0;
+
+    // atmospheric density parameters, lowered for low perigees
+    double sfour = 78.0 / RE + 1.0;
+    double qzms24 = std::pow((120.0 - 78.0) / RE, 4.0);
+    double perige = (rp - 1.0) * RE;
+    if (perige < 156.0)
+    {
+        sfour = perige < 98.0 ? 20.0 : perige - 78.0;
+        qzms24 = std::pow((120.0 - sfour) / RE, 4.0);
+        sfour = sfour / RE + 1.0;
+    }
+    double tsi = 1.0 / (ao - sfour);
+    double eta = ao * ecco * tsi;
+    double etasq = eta * eta;
+    double eeta = ecco * eta;
+    double psisq = std::fabs(1.0 - etasq);
+    double coef = qzms24 * std::pow(tsi, 4.0);
+    double coef1 = coef / std::pow(psisq, 3.5);
+    double cc2 = coef1 * no * (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq))
+                 + 0.375 * J2 * tsi / psisq * con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+    double cc1 = bstar * cc2;
+    double cc3 = ecco > 1.0e-4 ? -2.0 * coef * tsi * J3OJ2 * no * sinio / ecco : 0.0;
+    double x1mth2 = 1.0 - cosio2;
+    double cc4 = 2.0 * no * coef1 * ao * omeosq * (eta * (2.0 + 0.5 * etasq) + ecco * (0.5 + 2.0 * etasq)
+                 - J2 * tsi / (ao * psisq) * (-3.0 * con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta))
+                 + 0.75 * x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * std::cos(2.0 * argpo)));
+    double cc5 = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+
+    // secular rates
+    double cosio4 = cosio2 * cosio2;
+    double temp1 = 1.5 * J2 * pinvsq * no;
+    double temp2 = 0.5 * temp1 * J2 * pinvsq;
+    double temp3 = -0.46875 * J4 * pinvsq * pinvsq * no;
+    double mdot = no + 0.5 * temp1 * rteosq * con41 + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+    double argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4)
+                     + temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+    double xhdot1 = -temp1 * cosio;
+    double nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio;
+    double delmotemp = 1.0 + eta * std::cos(mo);
+
+    // the simplified model drops the higher order drag terms, the kernel sees zeros for them
+    double d2 = 0.0, d3 = 0.0, d4 = 0.0, t3cof = 0.0, t4cof = 0.0, t5cof = 0.0;
+    double omgcof = 0.0, xmcof = 0.0, bstarCc5 = 0.0;
+    if (!simple)
+    {
+        double cc1sq = cc1 * cc1;
+        d2 = 4.0 * ao * tsi * cc1sq;
+        double temp = d2 * tsi * cc1 / 3.0;
+        d3 = (17.0 * ao + sfour) * temp;
+        d4 = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * cc1;
+        t3cof = d2 + 2.0 * cc1sq;
+        t4cof = 0.25 * (3.0 * d3 + cc1 * (12.0 * d2 + 10.0 * cc1sq));
+        t5cof = 0.2 * (3.0 * d4 + 12.0 * cc1 * d3 + 6.0 * d2 * d2 + 15.0 * cc1sq * (2.0 * d2 + cc1sq));
+        omgcof = bstar * cc3 * std::cos(argpo);
+        xmcof = ecco > 1.0e-4 ? -X2O3 * coef * bstar / eeta : 0.0;
+        bstarCc5 = bstar * cc5;
+    }
+
+    elements.epoch.push_back(tle.epoch);
+    elements.meanAnomaly.push_back(mo);
+    elements.meanAnomalyRate.push_back(mdot);
+    elements.perigee.push_back(argpo);
+    elements.perigeeRate.push_back(argpdot);
+    elements.node.push_back(tle.rightAscension);
+    elements.nodeRate.push_back(nodedot);
+    elements.nodeDrag.push_back(3.5 * omeosq * xhdot1 * cc1);
+    elements.meanMotion.push_back(no);
+    elements.eccentricity.push_back(ecco);
+    elements.semiMajorAxis.push_back(ao);
+    elements.cc1.push_back(cc1);
+    elements.bstarCc4.push_back(bstar * cc4);
+    elements.bstarCc5.push_back(bstarCc5);
+    elements.t2cof.push_back(1.5 * cc1);
+    elements.t3cof.push_back(t3cof);
+    elements.t4cof.push_back(t4cof);
+    elements.t5cof.push_back(t5cof);
+    elements.d2.push_back(d2);
+    elements.d3.push_back(d3);
+    elements.d4.push_back(d4);
+    elements.omgcof.push_back(omgcof);
+    elements.xmcof.push_back(xmcof);
+    elements.eta.push_back(eta);
+    elements.delmo.push_back(delmotemp * delmotemp * delmotemp);
+    elements.sinmao.push_back(std::sin(mo));
+    elements.aycof.push_back(-0.5 * J3OJ2 * sinio);
+    elements.xlcof.push_back(-0.25 * J3OJ2 * sinio * (3.0 + 5.0 * cosio) / std::max(std::fabs(1.0 + cosio), 1.5e-12));
+    elements.con41.push_back(con41);
+    elements.x1mth2.push_back(x1mth2);
+    elements.x7thm1.push_back(7.0 * cosio2 - 1.0);
+    elements.inclination.push_back(inclo);
+    elements.sinInclination.push_back(sinio);
+    elements.cosInclination.push_back(cosio);
+    catalogNumbers.push_back(tle.catalogNumber);
+    count++;
+    if (deepSpace)
+        deepSpaceCount++;
+    return true;
+}
+
+std::size_t Sgp4Catalog::size() const
+{
+    return count;
+}
+
+std::size_t Sgp4Catalog::getDeepSpaceCount() const
+{
+    return deepSpaceCount;
+}
+
+double Sgp4Catalog::getLatestEpoch() const
+{
+    double latest = 0.0;
+    for (std::size_t i = 0; i < count; i++)
+        latest = std::max(latest, elements.epoch[i]);
+    return latest;
+}
+
+int Sgp4Catalog::getCatalogNumber(std::size_t index) const
+{
+    return catalogNumbers[index];
+}
+
+// function to write the position of every object at julianDate, scale converts km to scene units
+void Sgp4Catalog::propagate(double julianDate, float* positions, float scale) const
+{
+    propagate(julianDate, positions, scale, 0, count);
+}
+
+// function to propagate the objects [begin, end), so the caller can split the catalog over threads
+void Sgp4Catalog::propagate(double julianDate, float* positions, float scale, std::size_t begin, std::size_t end) const
+{
+    std::size_t done = begin;
+#if SGP4_X86
+    if (kernel == SGP4_KERNEL_AVX2)
+        done = sgp4avx2::propagateRange(elements, julianDate, scale, positions, begin, end);
+    else if (kernel == SGP4_KERNEL_SSE2)
+        done = sgp4sse2::propagateRange(elements, julianDate, scale, positions, begin, end);
+#endif
+    sgp4scalar::propagateRange(elements, julianDate, scale, positions, done, end);
+}
+
+// function to choose the kernel, unsupported ones fall back to the widest supported one
+Sgp4Kernel Sgp4Catalog::setKernel(Sgp4Kernel kernel)
+{
+    if (kernel == SGP4_KERNEL_AUTO || !isKernelSupported(kernel))
+    {
+        if (isKernelSupported(SGP4_KERNEL_AVX2))
+            kernel = SGP4_KERNEL_AVX2;
+        else if (isKernelSupported(SGP4_KERNEL_SSE2))
+            kernel = SGP4_KERNEL_SSE2;
+        else
+            kernel = SGP4_KERNEL_SCALAR;
+    }
+    this->kernel = kernel;
+    return kernel;
+}
+
+Sgp4Kernel Sgp4Catalog::getKernel() const
+{
+    return kernel;
+}
+
+bool Sgp4Catalog::isKernelSupported(Sgp4Kernel kernel)
+{
+#if SGP4_X86
+    static const bool avx2 = cpuHasAvx2();
+    if (kernel == SGP4_KERNEL_AVX2)
+        return avx2;
+    if (kernel == SGP4_KERNEL_SSE2)
+        return true;
+#endif
+    return kernel == SGP4_KERNEL_SCALAR;
+}
+
+const char* Sgp4Catalog::getKernelName(Sgp4Kernel kernel)
+{
+    switch (kernel)
+    {
+    case SGP4_KERNEL_SCALAR: return "scalar";
+    case SGP4_KERNEL_SSE2: return "sse2";
+    case SGP4_KERNEL_AVX2: return "avx2";
+    default: return "auto";
+    }
+}
+
+
+
+/* BENCHMARK */
+
+// function to fill a catalog with count low earth orbits spread over planes and phases
+void AddSyntheticElements(Sgp4Catalog& catalog, std::size_t count, double epoch)
+{
+    const double DEG = 3.14159265358979323846 / 180.0;
+    catalog.reserve(catalog.size() + count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        TwoLineElement tle;
+        memset(&tle, 0, sizeof(tle));
+        tle.catalogNumber = (int)(90000 + i);
+        tle.epoch = epoch - (double)(i % 30);
+        tle.bstar = 1.0e-5 * (double)(1 + i % 50);
+        tle.inclination = (double)(i % 99) * DEG;
+        tle.rightAscension = (double)(i * 137 % 360) * DEG;
+        tle.eccentricity = 0.0001 + 0.0005 * (double)(i % 40);
+        tle.argumentOfPerigee = (double)(i * 53 % 360) * DEG;
+        tle.meanAnomaly = (double)(i * 29 % 360) * DEG;
+        tle.meanMotion = (14.0 + 2.0 * (double)(i % 17) / 16.0) * 2.0 * 3.14159265358979323846 / 1440.0;
+        catalog.add(tle);
+    }
+}
+
+// function to time every kernel the cpu supports on this one thread, so the numbers are per core
+void BenchmarkSgp4(Sgp4Catalog& catalog, double seconds)
+{
+    std::vector<float> positions(catalog.size() * 3);
+    if (positions.empty())
+        return;
+    Sgp4Kernel previous = catalog.getKernel();
+    double julianDate = JulianDateNow();
+    std::cout << "SGP4 benchmark, " << catalog.size() << " objects (" << catalog.getDeepSpaceCount()
+              << " deep space, propagated near earth)" << std::endl;
+
+    for (int k = SGP4_KERNEL_SCALAR; k < SGP4_KERNEL_AUTO; k++)
+    {
+        Sgp4Kernel kernel = (Sgp4Kernel)k;
+        if (!Sgp4Catalog::isKernelSupported(kernel))
+        {
+            std::cout << "  " << Sgp4Catalog::getKernelName(kernel) << ": not supported by this cpu" << std::endl;
+            continue;
+        }
+        catalog.setKernel(kernel);
+        catalog.propagate(julianDate, &positions[0]);
+
+        // a minute of simulated time per pass so the kepler iterations do not see the same input
+        std::size_t passes = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while (elapsed < seconds)
+        {
+            catalog.propagate(julianDate + (double)passes / 1440.0, &positions[0]);
+            passes++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        double rate = (double)passes * (double)catalog.size() / elapsed;
+        std::cout << "  " << Sgp4Catalog::getKernelName(kernel) << ": " << (std::size_t)rate
+                  << " objects/s per core, " << elapsed * 1000.0 / (double)passes << " ms per pass" << std::endl;
+    }
+    catalog.setKernel(previous);
+}
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef SGP4_H
+#define SGP4_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// WGS72 earth radius used by SGP4, positions come out in km in the TEME frame
+const double SGP4_EARTH_RADIUS_KM = 6378.135;
+
+// mean elements of one object as read from a two line element set
+struct TwoLineElement
+{
+    char name[25];
+    int catalogNumber;
+    double epoch;               // julian date
+    double bstar;               // drag term, 1 / earth radii
+    double inclination;         // radians
+    double rightAscension;      // radians
+    double eccentricity;
+    double argumentOfPerigee;   // radians
+    double meanAnomaly;         // radians
+    double meanMotion;          // radians per minute
+};
+
+// function to read one two line element set, lines are not null terminated.
+// catalog files are read by LoadCatalogFile in catalogloader.h
+bool ParseTwoLineElement(const char* line1, std::size_t length1, const char* line2, std::size_t length2, TwoLineElement& tle);
+double JulianDateFromEpoch(int year, double dayOfYear);
+double JulianDateNow();
+
+// the propagation kernels, AUTO picks the widest one the cpu runs
+enum Sgp4Kernel
+{
+    SGP4_KERNEL_SCALAR,
+    SGP4_KERNEL_SSE2,
+    SGP4_KERNEL_AVX2,
+    SGP4_KERNEL_AUTO
+};
+
+// SGP4 constants of every object, one array per constant so a kernel loads
+// 2 (SSE2) or 4 (AVX2) objects with one instruction
+struct Sgp4Elements
+{
+    std::vector<double> epoch;
+    std::vector<double> meanAnomaly, meanAnomalyRate;
+    std::vector<double> perigee, perigeeRate;
+    std::vector<double> node, nodeRate, nodeDrag;
+    std::vector<double> meanMotion, eccentricity, semiMajorAxis;
+    std::vector<double> cc1, bstarCc4, bstarCc5, t2cof, t3cof, t4cof, t5cof;
+    std::vector<double> d2, d3, d4;
+    std::vector<double> omgcof, xmcof, eta, delmo, sinmao;
+    std::vector<double> aycof, xlcof, con41, x1mth2, x7thm1;
+    std::vector<double> inclination, sinInclination, cosInclination;
+};
+
+// near earth SGP4 for a whole catalog. propagate() writes x, y, z floats per
+// object into one contiguous buffer the renderer can upload as is. objects
+// that decayed or whose elements went invalid are written as (0, 0, 0).
+// objects with periods of 225 minutes or more need the deep space terms,
+// which are not modeled: they are propagated with the near earth terms only
+class Sgp4Catalog
+{
+public:
+    Sgp4Catalog();
+
+    void clear();
+    void reserve(std::size_t count);
+    bool add(const TwoLineElement& tle);
+    std::size_t size() const;
+    std::size_t getDeepSpaceCount() const;
+    int getCatalogNumber(std::size_t index) const;
+    // function to get the epoch of the newest element set, 0 when the catalog is empty
+    double getLatestEpoch() const;
+
+    void propagate(double julianDate, float* positions, float scale = 1.0f) const;
+    void propagate(double julianDate, float* positions, float scale, std::size_t begin, std::size_t end) const;
+
+    Sgp4Kernel setKernel(Sgp4Kernel kernel);
+    Sgp4Kernel getKernel() const;
+    static bool isKernelSupported(Sgp4Kernel kernel);
+    static const char* getKernelName(Sgp4Kernel kernel);
+
+private:
+    Sgp4Elements elements;
+    std::vector<int> catalogNumbers;
+    std::size_t count;
+    std::size_t deepSpaceCount;
+    Sgp4Kernel kernel;
+};
+
+// functions for the --sgp4-benchmark flag
+void AddSyntheticElements(Sgp4Catalog& catalog, std::size_t count, double epoch);
+void BenchmarkSgp4(Sgp4Catalog& catalog, double seconds = 1.0);
+
+#endif
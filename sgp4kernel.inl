@@ -0,0 +1,224 @@
+// near earth SGP4 propagation written once against a vector type. sgp4.cpp
+// includes this file inside one namespace per instruction set, each of which
+// defines Vec (WIDTH doubles), Mask and the operations used below:
+// + - * / and unary -, comparisons, vsqrt, vabs, vfloor, vmin, vmax, vfma,
+// vselect, vall, Vec::load and Vec::store.
+// sin, cos and atan2 are polynomials (after Cephes), so every lane of every
+// kernel takes the same path and no libm call breaks the vector code
+
+const double SGP4_PI = 3.14159265358979323846;
+const double SGP4_TWO_PI = 6.28318530717958647692;
+
+// horner evaluation of c[0] * x^(n-1) + ... + c[n-1]
+static inline Vec polynomial(const Vec& x, const double* c, int n)
+{
+    Vec result(c[0]);
+    for (int i = 1; i < n; i++)
+        result = vfma(result, x, Vec(c[i]));
+    return result;
+}
+
+// angle reduced to [0, 2 pi)
+static inline Vec wrapTwoPi(const Vec& angle)
+{
+    return angle - Vec(SGP4_TWO_PI) * vfloor(angle * Vec(1.0 / SGP4_TWO_PI));
+}
+
+static inline void vsincos(const Vec& x, Vec& sine, Vec& cosine)
+{
+    static const double SIN_COEF[6] = { 1.58962301576546568060E-10, -2.50507477628578072866E-8,
+                                        2.75573136213857245213E-6, -1.98412698295895385996E-4,
+                                        8.33333333332211858878E-3, -1.66666666666666307295E-1 };
+    static const double COS_COEF[6] = { -1.13585365213876817300E-11, 2.08757008419747316778E-9,
+                                        -2.75573141792967388112E-7, 2.48015872888517045348E-5,
+                                        -1.38888888888730564116E-3, 4.16666666666665929218E-2 };
+    // pi / 4 split in 3 parts so the reduction stays exact
+    const double DP1 = 7.85398125648498535156E-1;
+    const double DP2 = 3.77489470793079817668E-8;
+    const double DP3 = 2.69515142907905952645E-15;
+
+    Vec ax = vabs(x);
+    Vec j = vfloor(ax * Vec(4.0 / SGP4_PI));
+    j = j + (j - Vec(2.0) * vfloor(j * Vec(0.5)));      // round the octant up to even
+    Vec z = ((ax - j * Vec(DP1)) - j * Vec(DP2)) - j * Vec(DP3);
+    Vec zz = z * z;
+    Vec ps = vfma(z * zz, polynomial(zz, SIN_COEF, 6), z);
+    Vec pc = vfma(zz * zz, polynomial(zz, COS_COEF, 6), Vec(1.0) - Vec(0.5) * zz);
+
+    // octant 0, 2, 4 or 6 picks the polynomial and the signs
+    Vec octant = j - Vec(8.0) * vfloor(j * Vec(0.125));
+    Vec quarter = octant - Vec(4.0) * vfloor(octant * Vec(0.25));
+    Mask swap = quarter > Vec(1.0);
+    Vec shifted = octant + Vec(2.0);
+    shifted = shifted - Vec(8.0) * vfloor(shifted * Vec(0.125));
+
+    sine = vselect(swap, pc, ps);
+    sine = vselect(octant > Vec(3.0), -sine, sine);
+    sine = vselect(x < Vec(0.0), -sine, sine);
+    cosine = vselect(swap, ps, pc);
+    cosine = vselect(shifted > Vec(3.0), -cosine, cosine);
+}
+
+static inline Vec vatan2(const Vec& y, const Vec& x)
+{
+    static const double P[5] = { -8.750608600031904122785E-1, -1.615753718733365076637E1,
+                                 -7.500855792314704667340E1, -1.228866684490136173410E2,
+                                 -6.485021904942025371773E1 };
+    static const double Q[6] = { 1.0, 2.485846490142306297962E1, 1.650270098316988542046E2,
+                                 4.328810604912902668951E2, 4.853903996359136964868E2,
+                                 1.945506571482613964425E2 };
+    const double MOREBITS = 6.123233995736765886130E-17;
+
+    // atan of the smaller over the larger side, so t is in [0, 1]
+    Vec ax = vabs(x);
+    Vec ay = vabs(y);
+    Vec larger = vmax(ax, ay);
+    larger = vselect(larger > Vec(0.0), larger, Vec(1.0));
+    Vec t = vmin(ax, ay) / larger;
+
+    // above tan(3 pi / 8) is not reachable, above .66 use atan(t) = pi / 4 + atan((t - 1) / (t + 1))
+    Mask reduced = t > Vec(0.66);
+    t = vselect(reduced, (t - Vec(1.0)) / (t + Vec(1.0)), t);
+    Vec zz = t * t;
+    Vec angle = vfma(t * zz, polynomial(zz, P, 5) / polynomial(zz, Q, 6), t);
+    angle = angle + vselect(reduced, Vec(SGP4_PI / 4 + 0.5 * MOREBITS), Vec(0.0));
+
+    angle = vselect(ay > ax, Vec(SGP4_PI / 2) - angle, angle);
+    angle = vselect(x < Vec(0.0), Vec(SGP4_PI) - angle, angle);
+    return vselect(y < Vec(0.0), -angle, angle);
+}
+
+// function to propagate objects [index, index + WIDTH) and write the first lanes of them
+static void propagateBlock(const Sgp4Elements& e, std::size_t index, double julianDate, double scale,
+                           float* positions, std::size_t lanes)
+{
+    const double J2 = 0.001082616;
+
+    // minutes since the epoch of every object
+    Vec t = (Vec(julianDate) - Vec::load(&e.epoch[index])) * Vec(1440.0);
+    Vec t2 = t * t;
+    Vec t3 = t2 * t;
+    Vec t4 = t3 * t;
+
+    // secular gravity and drag, the simplified objects have zero high order terms
+    Vec xmdf = vfma(Vec::load(&e.meanAnomalyRate[index]), t, Vec::load(&e.meanAnomaly[index]));
+    Vec argpdf = vfma(Vec::load(&e.perigeeRate[index]), t, Vec::load(&e.perigee[index]));
+    Vec nodedf = vfma(Vec::load(&e.nodeRate[index]), t, Vec::load(&e.node[index]));
+    Vec nodem = vfma(Vec::load(&e.nodeDrag[index]), t2, nodedf);
+
+    Vec sinxmdf, cosxmdf;
+    vsincos(xmdf, sinxmdf, cosxmdf);
+    Vec delmtemp = Vec(1.0) + Vec::load(&e.eta[index]) * cosxmdf;
+    Vec delm = Vec::load(&e.xmcof[index]) * (delmtemp * delmtemp * delmtemp - Vec::load(&e.delmo[index]));
+    Vec temp = Vec::load(&e.omgcof[index]) * t + delm;
+    Vec mm = xmdf + temp;
+    Vec argpm = argpdf - temp;
+
+    Vec tempa = Vec(1.0) - Vec::load(&e.cc1[index]) * t - Vec::load(&e.d2[index]) * t2
+                - Vec::load(&e.d3[index]) * t3 - Vec::load(&e.d4[index]) * t4;
+    Vec sinmm, cosmm;
+    vsincos(mm, sinmm, cosmm);
+    Vec tempe = Vec::load(&e.bstarCc4[index]) * t
+                + Vec::load(&e.bstarCc5[index]) * (sinmm - Vec::load(&e.sinmao[index]));
+    Vec templ = Vec::load(&e.t2cof[index]) * t2 + Vec::load(&e.t3cof[index]) * t3
+                + t4 * vfma(t, Vec::load(&e.t5cof[index]), Vec::load(&e.t4cof[index]));
+
+    Vec am = Vec::load(&e.semiMajorAxis[index]) * tempa * tempa;
+    Vec em = Vec::load(&e.eccentricity[index]) - tempe;
+    Mask valid = (em < Vec(1.0)) & (em >= Vec(-0.001));
+    em = vmax(em, Vec(1.0e-6));
+    mm = vfma(Vec::load(&e.meanMotion[index]), templ, mm);
+
+    // mean longitude and the angles reduced to one turn
+    Vec xlm = mm + argpm + nodem;
+    nodem = wrapTwoPi(nodem);
+    argpm = wrapTwoPi(argpm);
+    xlm = wrapTwoPi(xlm);
+    mm = wrapTwoPi(xlm - argpm - nodem);
+
+    // long period periodics
+    Vec sinargp, cosargp;
+    vsincos(argpm, sinargp, cosargp);
+    Vec axnl = em * cosargp;
+    temp = Vec(1.0) / (am * (Vec(1.0) - em * em));
+    Vec aynl = vfma(em, sinargp, temp * Vec::load(&e.aycof[index]));
+    Vec xl = mm + argpm + nodem + temp * Vec::load(&e.xlcof[index]) * axnl;
+
+    // kepler's equation, every lane iterates until all of them converged
+    Vec u = wrapTwoPi(xl - nodem);
+    Vec eo1 = u;
+    Vec sineo1, coseo1;
+    for (int iteration = 0; iteration < 10; iteration++)
+    {
+        vsincos(eo1, sineo1, coseo1);
+        Vec step = (u - aynl * coseo1 + axnl * sineo1 - eo1) / (Vec(1.0) - coseo1 * axnl - sineo1 * aynl);
+        step = vmin(vmax(step, Vec(-0.95)), Vec(0.95));
+        eo1 = eo1 + step;
+        if (vall(vabs(step) < Vec(1.0e-12)))
+            break;
+    }
+
+    // short period preliminary quantities
+    Vec ecose = axnl * coseo1 + aynl * sineo1;
+    Vec esine = axnl * sineo1 - aynl * coseo1;
+    Vec el2 = axnl * axnl + aynl * aynl;
+    Vec pl = am * (Vec(1.0) - el2);
+    valid = valid & (pl > Vec(0.0));
+    pl = vmax(pl, Vec(1.0e-12));
+    Vec rl = am * (Vec(1.0) - ecose);
+    Vec betal = vsqrt(vmax(Vec(1.0) - el2, Vec(0.0)));
+    temp = esine / (Vec(1.0) + betal);
+    Vec amOverRl = am / rl;
+    Vec sinu = amOverRl * (sineo1 - aynl - axnl * temp);
+    Vec cosu = amOverRl * (coseo1 - axnl + aynl * temp);
+    Vec su = vatan2(sinu, cosu);
+    Vec sin2u = (cosu + cosu) * sinu;
+    Vec cos2u = Vec(1.0) - Vec(2.0) * sinu * sinu;
+    temp = Vec(1.0) / pl;
+    Vec temp1 = Vec(0.5 * J2) * temp;
+    Vec temp2 = temp1 * temp;
+
+    // short period periodics
+    Vec cosio = Vec::load(&e.cosInclination[index]);
+    Vec sinio = Vec::load(&e.sinInclination[index]);
+    Vec mrt = rl * (Vec(1.0) - Vec(1.5) * temp2 * betal * Vec::load(&e.con41[index]))
+              + Vec(0.5) * temp1 * Vec::load(&e.x1mth2[index]) * cos2u;
+    su = su - Vec(0.25) * temp2 * Vec::load(&e.x7thm1[index]) * sin2u;
+    Vec xnode = nodem + Vec(1.5) * temp2 * cosio * sin2u;
+    Vec xinc = vfma(Vec(1.5) * temp2 * cosio, sinio * cos2u, Vec::load(&e.inclination[index]));
+    valid = valid & (mrt >= Vec(1.0));
+
+    // orientation vectors
+    Vec sinsu, cossu, snod, cnod, sini, cosi;
+    vsincos(su, sinsu, cossu);
+    vsincos(xnode, snod, cnod);
+    vsincos(xinc, sini, cosi);
+    Vec xmx = -snod * cosi;
+    Vec xmy = cnod * cosi;
+    Vec radius = vselect(valid, mrt * Vec(SGP4_EARTH_RADIUS_KM * scale), Vec(0.0));
+    Vec px = radius * vfma(xmx, sinsu, cnod * cossu);
+    Vec py = radius * vfma(xmy, sinsu, snod * cossu);
+    Vec pz = radius * sini * sinsu;
+
+    double x[Vec::WIDTH], y[Vec::WIDTH], z[Vec::WIDTH];
+    px.store(x);
+    py.store(y);
+    pz.store(z);
+    float* out = positions + index * 3;
+    for (std::size_t lane = 0; lane < lanes; lane++)
+    {
+        out[lane * 3] = (float)x[lane];
+        out[lane * 3 + 1] = (float)y[lane];
+        out[lane * 3 + 2] = (float)z[lane];
+    }
+}
+
+// function to propagate [begin, end), whole vectors only, the caller does the tail
+static std::size_t propagateRange(const Sgp4Elements& e, double julianDate, double scale,
+                                  float* positions, std::size_t begin, std::size_t end)
+{
+    std::size_t index = begin;
+    for (; index + Vec::WIDTH <= end; index += Vec::WIDTH)
+        propagateBlock(e, index, julianDate, scale, positions, Vec::WIDTH);
+    return index;
+}
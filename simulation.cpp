@@ -0,0 +1,172 @@
+#include "simulation.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+// steps run back to back to catch up before the simulation gives up on the lost time
+const unsigned int SIMULATION_MAX_CATCH_UP = 15;
+
+static double SteadySeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Simulation::Simulation() : time(0.0), trajectory(0.0f), epoch(0.0), positionScale(1.0f), catalogPending(false),
+    advancing(false), hasCurrent(false), hasPrevious(false), running(false), startSeconds(0.0)
+{
+
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::begin(double epoch, float positionScale)
+{
+    this->epoch = epoch;
+    this->positionScale = positionScale;
+    time = 0.0;
+    trajectory = 0.0f;
+    startSeconds = SteadySeconds();
+    publish();
+}
+
+void Simulation::start()
+{
+    if (running)
+        return;
+    running = true;
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+double Simulation::now() const
+{
+    return SteadySeconds() - startSeconds;
+}
+// function to step up to time on the calling thread, the fixed clock of headless rendering.
+// a catalog that came in is published even without a step
+void Simulation::advanceTo(double time)
+{
+    bool stepped = false;
+    while (this->time + SIMULATION_STEP <= time + 1e-9)
+    {
+        step();
+        stepped = true;
+    }
+    if (stepped || catalogPending)
+        publish();
+}
+
+void Simulation::submitCatalog(Sgp4Catalog& catalog)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pendingCatalog = std::move(catalog);
+    catalogPending = true;
+}
+
+void Simulation::setAdvancing(bool advancing)
+{
+    this->advancing = advancing;
+}
+// function to advance the clocks by one fixed step
+void Simulation::step()
+{
+    time += SIMULATION_STEP;
+    if (advancing)
+        trajectory += SIMULATION_TRAJECTORY_RATE * (float)SIMULATION_STEP;
+}
+// function to compute what the steps changed and hand it to the renderer. the SGP4
+// propagation only runs here, once for however many steps were taken
+void Simulation::publish()
+{
+    PROFILE_SCOPE("simulation");
+    if (catalogPending)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        catalog = std::move(pendingCatalog);
+        catalogPending = false;
+    }
+
+    SimulationState& state = states.getWriteBuffer();
+    state.time = time;
+    state.trajectory = trajectory;
+    state.positions.resize(catalog.size() * 3);
+    if (catalog.size() > 0)
+    {
+        // every second of M runs the clock 100 minutes per unit of trajectory forward
+        catalog.propagate(epoch + time / 86400.0 + trajectory * 100.0 / 1440.0, &state.positions[0], positionScale);
+    }
+    states.publish();
+}
+// function to step at SIMULATION_RATE against the wall clock. when the steps fall behind
+// (a slow propagation) they catch up without publishing the states in between, and
+// after SIMULATION_MAX_CATCH_UP steps the rest of the lost time is dropped
+void Simulation::run()
+{
+    double next = now() + SIMULATION_STEP;
+    while (running)
+    {
+        unsigned int steps = 0;
+        while (now() >= next && steps < SIMULATION_MAX_CATCH_UP)
+        {
+            step();
+            next += SIMULATION_STEP;
+            steps++;
+        }
+        if (steps == SIMULATION_MAX_CATCH_UP)
+            next = now() + SIMULATION_STEP;
+        if (steps > 0)
+            publish();
+
+        double wait = next - now();
+        if (wait > 0.0)
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+}
+// function to blend the newest state with the one it replaced. time is normally a step
+// behind now(), so it lies between the two; it is clamped instead of extrapolated
+void Simulation::sample(double time, SimulationState& state)
+{
+    if (states.hasFresh())
+    {
+        // the read buffer goes back to the writer, keep its state as the previous one
+        if (hasCurrent)
+        {
+            std::swap(previous, states.getReadBuffer());
+            hasPrevious = true;
+        }
+        hasCurrent = true;
+        states.acquire();
+    }
+    const SimulationState& current = states.getReadBuffer();
+
+    if (!hasPrevious || current.time <= previous.time)
+    {
+        state.time = current.time;
+        state.trajectory = current.trajectory;
+        state.positions = current.positions;
+        return;
+    }
+    double alpha = std::min(std::max((time - previous.time) / (current.time - previous.time), 0.0), 1.0);
+    state.time = previous.time + (current.time - previous.time) * alpha;
+    state.trajectory = previous.trajectory + (current.trajectory - previous.trajectory) * (float)alpha;
+    state.positions.resize(current.positions.size());
+    if (previous.positions.size() != current.positions.size())
+    {
+        // a new catalog came in, nothing to blend with
+        state.positions = current.positions;
+        return;
+    }
+    float a = (float)alpha;
+    for (std::size_t i = 0; i < current.positions.size(); i++)
+        state.positions[i] = previous.positions[i] + (current.positions[i] - previous.positions[i]) * a;
+}
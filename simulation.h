@@ -0,0 +1,85 @@
+#pragma once
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "sgp4.h"
+#include "triplebuffer.h"
+
+// simulation steps per second, the renderer interpolates between them
+const double SIMULATION_RATE = 60.0;
+const double SIMULATION_STEP = 1.0 / SIMULATION_RATE;
+// how far the satellites are run forward per second while M is held (or always, headless)
+const float SIMULATION_TRAJECTORY_RATE = 3.0f;
+
+// everything the renderer needs from one simulation step, never changed once published
+struct SimulationState
+{
+    double time;                    // seconds since the start, drives the light orbits
+    float trajectory;               // the satellite clock, run forward with M
+    std::vector<float> positions;   // SGP4 positions in scene units, 3 per satellite, empty without a catalog
+};
+
+// advances the scene at a fixed rate, apart from the frame rate: the satellite clock,
+// the time the lights orbit with and the SGP4 positions of the catalog. every step is
+// published as a SimulationState through a triple buffer; the renderer takes the newest
+// with sample() and blends it with the one before. start() runs the steps on their own
+// thread against the wall clock, advanceTo() runs them on the calling thread instead
+// (headless rendering, where the clock is the frame number)
+class Simulation
+{
+public:
+    Simulation();
+    ~Simulation();
+
+    // function to set where the SGP4 clock starts (julian date at time 0) and how TEME
+    // kilometres scale into the scene, then publish the state at time 0
+    void begin(double epoch, float positionScale);
+    void start();
+    void stop();
+    void advanceTo(double time);
+    // function to get the seconds since start(), the clock the simulation thread steps by
+    double now() const;
+
+    // any thread: the catalog is swapped in at the next step
+    void submitCatalog(Sgp4Catalog& catalog);
+    // any thread: run the satellite clock forward while advancing is set
+    void setAdvancing(bool advancing);
+
+    // render thread: interpolate the two newest states at time into state
+    void sample(double time, SimulationState& state);
+
+private:
+    Simulation(const Simulation&);
+    Simulation& operator=(const Simulation&);
+
+    void step();
+    void publish();
+    void run();
+
+    // owned by whoever steps, the simulation thread or advanceTo's caller
+    double time;
+    float trajectory;
+    double epoch;
+    float positionScale;
+    Sgp4Catalog catalog;
+
+    std::mutex pendingMutex;
+    Sgp4Catalog pendingCatalog;
+    std::atomic<bool> catalogPending;
+    std::atomic<bool> advancing;
+
+    TripleBuffer<SimulationState> states;
+    bool hasCurrent;                // getReadBuffer() holds a published state
+    SimulationState previous;       // the state before getReadBuffer(), owned by the reader
+    bool hasPrevious;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    double startSeconds;
+};
+
+#endif
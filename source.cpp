@@ -34,22 +34,51 @@ THE SOFTWARE.
 #include <glm/gtc/type_ptr.hpp>
 
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
 
 
 #include "filesystem.h"
 #include "shader.h"
+#include "cachedshader.h"
 #include "camera.h"
 #include "model.h"
 #include "pen_accent.h"
 #include "pen_body.h"
 #include "pen_clip.h"
 #include "pen_point.h"
-#include "sphere.h"
 #include "ufo.h"
 
 #include "objects.h"
+#include "meshregistry.h"
+#include "staticgeometry.h"
+#include "constellation.h"
+#include "earthlod.h"
+#include "earthtiles.h"
+#include "lighting.h"
 #include "geometry.h"
-#include "texture.h"
+#include "scenetransforms.h"
+#include "textureloader.h"
+#include "texturecache.h"
+#include "sgp4.h"
+#include "catalogloader.h"
+#include "headless.h"
+#include "framebuffer.h"
+#include "framecapture.h"
+#include "poster.h"
+#include "profiler.h"
+#include "renderstats.h"
+#include "benchmark.h"
+#include "simulation.h"
+#include "jobs.h"
+#include "frustum.h"
+#include "occlusion.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
 
 /* TEXT RENDERING */
 struct Character {
@@ -60,13 +89,17 @@ struct Character {
 };
 
 /* FUNCTIONS */
-void RenderText(Shader& s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
+void RenderText(CachedShader& s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 void GetDesktopResolution(float& horizontal, float& vertical);
-void SetShader(Shader lightingShader);
+void SetLights(LightingBlock& lighting);
+void LoadCatalog(const std::string& path, Sgp4Catalog& target);
+bool LoadFont(const char* path, unsigned int pixelHeight);
+bool LightVisible(const Frustum& frustum, const SphereOccluder& earth, const Bounds& bounds, const glm::mat4& model);
+bool CookTextures(bool compress);
 
 
 /* VARIABLES */
@@ -74,7 +107,8 @@ int texturePicker;
 int t = 0;
 int r = 0;
 vector<unsigned int> textures;
-float trajectory;
+unsigned int satelliteCount = 1;
+float earthLodBias = 0.0f;       // whole levels added to the earth lod level picked for its size on screen
 float x = -2.45613f;
 float y = -.894599f;
 float z = .499f;
@@ -89,58 +123,273 @@ float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 float lastFrame = 0.0f; 
 float deltaTime = 0.0f;
+double sceneTime = 0.0;         // seconds since the start, the time of the simulation state being drawn
+double sceneEpoch = 0.0;        // julian date at sceneTime 0, where the SGP4 satellites start
 GLfloat xoffset = 0.0f, yoffset = 0.0f;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+Simulation simulation;
+
+// how far back the eye of the earth occlusion test is put in the ortho view
+const float ORTHO_OCCLUSION_DISTANCE = 1000.0f;
+// satellites per transform task, fewer are not worth handing to a worker
+const std::size_t SATELLITE_TRANSFORM_GRAIN = 1024;
+
+// the textures main() loads, and the skybox faces
+const char* TEXTURE_FILES[] = {
+    "resources/textures/AdobeStock_257170070.jpg",
+    "resources/textures/earth0.png",
+    "resources/textures/AdobeStock_235275603.jpg",
+    "resources/textures/AdobeStock_408749181.jpeg",
+    "resources/textures/satellite2.png",
+    "resources/textures/box.png",
+    "resources/textures/satellite.png",
+    "resources/textures/AdobeStock_252775020.jpeg",
+    "resources/textures/viktorsaznov deepspace.jpeg",
+    "resources/textures/AdobeStock_481965458.jpeg",
+    "resources/textures/background5.jpg",
+    "resources/textures/AdobeStock_293211764.jpeg",
+};
+const unsigned int TEXTURE_COUNT = sizeof(TEXTURE_FILES) / sizeof(TEXTURE_FILES[0]);
+const char* CUBEMAP_FILES[6] = {
+    "resources/textures/right.jpg", // right 
+    "resources/textures/left.jpg", // left 
+    "resources/textures/top.jpg", // top  
+    "resources/textures/bottom.jpg", // bottom  
+    "resources/textures/front.jpg", // front
+    "resources/textures/back.jpg", // back
+};
 
 Geometry geometry;
-const glm::vec3* lightPositions = geometry.GetLightPositions();
 const glm::vec3* pointLightPositions = geometry.GetPointLightPositions();
 const glm::vec3 lightPos = geometry.GetLightPos();
 
+// function to get the size of the primary monitor, after glfwInit
 void GetDesktopResolution(float& horizontal, float& vertical)
 {
-    RECT desktop;
-    const HWND hDesktop = GetDesktopWindow();
-    GetWindowRect(hDesktop, &desktop);
-    horizontal = desktop.right;
-    vertical = desktop.bottom;
+    const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (mode == NULL)
+        return;
+    horizontal = (float)mode->width;
+    vertical = (float)mode->height;
 }
-int main()
+int main(int argc, char** argv)
 {
-    GetDesktopResolution(SCR_WIDTH, SCR_HEIGHT);
+    // --satellites N draws a whole constellation instead of the single satellite
+    // --tle file places one satellite per element set of the file (TLE or OMM CSV) with SGP4
+    // --sgp4-benchmark [N] times the SGP4 kernels on N objects (the --tle file or synthetic ones) and exits
+    // --tle-check loads the --tle file with 1 to 64 threads, exits with 1 when the records differ
+    // --headless WxH renders --frames N frames at --fps F of simulated time into an FBO, without a window
+    // --capture path streams every frame as Y4M (or raw rgb24 with --capture-format rgb) to a file or "|command"
+    // --poster WxH path renders the first frame as a PPM of any size in --poster-tile N sized tiles and exits
+    // --profile shows the cpu/gpu time of every pass on screen (printed at exit when headless)
+    // --trace path writes every profiled section as Chrome trace / Perfetto JSON
+    // --benchmark flies a scripted camera path offscreen (--headless, default 1920x1080) for --frames N frames and
+    // writes frame time percentiles as JSON to --benchmark-out path (benchmark.json), --benchmark-baseline path compares them
+    // with a stored run and fails when they got --benchmark-tolerance percent (default 10) worse
+    // --stats shows the GL call counters of the last frame, --stats-json path appends them every --stats-interval N frames
+    // --earth-tiles dir streams the earth imagery from the tile pyramid in dir instead of earth0.png
+    // --cook-textures [bc] cooks every texture into resources/cache (BC1/BC3 compressed with bc) and exits
+    // --epoch JD starts the satellites at julian date JD, headless runs and posters default to the newest
+    // element set of the --tle file and the window to the current time
+    bool sgp4Benchmark = false;
+    bool catalogCheck = false;
+    unsigned int benchmarkCount = 30000;
+    std::string catalogPath;
+    double epoch = 0.0;
+    bool headless = false;
+    int headlessWidth = 1920, headlessHeight = 1080;
+    unsigned int headlessFrames = 600;
+    double headlessFps = 60.0;
+    std::string capturePath;
+    CaptureFormat captureFormat = CAPTURE_Y4M;
+    std::string posterPath;
+    int posterWidth = 0, posterHeight = 0, posterTile = 2048;
+    bool showProfile = false;
+    std::string tracePath;
+    bool showStats = false;
+    std::string statsPath;
+    unsigned int statsInterval = 60;
+    bool benchmark = false;
+    std::string benchmarkOut = "benchmark.json", benchmarkBaseline;
+    double benchmarkTolerance = 10.0;
+    std::string earthTilesPath;
+    bool cookTextures = false, cookCompressed = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--satellites" && i + 1 < argc)
+            satelliteCount = (unsigned int)atoi(argv[++i]);
+        else if (arg == "--tle" && i + 1 < argc)
+            catalogPath = argv[++i];
+        else if (arg == "--epoch" && i + 1 < argc)
+            epoch = atof(argv[++i]);
+        else if (arg == "--headless" && i + 1 < argc)
+        {
+            headless = true;
+            if (sscanf(argv[++i], "%dx%d", &headlessWidth, &headlessHeight) != 2 || headlessWidth <= 0 || headlessHeight <= 0)
+            {
+                std::cout << "--headless expects WIDTHxHEIGHT, e.g. 1920x1080" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+            headlessFrames = (unsigned int)atoi(argv[++i]);
+        else if (arg == "--fps" && i + 1 < argc)
+            headlessFps = atof(argv[++i]);
+        else if (arg == "--capture" && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (arg == "--capture-format" && i + 1 < argc)
+            captureFormat = std::string(argv[++i]) == "rgb" ? CAPTURE_RGB : CAPTURE_Y4M;
+        else if (arg == "--poster" && i + 2 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &posterWidth, &posterHeight) != 2 || posterWidth <= 0 || posterHeight <= 0)
+            {
+                std::cout << "--poster expects WIDTHxHEIGHT and a file, e.g. 16384x9216 poster.ppm" << std::endl;
+                return -1;
+            }
+            posterPath = argv[++i];
+        }
+        else if (arg == "--poster-tile" && i + 1 < argc)
+            posterTile = atoi(argv[++i]);
+        else if (arg == "--profile")
+            showProfile = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (arg == "--benchmark")
+            benchmark = true;
+        else if (arg == "--benchmark-out" && i + 1 < argc)
+            benchmarkOut = argv[++i];
+        else if (arg == "--benchmark-baseline" && i + 1 < argc)
+            benchmarkBaseline = argv[++i];
+        else if (arg == "--benchmark-tolerance" && i + 1 < argc)
+            benchmarkTolerance = atof(argv[++i]);
+        else if (arg == "--stats")
+            showStats = true;
+        else if (arg == "--stats-json" && i + 1 < argc)
+            statsPath = argv[++i];
+        else if (arg == "--stats-interval" && i + 1 < argc)
+            statsInterval = std::max(atoi(argv[++i]), 1);
+        else if (arg == "--earth-tiles" && i + 1 < argc)
+            earthTilesPath = argv[++i];
+        else if (arg == "--cook-textures")
+        {
+            cookTextures = true;
+            if (i + 1 < argc && std::string(argv[i + 1]) == "bc")
+            {
+                cookCompressed = true;
+                i++;
+            }
+        }
+        else if (arg == "--tle-check")
+            catalogCheck = true;
+        else if (arg == "--sgp4-benchmark")
+        {
+            sgp4Benchmark = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchmarkCount = (unsigned int)atoi(argv[++i]);
+        }
+    }
+    // the frame benchmark always renders offscreen, at the --headless size if one was given
+    if (benchmark)
+        headless = true;
+    if (sgp4Benchmark)
+    {
+        Sgp4Catalog catalog;
+        if (!catalogPath.empty())
+            LoadCatalog(catalogPath, catalog);
+        if (catalog.size() == 0)
+            AddSyntheticElements(catalog, benchmarkCount, JulianDateNow());
+        BenchmarkSgp4(catalog);
+        return 0;
+    }
+    if (catalogCheck)
+        return CheckCatalogChunking(catalogPath) ? 0 : 1;
+    if (cookTextures)
+        return CookTextures(cookCompressed) ? 0 : -1;
+
+    // the catalog is parsed on a loader thread while the window and the assets come up,
+    // the simulation swaps it in at its next step
+    Sgp4Catalog loadedCatalog;
+    double catalogEpoch = 0.0;
+    std::atomic<bool> catalogReady(false);
+    std::thread catalogLoader;
+    if (!catalogPath.empty())
+    {
+        catalogLoader = std::thread([&]() {
+            LoadCatalog(catalogPath, loadedCatalog);
+            catalogEpoch = loadedCatalog.getLatestEpoch();
+            if (loadedCatalog.size() > 0)
+                simulation.submitCatalog(loadedCatalog);
+            catalogReady = true;
+        });
+    }
+
     /* GLFW INITIALIZE */
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
+    // headless mode has no window: an EGL context without a surface renders into sceneTarget
+    GLFWwindow* window = NULL;
+    HeadlessContext headlessContext;
+    Framebuffer sceneTarget;
+    if (headless)
+    {
+        SCR_WIDTH = (float)headlessWidth;
+        SCR_HEIGHT = (float)headlessHeight;
+        if (!headlessContext.create() || !sceneTarget.create(headlessWidth, headlessHeight, 4))
+        {
+            if (catalogLoader.joinable())
+                catalogLoader.join();
+            return -1;
+        }
+    }
+    else
+    {
+        glfwInit();
+        GetDesktopResolution(SCR_WIDTH, SCR_HEIGHT);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_SAMPLES, 4);
 
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "OpenGL Game", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "OpenGL Game", NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            if (catalogLoader.joinable())
+                catalogLoader.join();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
 
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            if (catalogLoader.joinable())
+                catalogLoader.join();
+            return -1;
+        }
     }
     /* GLFW INITIALIZE */
 
     /* TEXT RENDERING */
+    // the glyphs are only needed for the profiler summary and the counters
+    if ((showProfile || showStats) && !headless)
+        LoadFont("resources/fonts/DejaVuSansMono.ttf", 16);
+#if PROFILER_ENABLED
+    if (!tracePath.empty())
+        profiler.startTrace(tracePath);
+#else
+    if (showProfile || !tracePath.empty())
+        std::cout << "--profile and --trace need a build with PROFILER_ENABLED" << std::endl;
+#endif
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
@@ -151,45 +400,85 @@ int main()
     /* TEXT RENDERING */
 
     /* SHADERS */
-    Shader lightCubeShader("lightbox.vs", "lightbox.fs");
-    Shader lightingShader("specular.vs", "specular.fs");
-    Shader skyboxShader("skybox.vs", "skybox.fs");
-    Shader greenShader("glsl.vs", "light_green.fs");
-    Shader pinkShader("glsl.vs", "light_pink.fs");
-    Shader purpleShader("glsl.vs", "light_purple.fs");
-    Shader textShader("tex.vs", "tex.fs");
+    CachedShader lightCubeShader("lightbox.vs", "lightbox.fs");
+    CachedShader lightingShader("earth.vs", "earth.fs");
+    CachedShader skyboxShader("skybox.vs", "skybox.fs");
+    CachedShader greenShader("glsl.vs", "light_green.fs");
+    CachedShader pinkShader("glsl.vs", "light_pink.fs");
+    CachedShader purpleShader("glsl.vs", "light_purple.fs");
+    CachedShader textShader("tex.vs", "tex.fs");
+    CachedShader satelliteShader("satellite.vs", "specular.fs");
 
     glm::mat4 Text_projection = glm::ortho(0.0f, SCR_WIDTH, 0.0f, SCR_HEIGHT);
     textShader.use();
-    glUniformMatrix4fv(glGetUniformLocation(textShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(Text_projection));
-
-    /* VERTICES */
-    std::vector<GLfloat>vertices = geometry.GetCubeVertices();
-    std::vector<GLfloat>compassVertices = geometry.GetCompassVertices();
-    std::vector<GLfloat>boxVertices = geometry.GetBoxVertices();
-    std::vector<GLfloat>skyboxVertices = geometry.GetSkyboxVertices();
-    std::vector<GLfloat>compass2Vertices = geometry.GetCompass2Vertices();
+    countedUniformMatrix4fv(glGetUniformLocation(textShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(Text_projection));
 
     /* TEXT RENDERING VAO-VBO*/
     glGenVertexArrays(1, &textVAO);
     glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
+    countedBindVertexArray(textVAO);
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    countedBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    countedBindVertexArray(0);
+
+    /* ASSETS */
+    // the texture names are handed out at once and their cooked files mapped (or cooked again
+    // when a source changed) on the worker threads, while the earth and ufo are generated there
+    // too. textureLoader fills each texture with all its mip levels on this thread when its file is ready
+    jobs.init();
+    bool allowCompressed = CompressedTexturesSupported();
+    GLuint loadedTextures[TEXTURE_COUNT];
+    for (unsigned int i = 0; i < TEXTURE_COUNT; i++)
+        loadedTextures[i] = textureLoader.loadCooked(std::vector<std::string>(1, TEXTURE_FILES[i]), allowCompressed);
+    GLuint cubemap3Texture = textureLoader.loadCooked(std::vector<std::string>(CUBEMAP_FILES, CUBEMAP_FILES + 6), allowCompressed);
+    EarthLodMesh earthLevels[EARTH_LOD_LEVEL_COUNT];
+    {
+        PROFILE_SCOPE("load assets");
+        TaskGraph assets;
+        for (int i = 0; i < EARTH_LOD_LEVEL_COUNT; i++)
+            assets.add([&, i]() { BuildEarthLodMesh(EARTH_LOD_MIN_LEVEL + i, .15f, glm::vec3(0.0f, 2.7f, .25f), earthLevels[i]); });
+        assets.add([]() { Ufo generate; });
+        jobs.run(assets);
+        textureLoader.drain();
+    }
+
+    /* MESHES ARE UPLOADED ONCE AND OWNED BY THE REGISTRY */
+    // the earth levels were built by the asset tasks, the ufo comes from the parametric cache they filled.
+    // the earth is a sphere of radius .15 around (0, 2.7, .25) in mesh space, where Sphere put it
+    MeshRegistry meshes;
+    EarthLod earth;
+    earth.init(meshes, earthLevels);
+    for (int i = 0; i < EARTH_LOD_LEVEL_COUNT; i++)
+    {
+        // the level is in its buffers now
+        std::vector<float>().swap(earthLevels[i].vertices);
+        std::vector<unsigned int>().swap(earthLevels[i].indices);
+    }
+    Ufo ufo;
+    MeshHandle ufoMesh = meshes.addIndexed(&ufo.GetVertices()[0], ufo.GetVertices().size() * sizeof(GLfloat),
+        &ufo.GetIndices()[0], (GLsizei)ufo.GetIndices().size(), LAYOUT_POSITION_NORMAL_TEXCOORD, ufo.GetMode());
+
+    /* THE SMALL PROPS SHARE ONE VERTEX/INDEX BUFFER */
+    StaticGeometry props;
+    props.build(meshes);
+    MeshHandle boxMesh = props.get(SHAPE_CUBE);
+    MeshHandle triangleMesh = props.get(SHAPE_COMPASS);
+    MeshHandle triangle2Mesh = props.get(SHAPE_COMPASS2);
+    MeshHandle skyboxMesh = props.get(SHAPE_SKYBOX);
+    MeshHandle lightCubeMesh = props.get(SHAPE_SKYBOX);
+
+    /* BOUNDING VOLUMES FOR FRUSTUM CULLING, IN MESH SPACE */
+    Bounds earthBounds = earth.getBounds();
+    Bounds ufoBounds = ufo.GetBounds();
+    Bounds boxBounds = Geometry::GetShapeBounds(SHAPE_CUBE);
+    Bounds triangleBounds = Geometry::GetShapeBounds(SHAPE_COMPASS);
+    Bounds triangle2Bounds = Geometry::GetShapeBounds(SHAPE_COMPASS2);
+    Bounds lightCubeBounds = Geometry::GetShapeBounds(SHAPE_SKYBOX);
 
     /* LIGHT CUBE UNIFORM MATRICES */
-    unsigned int lightCubeVAO, lightCubeVBO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glGenBuffers(1, &lightCubeVBO);
-    glBindVertexArray(lightCubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lightCubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, skyboxVertices.size() * sizeof(GLfloat), &skyboxVertices[0], GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     unsigned int uniformBlockIndexRed = glGetUniformBlockIndex(pinkShader.ID, "Matrices");
     unsigned int uniformBlockIndexGreen = glGetUniformBlockIndex(greenShader.ID, "Matrices");
     glUniformBlockBinding(pinkShader.ID, uniformBlockIndexRed, 0);
@@ -197,28 +486,33 @@ int main()
     unsigned int uboMatrices;
     glGenBuffers(1, &uboMatrices);
     glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
-    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_STATIC_DRAW);
+    countedBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_STATIC_DRAW);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
     glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboMatrices, 0, 2 * sizeof(glm::mat4));
     glm::mat4 projection = glm::perspective(45.0f, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
     glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(projection));
+    countedBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(projection));
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
     /* TEXTURES */
-    Textures texture;
-    unsigned int ufoTexture = texture.loadTexture("resources/textures/AdobeStock_257170070.jpg");
-    unsigned int earthTexture = texture.loadTexture("resources/textures/earth0.png");
-    unsigned int goldTexture = texture.loadTexture("resources/textures/AdobeStock_235275603.jpg");
-    unsigned int flowerTexture = texture.loadTexture("resources/textures/AdobeStock_408749181.jpeg");
-    unsigned int satelliteTexture = texture.loadTexture("resources/textures/satellite2.png");
-    unsigned int cubeTexture = texture.loadTexture("resources/textures/box.png");
-    unsigned int panelTexture = texture.loadTexture("resources/textures/satellite.png");
-    unsigned int planeTexture1 = texture.loadTexture("resources/textures/AdobeStock_252775020.jpeg");
-    unsigned int skyboxTexture = texture.loadTexture("resources/textures/viktorsaznov deepspace.jpeg");
-    unsigned int planeTexture3 = texture.loadTexture("resources/textures/AdobeStock_481965458.jpeg");
-    unsigned int planeTexture4 = texture.loadTexture("resources/textures/background5.jpg");
-    unsigned int planeTexture5 = texture.loadTexture("resources/textures/AdobeStock_293211764.jpeg");
+    unsigned int ufoTexture = loadedTextures[0];
+    unsigned int earthTexture = loadedTextures[1];
+    unsigned int goldTexture = loadedTextures[2];
+    unsigned int flowerTexture = loadedTextures[3];
+    unsigned int satelliteTexture = loadedTextures[4];
+    unsigned int cubeTexture = loadedTextures[5];
+    // the earth imagery from a tile pyramid, the earth keeps earthTexture when there is none
+    EarthTiles earthTiles;
+    if (!earthTilesPath.empty())
+        earthTiles.open(earthTilesPath);
+    lightingShader.use();
+    lightingShader.setBool("tiled", earthTiles.isOpen());
+    unsigned int panelTexture = loadedTextures[6];
+    unsigned int planeTexture1 = loadedTextures[7];
+    unsigned int skyboxTexture = loadedTextures[8];
+    unsigned int planeTexture3 = loadedTextures[9];
+    unsigned int planeTexture4 = loadedTextures[10];
+    unsigned int planeTexture5 = loadedTextures[11];
 
 
     textures.push_back(ufoTexture);
@@ -229,17 +523,6 @@ int main()
     textures.push_back(planeTexture3);
     textures.push_back(planeTexture4);
     textures.push_back(planeTexture5);
-
-    vector<std::string> faces
-    {
-        "resources/textures/right.jpg", // right 
-        "resources/textures/left.jpg", // left 
-        "resources/textures/top.jpg", // top  
-        "resources/textures/bottom.jpg", // bottom  
-        "resources/textures/front.jpg", // front
-        "resources/textures/back.jpg", // back
-    };
-    unsigned int cubemap3Texture = texture.loadCubemap(faces);
     /* TEXTURES */
     
 
@@ -251,192 +534,406 @@ int main()
     lightingShader.use();
     lightingShader.setInt("material.diffuse", 0);
     lightingShader.setInt("material.specular", 1);
+    lightingShader.setFloat("material.shininess", 32.0f);
+    lightingShader.setInt("tiles", 2);
+    lightingShader.setInt("tileTable", 3);
+
+    satelliteShader.use();
+    satelliteShader.setInt("material.diffuse", 0);
+    satelliteShader.setInt("material.specular", 1);
+    satelliteShader.setFloat("material.shininess", 32.0f);
+    satelliteShader.setVec3("variantTint[0]", 1.0f, 0.85f, 0.6f);
+    satelliteShader.setVec3("variantTint[1]", 0.6f, 0.85f, 1.0f);
+    satelliteShader.setVec3("variantTint[2]", 0.8f, 1.0f, 0.7f);
+
+    /* LIGHTING UNIFORM BLOCK SHARED BY THE LIT PROGRAMS */
+    LightingBlock lighting;
+    lighting.init();
+    lighting.bind(lightingShader.ID);
+    lighting.bind(satelliteShader.ID);
+    SetLights(lighting);
+
+    /* SATELLITE PARTS, EACH ONE IS A SINGLE INSTANCED DRAW */
+    Constellation constellation;
+    constellation.init(meshes, satelliteCount);
+    glm::mat4 part;
+    part = glm::translate(glm::mat4(1.0f), glm::vec3(-2.8004f, -0.900075f, 0.599999f));    // wing left
+    constellation.addPart(boxMesh, panelTexture, glm::scale(part, glm::vec3(.5f, .2f, .02f)), boxBounds.sphere);
+    part = glm::translate(glm::mat4(1.0f), glm::vec3(-1.96539f, -0.900075f, 0.599999f));   // wing right
+    constellation.addPart(boxMesh, panelTexture, glm::scale(part, glm::vec3(.5f, .2f, .02f)), boxBounds.sphere);
+    part = glm::translate(glm::mat4(1.0f), glm::vec3(-2.3804f, -0.855599f, 0.629999f));    // body
+    constellation.addPart(boxMesh, satelliteTexture, glm::scale(part, glm::vec3(.25f)), boxBounds.sphere);
+    part = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.00f)); // dish
+    part = glm::translate(part, glm::vec3(-2.3754f, 0.6594f, 0.854999f));
+    constellation.addPart(ufoMesh, ufoTexture, glm::scale(part, glm::vec3(.3f)), ufoBounds.sphere);
+    part = glm::translate(glm::mat4(1.0f), glm::vec3(-2.31113f, -0.899599f, 0.489f));      // right attachment
+    constellation.addPart(triangleMesh, panelTexture, glm::scale(part, glm::vec3(.2f)), triangleBounds.sphere);
+    part = glm::translate(glm::mat4(1.0f), glm::vec3(-2.46113f, -0.899599f, 0.504f));      // left attachment
+    constellation.addPart(triangle2Mesh, panelTexture, glm::scale(part, glm::vec3(.2f)), triangle2Bounds.sphere);
+    constellation.resize(satelliteCount);
 
     /* SET THE PROJECTION AS PERSPECTIVE BY DEFAULT*/
     onPerspective = true;
-    glfwSwapBuffers(window);
-    /* RENDER LOOP */
-    while (!glfwWindowShouldClose(window))
+    if (window != NULL)
+        glfwSwapBuffers(window);
+
+    /* FRAME CAPTURE */
+    FrameCapture capture;
+    if (!capturePath.empty())
+    {
+        int captureWidth = headlessWidth, captureHeight = headlessHeight;
+        if (window != NULL)
+            glfwGetFramebufferSize(window, &captureWidth, &captureHeight);
+        capture.open(capturePath, captureWidth, captureHeight, headless ? headlessFps : 60.0, captureFormat);
+    }
+
+    /* DRAW THE SCENE */
+    // draws everything with the given projection into the bound framebuffer, once per frame
+    // or once per tile of a poster. the per frame state was updated by the loop before
+    auto drawScene = [&](const glm::mat4& projection)
     {
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
+        glm::mat4 view, model, light_models;
+        // only what is inside the view volume of this projection is drawn, a poster tile
+        // culls against its own sub frustum
+        view = camera.GetViewMatrix();
+        Frustum frustum;
+        ExtractFrustum(projection * view, frustum);
+        // and only what the earth does not hide. the ortho view looks along parallel rays, an
+        // eye far back along them sees a slightly narrower shadow, which keeps the test safe
+        BoundingSphere earthSphere = { EARTH_CENTER, EARTH_RADIUS };
+        SphereOccluder earthOccluder = MakeSphereOccluder(onPerspective ? camera.Position
+            : EARTH_CENTER - camera.Front * ORTHO_OCCLUSION_DISTANCE, earthSphere);
+
+        /* SET SHADER */
+        {
+            PROFILE_PASS("earth");
+            lightingShader.use();
+            lightingShader.setMat4("projection", projection);
+            lightingShader.setMat4("view", view);
+            lightingShader.setMat4("model", model);
+
+            glActiveTexture(GL_TEXTURE0);
+            countedBindTexture(GL_TEXTURE_2D, earthTexture);
+            if (earthTiles.isOpen())
+                earthTiles.bind(GL_TEXTURE2, GL_TEXTURE3);
+            lightingShader.setMat4("model", model);
+            model = glm::mat4(.5f);
+            // code to make the earth spin in place
+            model = glm::translate(model, glm::vec3(-.411121f, -1.2946 -45.8946f, -4.90606));
+          //  model = glm::rotate(model, (GLfloat)glfwGetTime() * glm::radians(10.0f), glm::vec3(0.0, 0.100f, 0.0));
+            model = glm::scale(model, glm::vec3(17));
+            lightingShader.setMat4("model", model);
+            if (SphereInFrustum(frustum, TransformSphere(earthBounds.sphere, model)))
+                earth.draw(lightingShader);
+            else
+                renderStats.frustumCulled++;
+        }
+
+        /* RENDER SATELLITES */
+        {
+            PROFILE_PASS("satellites");
+            satelliteShader.use();
+            satelliteShader.setMat4("projection", projection);
+            satelliteShader.setMat4("view", view);
+            constellation.cull(frustum, &earthOccluder);
+            constellation.draw(satelliteShader);
+        }
+
+        /* RENDER LIGHTS */
+        {
+            PROFILE_PASS("lights");
+            pinkShader.setMat4("model", light_models);
+            glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
+            countedBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            for (unsigned int i = 0; i < ORBITING_LIGHT_COUNT; i++)
+            {
+                light_models = OrbitingLightMatrix(i, sceneTime);
+                if (i == 1)
+                { /* PINK LIGHTS */
+                    pinkShader.use();
+                    pinkShader.setMat4("projection", projection);
+                    pinkShader.setMat4("view", view);
+                    pinkShader.setMat4("model", light_models);
+                    if (LightVisible(frustum, earthOccluder, lightCubeBounds, light_models))
+                        meshes.draw(lightCubeMesh);
+                }
+                else
+                { /* PURPLE LIGHTS */
+                    purpleShader.use();
+                    purpleShader.setMat4("projection", projection);
+                    purpleShader.setMat4("view", view);
+                    purpleShader.setMat4("model", light_models);
+                    if (LightVisible(frustum, earthOccluder, lightCubeBounds, light_models))
+                        meshes.draw(lightCubeMesh);
+                }
+            }
+        }
+
+        /* RENDER SKYBOX */
+        {
+            PROFILE_PASS("skybox");
+            glDepthFunc(GL_LEQUAL);
+            skyboxShader.use();
+            view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
+            skyboxShader.setMat4("view", view);
+            skyboxShader.setMat4("projection", projection);
+            glActiveTexture(GL_TEXTURE0);
+            countedBindTexture(GL_TEXTURE_CUBE_MAP, cubemap3Texture);
+            meshes.draw(skyboxMesh);
+            meshes.unbind();
+            glDepthFunc(GL_LESS);
+        }
+    };
+
+    // the poster shows the loaded catalog, so it waits for the loader, and so do headless runs:
+    // every run of the same command line has to draw the same satellites from its first frame
+    bool deterministic = headless || !posterPath.empty();
+    while (deterministic && catalogLoader.joinable() && !catalogReady)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // headless runs and posters do not depend on the clock either, they start at the catalog's newest epoch
+    if (epoch > 0.0)
+        sceneEpoch = epoch;
+    else if (deterministic && catalogEpoch > 0.0)
+        sceneEpoch = catalogEpoch;
+    else
+        sceneEpoch = JulianDateNow();
+    // headless frames and posters start with every texture in, the window fills them in as they arrive
+    if (deterministic)
+        textureLoader.finish();
+
+    /* SIMULATION */
+    // the satellites and the light orbits step at SIMULATION_RATE on their own thread, headless
+    // frames and posters step them on this thread instead, up to the frame's time, so every run
+    // is the same. a poster drawn with a window is pinned too, it never reads the wall clock
+    SimulationState state;
+    simulation.begin(sceneEpoch, EARTH_RADIUS / (float)SGP4_EARTH_RADIUS_KM);
+    if (deterministic)
+        simulation.setAdvancing(true);
+    else
+        simulation.start();
+
+    /* RENDER LOOP */
+    // headless frames are not throttled: frame n shows the scene at n / fps seconds however long it took
+    unsigned int frame = 0;
+    RenderStats lastStats = FinishRenderStatsFrame();
+    FILE* statsFile = NULL;
+    if (!statsPath.empty() && (statsFile = fopen(statsPath.c_str(), "w")) == NULL)
+        std::cout << "Failed to open " << statsPath << std::endl;
+    FrameBenchmark frameBenchmark;
+    if (benchmark)
+        frameBenchmark.begin(headlessWidth, headlessHeight);
+    std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+    while (headless ? frame < headlessFrames : !glfwWindowShouldClose(window))
+    {
+        PROFILE_BEGIN_FRAME();
+        if (benchmark)
+            frameBenchmark.beginFrame();
+        if (headless)
+            sceneTarget.bind();
+        if (textureLoader.getPendingCount() > 0)
+        {
+            PROFILE_SCOPE("texture uploads");
+            textureLoader.drain();
+        }
+        double renderTime = deterministic ? frame / headlessFps : simulation.now();
+        float currentFrame = static_cast<float>(renderTime);
+        // headless frames advance by a fixed step, so every run animates exactly the same
+        deltaTime = deterministic ? (float)(1.0 / headlessFps) : currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        processInput(window);
-       
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // the keys would move the camera of a poster, it is drawn from the command line's view
+        if (window != NULL && posterPath.empty())
+        {
+            processInput(window);
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        }
+        else if (benchmark)
+            FlyBenchmarkPath(camera, renderTime, deltaTime);
+
+        // the window draws a step behind the clock, between the two newest states; headless
+        // frames and posters draw the state their own steps just published
+        if (deterministic)
+            simulation.advanceTo(renderTime);
+        simulation.sample(deterministic ? renderTime : renderTime - SIMULATION_STEP, state);
+        sceneTime = state.time;
         /* LIGHTING SETTINGS FOR THE SCENE */
-       
-        SetShader(lightingShader);
+        // only the camera driven values change, the rest of the block was uploaded once
+        lighting.setViewPos(camera.Position);
+        lighting.setSpotLight(camera.Position, camera.Front);
+        lighting.upload();
         
-        /* INITIALIZE VARAIBLES */
-        glm::mat4 projection, view, model, light_models, model_dish;
+        /* SATELLITES */
+        // every satellite orbits like the original one, spread over orbit planes and phases
+        if (catalogReady && catalogLoader.joinable())
+            catalogLoader.join();
+        if (!state.positions.empty())
+        {
+            // SGP4 positions in TEME, z is the earth axis and the scene's earth axis is y
+            if (constellation.size() != state.positions.size() / 3)
+                constellation.resize((unsigned int)(state.positions.size() / 3));
+            glm::mat4 body = SatelliteBodyMatrix();
+            jobs.parallelFor(constellation.size(), SATELLITE_TRANSFORM_GRAIN, [&](std::size_t begin, std::size_t end) {
+                for (unsigned int i = (unsigned int)begin; i < end; i++)
+                    constellation.setSatellite(i, Sgp4SatelliteMatrix(&state.positions[i * 3], body), (float)(i % 4));
+            });
+        }
+        else
+        {
+            jobs.parallelFor(constellation.size(), SATELLITE_TRANSFORM_GRAIN, [&](std::size_t begin, std::size_t end) {
+                for (unsigned int i = (unsigned int)begin; i < end; i++)
+                    constellation.setSatellite(i, OrbitSatelliteMatrix(i, constellation.size(), state.trajectory), (float)(i % 4));
+            });
+        }
 
         /* SET PROJECTION
         /****************************************************************/
+        glm::mat4 projection;
         if (onPerspective)
             projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         if (!onPerspective)
             projection = glm::ortho(-2.0f, 2.0f, -1.5f, 1.5f, 1.0f, 100.0f);
-       
-
 
-        /* SET SHADER */
-        view = camera.GetViewMatrix();
-        lightingShader.use();
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, earthTexture);
-        lightingShader.setMat4("model", model);
-        model = glm::mat4(.5f);
-        // code to make the earth spin in place
-        model = glm::translate(model, glm::vec3(-.411121f, -1.2946 -45.8946f, -4.90606));
-      //  model = glm::rotate(model, (GLfloat)glfwGetTime() * glm::radians(10.0f), glm::vec3(0.0, 0.100f, 0.0));
-        model = glm::scale(model, glm::vec3(17));
-        lightingShader.setMat4("model", model);
-        Sphere sphere;
-        sphere.Draw();
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, panelTexture);
-        lightingShader.setMat4("model", model);
-        Objects box;
-        box.link(vertices.size() * sizeof(GLfloat), &vertices[0]);
-        for (int i = 0; i <= 5; i++)
+        // the earth level and imagery tiles for the earth's size on screen, on a poster for its size on the whole poster
+        BoundingSphere earthSphere = { EARTH_CENTER, EARTH_RADIUS };
+        glm::mat4 earthProjection = projection;
+        float earthViewportHeight = SCR_HEIGHT;
+        if (!posterPath.empty())
         {
-            if (i == 0)
-            {   /* satellite wing left */
-                model = glm::mat4(1.0f);
-                model = glm::rotate(model, glm::radians(trajectory * 50), glm::vec3(0.0f, 1.0f, 1.0f));
-                model = glm::translate(model, glm::vec3(-2.8004f, -0.900075f, 0.599999f));
-                model = glm::scale(model, glm::vec3(.5f, .2f, .02f));
-
-                lightingShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 1)
-            { /* satellite wing right*/
-                model = glm::mat4(1.0f);
-                model = glm::rotate(model, glm::radians(trajectory * 50), glm::vec3(0.0f, 1.0f, 1.00f));
-                model = glm::translate(model, glm::vec3(-1.96539f, -0.900075f, 0.599999f));
-                model = glm::scale(model, glm::vec3(.5f, .2f, .02f));
-
-                lightingShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 3)
-            { /* satellite body*/
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, satelliteTexture);
-                model = glm::mat4(1.0f);
-                model = glm::rotate(model, glm::radians(trajectory * 50), glm::vec3(0.0f, 1.0f, 1.00f));
-                model = glm::translate(model, glm::vec3(-2.3804f, -0.855599f, 0.629999f));
-                model = glm::scale(model, glm::vec3(.25f));
-                lightingShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
+            earthViewportHeight = (float)posterHeight;
+            if (onPerspective)
+                earthProjection = glm::perspective(glm::radians(camera.Zoom), (float)posterWidth / (float)posterHeight, 0.1f, 100.0f);
+        }
+        earth.select(ProjectedRadius(earthProjection, camera.GetViewMatrix(), earthSphere, earthViewportHeight), earthLodBias);
+        {
+            PROFILE_SCOPE("earth tiles");
+            // headless frames and posters wait for their tiles, so they come out the same every run
+            earthTiles.update(earthProjection, camera.GetViewMatrix(),
+                onPerspective ? camera.Position : EARTH_CENTER - camera.Front * ORTHO_OCCLUSION_DISTANCE,
+                earthSphere, earthViewportHeight, deterministic);
         }
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ufoTexture);
-        model_dish = glm::mat4(1.0f);
-        model_dish = glm::rotate(model_dish, glm::radians(trajectory * 50), glm::vec3(0.0f, 1.0f, 1.00f));
-        model_dish = glm::rotate(model_dish, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.00f));
-        model_dish = glm::translate(model_dish, glm::vec3(-2.3754f, 0.6594f, 0.854999f));
-        model_dish = glm::scale(model_dish, glm::vec3(.3f));
-        lightingShader.setMat4("model", model_dish);
-        Ufo ufo;
-        ufo.Draw();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, panelTexture);
-        lightingShader.setMat4("model", model);
-
-        // satellite right attachment
-        Objects triangle;
-        triangle.link(compassVertices.size() * sizeof(GLfloat), &compassVertices[0]);
-        model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(trajectory * 50), glm::vec3(0.0f, 1.0f, 1.00f));
-        model = glm::translate(model, glm::vec3(-2.31113f, -0.899599f, 0.489f));
-        model = glm::scale(model, glm::vec3(.2));
-        lightingShader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // satellite left attachment
-
-        Objects triangle2;
-        triangle2.link(compass2Vertices.size() * sizeof(GLfloat), &compass2Vertices[0]);
-        model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(trajectory * 50), glm::vec3(0.0f, 1.0f, 1.00f));
-        model = glm::translate(model, glm::vec3(-2.46113f, -0.899599f, 0.504f));
-        model = glm::scale(model, glm::vec3(.2));
-        lightingShader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        // --poster renders the first frame in tiles instead of showing it
+        if (!posterPath.empty())
+        {
+            ProjectionBounds bounds = onPerspective
+                ? PerspectiveBounds(glm::radians(camera.Zoom), (float)posterWidth / (float)posterHeight, 0.1f, 100.0f)
+                : OrthoBounds(-2.0f, 2.0f, -1.5f, 1.5f, 1.0f, 100.0f);
+            RenderPoster(posterPath, posterWidth, posterHeight, posterTile, bounds, drawScene);
+            break;
+        }
 
+        drawScene(projection);
 
-        /* RENDER LIGHTS */
-        pinkShader.setMat4("model", light_models);
-        glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
-        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        glBindVertexArray(lightCubeVAO);
-        float speed = 45.0f;
-        float direction = -1.0;
-        for (unsigned int i = 0; i < 2; i++)
+        /* CAPTURE */
+        // the frame is complete, queue its readback before the swap; the pixels are written frames later
+        if (capture.isOpen())
         {
-            if (i == 1)
-            { /* PINK LIGHTS */
-                pinkShader.use();
-                pinkShader.setMat4("projection", projection);
-                pinkShader.setMat4("view", view);
-                light_models = glm::mat4(1.0f);
-                // code to orbit the lights around the scene
-                light_models = glm::rotate(light_models, (GLfloat)glfwGetTime() * glm::radians(speed) * direction * 2.0f, glm::vec3(0.0f, 1.0f, 0.f));
-                light_models = glm::translate(light_models, lightPositions[i]);
-                light_models = glm::scale(light_models, glm::vec3(.25f));
-                pinkShader.setMat4("model", light_models);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
+            PROFILE_PASS("capture");
+            if (headless)
+                sceneTarget.resolve();
             else
-            { /* PURPLE LIGHTS */
-                purpleShader.use();
-                purpleShader.setMat4("projection", projection);
-                purpleShader.setMat4("view", view);
-                light_models = glm::mat4(1.0f);
-                light_models = glm::rotate(light_models, (GLfloat)glfwGetTime() * glm::radians(speed) * 2.0f, glm::vec3(0.0f, 1.5f, 0.f));
-                light_models = glm::translate(light_models, lightPositions[i]);
-                light_models = glm::scale(light_models, glm::vec3(.25f));
-                purpleShader.setMat4("model", light_models);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
+            {
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+                glReadBuffer(GL_BACK);
             }
+            capture.capture();
         }
 
-        /* RENDER SKYBOX */
-        glDepthFunc(GL_LEQUAL);
-        skyboxShader.use();
-        view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
-        skyboxShader.setMat4("view", view);
-        skyboxShader.setMat4("projection", projection);
-        Objects skybox;
-        skybox.skybox(skyboxVertices.size() * sizeof(GLfloat), &skyboxVertices[0]);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap3Texture);
-        glDrawArrays(GL_TRIANGLES, 0, 72);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
+        /* OVERLAY */
+        // the profiler summary and the counters of the previous frame, this one is still counting
+        if ((showProfile || showStats) && window != NULL)
+        {
+            PROFILE_PASS("overlay");
+            vector<std::string> overlay;
+#if PROFILER_ENABLED
+            if (showProfile)
+                overlay = profiler.getSummary();
+#endif
+            if (showStats)
+                FormatRenderStats(lastStats, overlay);
+            glDisable(GL_DEPTH_TEST);
+            for (size_t i = 0; i < overlay.size(); i++)
+                RenderText(textShader, overlay[i], 10.0f, SCR_HEIGHT - 24.0f - i * 20.0f, 1.0f, glm::vec3(1.0f, 1.0f, .2f));
+            glEnable(GL_DEPTH_TEST);
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (window != NULL)
+        {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        if (benchmark)
+            frameBenchmark.endFrame();
+        frame++;
+        PROFILE_END_FRAME();
+        lastStats = FinishRenderStatsFrame();
+        if (statsFile != NULL && frame % statsInterval == 0)
+            WriteRenderStatsJson(statsFile, frame, lastStats);
+    }
+    if (headless && frame > 0)
+    {
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+        std::cout << "Rendered " << frame << " frames (" << frame / headlessFps << " s of animation) in " << seconds
+                  << " s, " << seconds * 1000.0 / std::max(frame, 1u) << " ms per frame" << std::endl;
+    }
+    int exitCode = 0;
+    if (benchmark)
+    {
+        BenchmarkResult result = frameBenchmark.finish();
+        printf("Benchmark: %u frames, frame p50 %.3f p95 %.3f p99 %.3f ms, cpu p50 %.3f ms, gpu p50 %.3f ms, peak RSS %.1f MB\n",
+            result.frames, result.frame.p50, result.frame.p95, result.frame.p99, result.cpu.p50, result.gpu.p50, result.peakRssMB);
+        FILE* out = fopen(benchmarkOut.c_str(), "w");
+        if (out != NULL)
+        {
+            WriteBenchmarkResult(out, result);
+            fclose(out);
+        }
+        else
+            std::cout << "Failed to open " << benchmarkOut << std::endl;
+        if (!benchmarkBaseline.empty() && !CompareBenchmarkBaseline(benchmarkBaseline, result, benchmarkTolerance / 100.0))
+            exitCode = 1;
+        // a run with at least the constellation's target count also has to stay within its frame time
+        if (constellation.size() >= CONSTELLATION_TARGET_COUNT && result.frame.p95 > CONSTELLATION_TARGET_MS)
+        {
+            printf("Benchmark: frame p95 %.3f ms is over the %.1f ms target for %u satellites\n",
+                result.frame.p95, CONSTELLATION_TARGET_MS, constellation.size());
+            exitCode = 1;
+        }
+        frameBenchmark.release();
     }
+    if (showStats && window == NULL)
+    {
+        vector<std::string> counters;
+        FormatRenderStats(lastStats, counters);
+        for (size_t i = 0; i < counters.size(); i++)
+            std::cout << counters[i] << std::endl;
+    }
+#if PROFILER_ENABLED
+    if (showProfile && window == NULL)
+        profiler.printSummary();
+    profiler.stopTrace();
+    profiler.clear();
+#endif
     /* DELETE VAOS AND CLEAR MEMORY */
+    if (statsFile != NULL)
+        fclose(statsFile);
+    capture.close();
+    simulation.stop();
+    textureLoader.shutdown();
+    jobs.shutdown();
+    earthTiles.close();
+    if (catalogLoader.joinable())
+        catalogLoader.join();
 
 
-    glDeleteVertexArrays(1, &lightCubeVAO);
-    glDeleteBuffers(1, &lightCubeVBO);
+    constellation.clear();
+    lighting.clear();
+    meshes.clear();
 
 
     glDeleteTextures(1, &flowerTexture);
@@ -457,9 +954,126 @@ int main()
     glDeleteShader(skyboxShader.ID);
     glDeleteShader(pinkShader.ID);
     glDeleteShader(lightCubeShader.ID);
+    glDeleteShader(satelliteShader.ID);
+    glDeleteShader(textShader.ID);
+    for (std::map<GLchar, Character>::iterator c = Characters.begin(); c != Characters.end(); c++)
+        glDeleteTextures(1, &c->second.TextureID);
+    glDeleteVertexArrays(1, &textVAO);
+    glDeleteBuffers(1, &textVBO);
+
+    sceneTarget.release();
+    headlessContext.destroy();
+    if (window != NULL)
+        glfwTerminate();
+    return exitCode;
+}
 
-    glfwTerminate();
-    return 0;
+// function to read a TLE/OMM file into an SGP4 catalog, called on the loader thread
+void LoadCatalog(const std::string& path, Sgp4Catalog& target)
+{
+    PROFILE_SCOPE("load catalog");
+    vector<TwoLineElement> elements;
+    CatalogLoadReport report;
+    LoadCatalogFile(path, elements, report);
+    PrintCatalogLoadReport(path, report);
+    target.reserve(elements.size());
+    size_t rejected = 0;
+    for (size_t e = 0; e < elements.size(); e++)
+    {
+        if (!target.add(elements[e]))
+            rejected++;
+    }
+    if (rejected > 0)
+        cout << "Skipped " << rejected << " records whose elements SGP4 cannot propagate" << endl;
+}
+
+/* TEXT RENDERING */
+// function to render the first 128 ascii characters of a font into one texture each
+bool LoadFont(const char* path, unsigned int pixelHeight)
+{
+    FT_Library ft;
+    if (FT_Init_FreeType(&ft))
+    {
+        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return false;
+    }
+    FT_Face face;
+    if (FT_New_Face(ft, path, 0, &face))
+    {
+        std::cout << "ERROR::FREETYPE: Failed to load font " << path << std::endl;
+        FT_Done_FreeType(ft);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, pixelHeight);
+
+    // the glyph bitmaps are one byte per pixel without row padding
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLubyte c = 0; c < 128; c++)
+    {
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+            continue;
+        GLuint texture;
+        glGenTextures(1, &texture);
+        countedBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, 0, GL_RED,
+            GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        Character character = {
+            texture,
+            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
+            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
+            (GLuint)face->glyph->advance.x
+        };
+        Characters.insert(std::pair<GLchar, Character>(c, character));
+    }
+    countedBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    return true;
+}
+
+// function to draw a line of text, x and y are the baseline start in pixels from the bottom left
+void RenderText(CachedShader& s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+{
+    s.use();
+    s.setVec3("textColor", color);
+    glActiveTexture(GL_TEXTURE0);
+    countedBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    for (std::string::const_iterator c = text.begin(); c != text.end(); c++)
+    {
+        std::map<GLchar, Character>::const_iterator found = Characters.find(*c);
+        if (found == Characters.end())
+            continue;
+        const Character& ch = found->second;
+
+        GLfloat xpos = x + ch.Bearing.x * scale;
+        GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+        GLfloat w = ch.Size.x * scale;
+        GLfloat h = ch.Size.y * scale;
+        GLfloat vertices[6][4] = {
+            { xpos,     ypos + h,   0.0f, 0.0f },
+            { xpos,     ypos,       0.0f, 1.0f },
+            { xpos + w, ypos,       1.0f, 1.0f },
+
+            { xpos,     ypos + h,   0.0f, 0.0f },
+            { xpos + w, ypos,       1.0f, 1.0f },
+            { xpos + w, ypos + h,   1.0f, 0.0f }
+        };
+        countedBindTexture(GL_TEXTURE_2D, ch.TextureID);
+        countedBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+        countedDrawArrays(GL_TRIANGLES, 0, 6);
+        // the advance is in 1/64 pixels
+        x += (ch.Advance >> 6) * scale;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    countedBindVertexArray(0);
+    countedBindTexture(GL_TEXTURE_2D, 0);
 }
 
 /* PROCESS INPUT */
@@ -495,8 +1109,17 @@ void processInput(GLFWwindow* window)
         z -= .005;
     if ((glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS))
         z += .005;
-    if ((glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS))
-        trajectory += .05;
+    // the satellites run forward while M is held
+    simulation.setAdvancing(glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS);
+    // [ and ] draw the earth one lod level coarser or finer than its size asks for, once per key press
+    static bool tessellationKeyDown = false;
+    bool coarser = glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+    bool finer = glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+    if (!tessellationKeyDown && coarser && earthLodBias > -3.0f)
+        earthLodBias -= 1.0f;
+    if (!tessellationKeyDown && finer && earthLodBias < 3.0f)
+        earthLodBias += 1.0f;
+    tessellationKeyDown = coarser || finer;
     if ((glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS))
         std::cout << "( " << x << "f, " << y << "f, " << z << "f)" << std::endl;
 
@@ -551,69 +1174,80 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-void SetShader(Shader lightingShader)
+void SetLights(LightingBlock& lighting)
 {
-    lightingShader.use();
-    lightingShader.setVec3("viewPos", camera.Position);
-    lightingShader.setFloat("material.shininess", 32.0f);
-
     // directional light
-    lightingShader.setVec3("dirLight.direction", 0.2f, 0.0f, 0.3f);
-    lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-    lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-    lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-    // point light 1
-    lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-    lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-    lightingShader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-    lightingShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-    lightingShader.setFloat("pointLights[0].constant", 1.0f);
-    lightingShader.setFloat("pointLights[0].linear", 0.09f);
-    lightingShader.setFloat("pointLights[0].quadratic", 0.032f);
-    // point light 2
-    lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-    lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-    lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-    lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-    lightingShader.setFloat("pointLights[1].constant", 1.0f);
-    lightingShader.setFloat("pointLights[1].linear", 0.09f);
-    lightingShader.setFloat("pointLights[1].quadratic", 0.032f);
-    // point light 3
-    lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-    lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-    lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-    lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-    lightingShader.setFloat("pointLights[2].constant", 1.0f);
-    lightingShader.setFloat("pointLights[2].linear", 0.09f);
-    lightingShader.setFloat("pointLights[2].quadratic", 0.032f);
-    // point light 4
-    lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-    lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-    lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-    lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-    lightingShader.setFloat("pointLights[3].constant", 1.0f);
-    lightingShader.setFloat("pointLights[3].linear", 0.09f);
-    lightingShader.setFloat("pointLights[3].quadratic", 0.032f);
-    // spotLight
-    lightingShader.setVec3("spotLight.position", camera.Position);
-    lightingShader.setVec3("spotLight.direction", camera.Front);
-    lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-    lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-    lightingShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-    lightingShader.setFloat("spotLight.constant", 1.0f);
-    lightingShader.setFloat("spotLight.linear", 0.09f);
-    lightingShader.setFloat("spotLight.quadratic", 0.032f);
-    lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-    lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-
-    float ambient[] = { 0.5f, 0.5f, 0.5f, 1 };
-    float diffuse[] = { 0.8f, 0.8f, 0.8f, 1 };
-    float specular[] = { 1.0f, 1.0f, 1.0f, 1 };
-    float shininess = 128;
-    glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
-    glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
-
-
-}
\ No newline at end of file
+    lighting.data.dirLight.direction = glm::vec3(0.2f, 0.0f, 0.3f);
+    lighting.data.dirLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+    lighting.data.dirLight.diffuse = glm::vec3(0.4f, 0.4f, 0.4f);
+    lighting.data.dirLight.specular = glm::vec3(0.5f, 0.5f, 0.5f);
+    // point lights
+    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+    {
+        lighting.data.pointLights[i].position = pointLightPositions[i];
+        lighting.data.pointLights[i].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+        lighting.data.pointLights[i].diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+        lighting.data.pointLights[i].specular = glm::vec3(1.0f, 1.0f, 1.0f);
+        lighting.data.pointLights[i].constant = 1.0f;
+        lighting.data.pointLights[i].linear = 0.09f;
+        lighting.data.pointLights[i].quadratic = 0.032f;
+    }
+    // spotLight, its position and direction follow the camera every frame
+    lighting.data.viewPos = camera.Position;
+    lighting.data.spotLight.position = camera.Position;
+    lighting.data.spotLight.direction = camera.Front;
+    lighting.data.spotLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+    lighting.data.spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+    lighting.data.spotLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    lighting.data.spotLight.constant = 1.0f;
+    lighting.data.spotLight.linear = 0.09f;
+    lighting.data.spotLight.quadratic = 0.032f;
+    lighting.data.spotLight.cutOff = glm::cos(glm::radians(12.5f));
+    lighting.data.spotLight.outerCutOff = glm::cos(glm::radians(15.0f));
+    lighting.markAllDirty();
+    lighting.upload();
+}
+
+// function to test a light cube against the view and the earth, counting the ones skipped
+bool LightVisible(const Frustum& frustum, const SphereOccluder& earth, const Bounds& bounds, const glm::mat4& model)
+{
+    if (!AabbInFrustum(frustum, TransformAabb(bounds.box, model)))
+    {
+        renderStats.frustumCulled++;
+        return false;
+    }
+    if (SphereOccluded(earth, TransformSphere(bounds.sphere, model)))
+    {
+        renderStats.occlusionCulled++;
+        return false;
+    }
+    return true;
+}
+// function to cook every texture main() loads and the skybox on all cores, for --cook-textures
+bool CookTextures(bool compress)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CookedTexture cooked[TEXTURE_COUNT + 1];
+    bool done[TEXTURE_COUNT + 1];
+    jobs.init();
+    jobs.parallelFor(TEXTURE_COUNT + 1, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            std::vector<std::string> sources(1, i < TEXTURE_COUNT ? TEXTURE_FILES[i] : "");
+            if (i == TEXTURE_COUNT)
+                sources.assign(CUBEMAP_FILES, CUBEMAP_FILES + 6);
+            done[i] = CookTexture(sources, compress, cooked[i]);
+        }
+    });
+    jobs.shutdown();
+
+    bool cookedAll = true;
+    for (unsigned int i = 0; i <= TEXTURE_COUNT; i++)
+    {
+        cookedAll = cookedAll && done[i];
+        if (done[i])
+            printf("%-48s %8.1f KB %8.1f ms\n", cooked[i].path.c_str(), cooked[i].size / 1024.0, cooked[i].seconds * 1000.0);
+    }
+    printf("cooked in %.1f ms\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return cookedAll;
+}
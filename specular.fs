@@ -47,12 +47,19 @@ struct SpotLight {
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in float Variant;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
+// shared by every lit program, filled from LightingBlock in lighting.h
+layout (std140) uniform Lighting
+{
+    vec3 viewPos;
+    SpotLight spotLight;
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+};
 uniform Material material;
+// tint of satellite variants 1 to 3, variant 0 is drawn untinted
+uniform vec3 variantTint[3];
 
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
@@ -79,6 +86,9 @@ void main()
     // phase 3: spot light
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
     
+    if (Variant > 0.5)
+        result *= variantTint[int(Variant) - 1];
+
     FragColor = vec4(result, 1.0);
 }
 
@@ -144,4 +154,4 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
\ No newline at end of file
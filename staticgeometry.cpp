@@ -0,0 +1,106 @@
+#include "staticgeometry.h"
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// floats per packed vertex: position, normal, tex coord
+const unsigned int PACKED_FLOATS = 8;
+
+// one packed vertex, compared bit for bit so only exact duplicates are merged
+struct PackedVertex
+{
+    GLfloat v[PACKED_FLOATS];
+
+    bool operator==(const PackedVertex& other) const
+    {
+        return memcmp(v, other.v, sizeof(v)) == 0;
+    }
+};
+
+struct PackedVertexHash
+{
+    std::size_t operator()(const PackedVertex& vertex) const
+    {
+        // FNV-1a over the raw bytes of the vertex
+        const unsigned char* bytes = (const unsigned char*)vertex.v;
+        std::size_t hash = 2166136261u;
+        for (std::size_t i = 0; i < sizeof(vertex.v); i++)
+            hash = (hash ^ bytes[i]) * 16777619u;
+        return hash;
+    }
+};
+
+StaticGeometry::StaticGeometry() : sourceVertexCount(0), vertexCount(0)
+{
+    memset(shapes, 0, sizeof(shapes));
+}
+// function to pack every shape into one buffer and register a sub mesh per shape
+void StaticGeometry::build(MeshRegistry& meshes)
+{
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    sourceVertexCount = 0;
+
+    for (int s = 0; s < SHAPE_COUNT; s++)
+    {
+        GeometryShapeData data = Geometry::GetShape((GeometryShape)s);
+        ShapeRange& range = shapes[s];
+        range.baseVertex = (GLint)(vertices.size() / PACKED_FLOATS);
+        range.firstIndex = (GLuint)indices.size();
+        sourceVertexCount += data.vertexCount;
+
+        // expand to the shared layout (the skybox has no normal or tex coord) and
+        // drop duplicates, indices are local to the shape and offset by baseVertex
+        std::unordered_map<PackedVertex, GLuint, PackedVertexHash> unique;
+        std::vector<GLuint> remap(data.vertexCount);
+        GLuint shapeVertices = 0;
+        for (unsigned int i = 0; i < data.vertexCount; i++)
+        {
+            PackedVertex vertex;
+            memset(vertex.v, 0, sizeof(vertex.v));
+            memcpy(vertex.v, data.vertices + i * data.floatsPerVertex, data.floatsPerVertex * sizeof(GLfloat));
+            std::pair<std::unordered_map<PackedVertex, GLuint, PackedVertexHash>::iterator, bool> found =
+                unique.insert(std::make_pair(vertex, shapeVertices));
+            if (found.second)
+            {
+                vertices.insert(vertices.end(), vertex.v, vertex.v + PACKED_FLOATS);
+                shapeVertices++;
+            }
+            remap[i] = found.first->second;
+        }
+
+        if (data.indices != NULL)
+        {
+            for (unsigned int i = 0; i < data.indexCount; i++)
+                indices.push_back(remap[data.indices[i]]);
+            range.indexCount = (GLsizei)data.indexCount;
+        }
+        else
+        {
+            indices.insert(indices.end(), remap.begin(), remap.end());
+            range.indexCount = (GLsizei)data.vertexCount;
+        }
+    }
+    vertexCount = (unsigned int)(vertices.size() / PACKED_FLOATS);
+
+    // one VAO for all the shapes, every shape is a range of it
+    MeshHandle packed = meshes.addIndexed(&vertices[0], vertices.size() * sizeof(GLfloat), &indices[0],
+        (GLsizei)indices.size(), LAYOUT_POSITION_NORMAL_TEXCOORD);
+    for (int s = 0; s < SHAPE_COUNT; s++)
+        shapes[s].mesh = meshes.addSubMesh(packed, shapes[s].firstIndex, shapes[s].indexCount, shapes[s].baseVertex);
+}
+
+MeshHandle StaticGeometry::get(GeometryShape shape) const
+{
+    return shapes[shape].mesh;
+}
+// number of vertices in the Geometry tables before de-duplication
+unsigned int StaticGeometry::getSourceVertexCount() const
+{
+    return sourceVertexCount;
+}
+// number of vertices in the shared buffer
+unsigned int StaticGeometry::getVertexCount() const
+{
+    return vertexCount;
+}
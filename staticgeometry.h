@@ -0,0 +1,36 @@
+#pragma once
+#ifndef STATICGEOMETRY_H
+#define STATICGEOMETRY_H
+
+#include <glad/glad.h>
+#include "geometry.h"
+#include "meshregistry.h"
+
+// every Geometry table packed into one indexed vertex/index buffer at startup.
+// shapes are de-duplicated (the 36 cube corners become 24 vertices) and each
+// one is a sub mesh of the shared VAO, drawn with glDrawElementsBaseVertex
+class StaticGeometry
+{
+public:
+    StaticGeometry();
+
+    void build(MeshRegistry& meshes);
+    MeshHandle get(GeometryShape shape) const;
+    unsigned int getSourceVertexCount() const;
+    unsigned int getVertexCount() const;
+
+private:
+    struct ShapeRange
+    {
+        MeshHandle mesh;
+        GLint baseVertex;
+        GLuint firstIndex;
+        GLsizei indexCount;
+    };
+
+    ShapeRange shapes[SHAPE_COUNT];
+    unsigned int sourceVertexCount;
+    unsigned int vertexCount;
+};
+
+#endif
@@ -5,8 +5,10 @@ out vec4 color;
 in vec2 texCoord;
 
 uniform sampler2D ourTexture;
+uniform vec3 textColor;
 
+// the glyph textures hold coverage in the red channel
 void main()
 {
-	color = texture(ourTexture, texCoord);
-}
\ No newline at end of file
+	color = vec4(textColor, texture(ourTexture, texCoord).r);
+}
@@ -0,0 +1,639 @@
+#include "texturecache.h"
+#include "textureloader.h"
+#include "renderstats.h"
+#include "jobs.h"
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// the extension's formats are not in a core profile loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// the \r\n catches files mangled by a text mode copy, like PNG's signature
+const char COOKED_MAGIC[8] = { 'S', 'A', 'T', 'T', 'E', 'X', '\r', '\n' };
+// changing the layout or the cooking bumps it, which makes every cooked file out of date
+const unsigned int COOKED_VERSION = 1;
+// the pixels of every level start on this boundary
+const std::size_t COOKED_ALIGNMENT = 16;
+const unsigned int COOKED_MAX_LEVELS = 32;
+
+const unsigned long long HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+const unsigned long long HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+/* SOURCE HASH */
+
+static unsigned long long RotateLeft(unsigned long long value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// function to hash bytes 32 at a time in four independent lanes (the xxHash64 scheme), so
+// hashing a source on every start costs about as much as reading it
+static unsigned long long HashBytes(const unsigned char* data, std::size_t size, unsigned long long seed)
+{
+    unsigned long long lanes[4] = { seed + HASH_PRIME_1 + HASH_PRIME_2, seed + HASH_PRIME_2, seed, seed - HASH_PRIME_1 };
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            unsigned long long word;
+            memcpy(&word, data + i + lane * 8, 8);
+            lanes[lane] = RotateLeft(lanes[lane] + word * HASH_PRIME_2, 31) * HASH_PRIME_1;
+        }
+    }
+    unsigned long long hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+    hash += (unsigned long long)size;
+    for (; i < size; i++)
+        hash = RotateLeft(hash ^ (data[i] * HASH_PRIME_1), 11) * HASH_PRIME_2;
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= HASH_PRIME_1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// function to hash the hashes of the sources in order, each source is hashed on its own so
+// the faces of a cubemap can be hashed in parallel
+static unsigned long long CombineHashes(const std::vector<unsigned long long>& hashes)
+{
+    return HashBytes((const unsigned char*)&hashes[0], hashes.size() * sizeof(hashes[0]), hashes.size());
+}
+
+// function to hash the source files, false when one cannot be read
+static bool HashSources(const std::vector<std::string>& sources, unsigned long long& hash)
+{
+    std::vector<unsigned long long> hashes(sources.size());
+    for (std::size_t i = 0; i < sources.size(); i++)
+    {
+        MappedFile source;
+        if (!source.open(sources[i]))
+            return false;
+        hashes[i] = HashBytes((const unsigned char*)source.data, source.size, 0);
+    }
+    hash = CombineHashes(hashes);
+    return true;
+}
+
+/* COOKED FILE */
+
+static bool IsCompressed(unsigned int format)
+{
+    return format == COOKED_BC1 || format == COOKED_BC3;
+}
+
+static unsigned int FormatChannels(unsigned int format)
+{
+    if (format == COOKED_R8)
+        return 1;
+    if (format == COOKED_RGB8 || format == COOKED_BC1)
+        return 3;
+    return 4;
+}
+
+// function to get the bytes of a width x height level
+static std::size_t LevelSize(unsigned int format, unsigned int width, unsigned int height)
+{
+    if (IsCompressed(format))
+        return (std::size_t)((width + 3) / 4) * ((height + 3) / 4) * (format == COOKED_BC1 ? 8 : 16);
+    return (std::size_t)width * height * FormatChannels(format);
+}
+
+// function to check that bytes hold a whole cooked file of this version, returns its header or NULL
+static const CookedHeader* ReadCookedHeader(const unsigned char* data, std::size_t size)
+{
+    if (data == NULL || size < sizeof(CookedHeader))
+        return NULL;
+    const CookedHeader* header = (const CookedHeader*)data;
+    if (memcmp(header->magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) != 0 || header->version != COOKED_VERSION)
+        return NULL;
+    if (header->format > COOKED_BC3 || (header->faces != 1 && header->faces != 6) ||
+        header->levels == 0 || header->levels > COOKED_MAX_LEVELS)
+        return NULL;
+    std::size_t count = (std::size_t)header->levels * header->faces;
+    if (size < sizeof(CookedHeader) + count * sizeof(CookedLevel))
+        return NULL;
+    const CookedLevel* levels = (const CookedLevel*)(data + sizeof(CookedHeader));
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (levels[i].offset > size || levels[i].size > size - levels[i].offset ||
+            levels[i].size != LevelSize(header->format, levels[i].width, levels[i].height))
+            return NULL;
+    }
+    return header;
+}
+
+static void MakeCacheDirectory()
+{
+#ifdef _WIN32
+    _mkdir(TEXTURE_CACHE_DIRECTORY);
+#else
+    mkdir(TEXTURE_CACHE_DIRECTORY, 0755);
+#endif
+}
+
+// function to write the file next to its place and move it there, so a crash or a second
+// instance never leaves a half written file under the cooked name
+static bool WriteCookedFile(const std::string& path, const std::vector<unsigned char>& bytes)
+{
+    MakeCacheDirectory();
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == NULL)
+        return false;
+    bool written = fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+    written = fclose(file) == 0 && written;
+    if (written)
+    {
+        // rename does not replace an existing file on windows
+        remove(path.c_str());
+        written = rename(temporary.c_str(), path.c_str()) == 0;
+    }
+    if (!written)
+        remove(temporary.c_str());
+    return written;
+}
+
+/* BLOCK COMPRESSION */
+
+static unsigned short PackColor565(const int* rgb)
+{
+    return (unsigned short)(((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 | ((rgb[2] * 31 + 127) / 255));
+}
+
+static void UnpackColor565(unsigned short color, int* rgb)
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// function to encode the colors of a 4x4 block as BC1. the end points are the corners of the
+// colors' bounding box, on the diagonal the colors lean along and pulled in by a sixteenth
+// (as in van Waveren's real-time DXT compression), each pixel takes the nearest of the four
+// palette colors
+static void EncodeColorBlock(const unsigned char block[16][4], unsigned char* out)
+{
+    int low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            low[c] = block[i][c] < low[c] ? block[i][c] : low[c];
+            high[c] = block[i][c] > high[c] ? block[i][c] : high[c];
+        }
+    }
+    // red and blue run against green in the block: flip them so the ends follow the colors
+    int center[3] = { (low[0] + high[0]) / 2, (low[1] + high[1]) / 2, (low[2] + high[2]) / 2 };
+    int redGreen = 0, blueGreen = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int green = block[i][1] - center[1];
+        redGreen += (block[i][0] - center[0]) * green;
+        blueGreen += (block[i][2] - center[2]) * green;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (high[c] - low[c]) >> 4;
+        low[c] += inset;
+        high[c] -= inset;
+    }
+    int first[3] = { high[0], high[1], high[2] }, second[3] = { low[0], low[1], low[2] };
+    if (redGreen < 0)
+    {
+        first[0] = low[0];
+        second[0] = high[0];
+    }
+    if (blueGreen < 0)
+    {
+        first[2] = low[2];
+        second[2] = high[2];
+    }
+
+    unsigned short color0 = PackColor565(first), color1 = PackColor565(second);
+    // color0 > color1 selects the four color mode
+    if (color0 < color1)
+    {
+        unsigned short swap = color0;
+        color0 = color1;
+        color1 = swap;
+    }
+    unsigned int indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        UnpackColor565(color0, palette[0]);
+        UnpackColor565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestDistance = 0x7fffffff;
+            for (int p = 0; p < 4; p++)
+            {
+                int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (unsigned int)best << (i * 2);
+        }
+    }
+    out[0] = (unsigned char)(color0 & 0xff);
+    out[1] = (unsigned char)(color0 >> 8);
+    out[2] = (unsigned char)(color1 & 0xff);
+    out[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+// function to encode the alpha of a 4x4 block as the first half of a BC3 block: the lowest
+// and highest alpha with six steps between them, 3 bits per pixel
+static void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char* out)
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        low = block[i][3] < low ? block[i][3] : low;
+        high = block[i][3] > high ? block[i][3] : high;
+    }
+    unsigned long long indices = 0;
+    if (high != low)
+    {
+        int palette[8] = { high, low };
+        for (int p = 2; p < 8; p++)
+            palette[p] = ((8 - p) * high + (p - 1) * low) / 7;
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestDistance = 256;
+            for (int p = 0; p < 8; p++)
+            {
+                int distance = block[i][3] > palette[p] ? block[i][3] - palette[p] : palette[p] - block[i][3];
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (unsigned long long)best << (i * 3);
+        }
+    }
+    out[0] = (unsigned char)high;
+    out[1] = (unsigned char)low;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+// function to encode a level as BC1 or BC3 blocks, the edge pixels repeat into blocks that
+// stick out of the image
+static void EncodeBlocks(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int channels,
+                         unsigned int format, unsigned char* out)
+{
+    unsigned char block[16][4];
+    for (unsigned int by = 0; by < height; by += 4)
+    {
+        for (unsigned int bx = 0; bx < width; bx += 4)
+        {
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                unsigned int x = bx + i % 4, y = by + i / 4;
+                x = x < width ? x : width - 1;
+                y = y < height ? y : height - 1;
+                const unsigned char* pixel = pixels + ((std::size_t)y * width + x) * channels;
+                block[i][0] = pixel[0];
+                block[i][1] = pixel[1];
+                block[i][2] = pixel[2];
+                block[i][3] = channels == 4 ? pixel[3] : 255;
+            }
+            if (format == COOKED_BC3)
+            {
+                EncodeAlphaBlock(block, out);
+                out += 8;
+            }
+            EncodeColorBlock(block, out);
+            out += 8;
+        }
+    }
+}
+
+void HalveImage(const std::vector<unsigned char>& source, unsigned int width, unsigned int height, unsigned int channels,
+                       std::vector<unsigned char>& target)
+{
+    unsigned int halfWidth = width > 1 ? width / 2 : 1, halfHeight = height > 1 ? height / 2 : 1;
+    target.resize((std::size_t)halfWidth * halfHeight * channels);
+    for (unsigned int y = 0; y < halfHeight; y++)
+    {
+        unsigned int y0 = y * 2, y1 = y0 + 1 < height ? y0 + 1 : y0;
+        for (unsigned int x = 0; x < halfWidth; x++)
+        {
+            unsigned int x0 = x * 2, x1 = x0 + 1 < width ? x0 + 1 : x0;
+            for (unsigned int c = 0; c < channels; c++)
+            {
+                unsigned int sum = source[((std::size_t)y0 * width + x0) * channels + c] + source[((std::size_t)y0 * width + x1) * channels + c] +
+                                   source[((std::size_t)y1 * width + x0) * channels + c] + source[((std::size_t)y1 * width + x1) * channels + c];
+                target[((std::size_t)y * halfWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+/* COOKING */
+
+// function to spell a path one way: forward slashes, no empty or "." parts and "dir/.."
+// taken out, so "a\\b/../c//d.png" and "a/c/d.png" name the same source
+static std::string NormalizePath(const std::string& path)
+{
+    std::vector<std::string> parts;
+    bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    std::size_t begin = 0;
+    while (begin <= path.size())
+    {
+        std::size_t end = path.find_first_of("/\\", begin);
+        if (end == std::string::npos)
+            end = path.size();
+        std::string part = path.substr(begin, end - begin);
+        if (part == ".." && !parts.empty() && parts.back() != "..")
+            parts.pop_back();
+        else if (!part.empty() && part != ".")
+            parts.push_back(part);
+        begin = end + 1;
+    }
+    std::string normalized = absolute ? "/" : "";
+    for (std::size_t i = 0; i < parts.size(); i++)
+        normalized += (i > 0 ? "/" : "") + parts[i];
+    return normalized;
+}
+
+// the file is named after the first source for people looking into the cache, the hash of
+// every source's whole path keeps same named images from different directories apart
+std::string CookedPath(const std::vector<std::string>& sources)
+{
+    std::string paths;
+    for (std::size_t i = 0; i < sources.size(); i++)
+        paths += NormalizePath(sources[i]) + "\n";
+    unsigned long long hash = HashBytes((const unsigned char*)paths.data(), paths.size(), 0);
+    char key[24];
+    snprintf(key, sizeof(key), "-%016llx", hash);
+
+    const std::string& source = sources[0];
+    std::size_t slash = source.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? source : source.substr(slash + 1);
+    return std::string(TEXTURE_CACHE_DIRECTORY) + "/" + name + key + (sources.size() == 6 ? ".cube" : "") + ".tex";
+}
+
+bool CookTexture(const std::vector<std::string>& sources, bool compress, CookedTexture& texture)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FreeCookedTexture(texture);
+    texture.path = CookedPath(sources);
+
+    // the faces of a cubemap decode in parallel, every source is hashed from the same bytes it
+    // is decoded from. called from textureLoader's background task the face tasks are
+    // background tasks as well
+    unsigned int faces = (unsigned int)sources.size();
+    std::vector<std::vector<unsigned char> > images(faces);
+    std::vector<unsigned long long> hashes(faces, 0);
+    std::vector<int> widths(faces, 0), heights(faces, 0), channelCounts(faces, 0);
+    jobs.parallelFor(faces, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t face = begin; face < end; face++)
+        {
+            MappedFile source;
+            if (!source.open(sources[face]) || source.size == 0)
+                continue;
+            hashes[face] = HashBytes((const unsigned char*)source.data, source.size, 0);
+            unsigned char* pixels = stbi_load_from_memory((const unsigned char*)source.data, (int)source.size,
+                &widths[face], &heights[face], &channelCounts[face], 0);
+            if (pixels == NULL)
+                continue;
+            images[face].assign(pixels, pixels + (std::size_t)widths[face] * heights[face] * channelCounts[face]);
+            stbi_image_free(pixels);
+        }
+    });
+    for (unsigned int face = 0; face < faces; face++)
+    {
+        if (images[face].empty())
+        {
+            std::cout << "Texture failed to load at path: " << sources[face] << std::endl;
+            return false;
+        }
+        if (widths[face] != widths[0] || heights[face] != heights[0] || channelCounts[face] != channelCounts[0])
+        {
+            std::cout << "Cubemap faces differ in size at path: " << sources[face] << std::endl;
+            return false;
+        }
+    }
+    unsigned long long hash = CombineHashes(hashes);
+    int width = widths[0], height = heights[0], channels = channelCounts[0];
+    if (channels == 2)
+    {
+        std::cout << "Texture has an unsupported format at path: " << sources[0] << std::endl;
+        return false;
+    }
+
+    unsigned int format = channels == 1 ? COOKED_R8 : (channels == 3 ? COOKED_RGB8 : COOKED_RGBA8);
+    if (compress && channels > 1)
+        format = channels == 3 ? COOKED_BC1 : COOKED_BC3;
+    unsigned int levels = 1;
+    if (faces == 1)
+    {
+        for (unsigned int size = width > height ? width : height; size > 1; size /= 2)
+            levels++;
+    }
+
+    CookedHeader header;
+    memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+    header.version = COOKED_VERSION;
+    header.format = format;
+    header.width = (unsigned int)width;
+    header.height = (unsigned int)height;
+    header.faces = faces;
+    header.levels = levels;
+    header.sourceHash = hash;
+
+    std::vector<CookedLevel> table(levels * faces);
+    std::size_t offset = sizeof(CookedHeader) + table.size() * sizeof(CookedLevel);
+    unsigned int levelWidth = header.width, levelHeight = header.height;
+    for (unsigned int level = 0; level < levels; level++)
+    {
+        for (unsigned int face = 0; face < faces; face++)
+        {
+            CookedLevel& entry = table[level * faces + face];
+            offset = (offset + COOKED_ALIGNMENT - 1) / COOKED_ALIGNMENT * COOKED_ALIGNMENT;
+            entry.offset = offset;
+            entry.size = LevelSize(format, levelWidth, levelHeight);
+            entry.width = levelWidth;
+            entry.height = levelHeight;
+            offset += (std::size_t)entry.size;
+        }
+        levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+        levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+    }
+
+    std::vector<unsigned char>& bytes = texture.memory;
+    bytes.assign(offset, 0);
+    memcpy(&bytes[0], &header, sizeof(header));
+    memcpy(&bytes[sizeof(header)], &table[0], table.size() * sizeof(CookedLevel));
+    std::vector<unsigned char> halved;
+    for (unsigned int level = 0; level < levels; level++)
+    {
+        for (unsigned int face = 0; face < faces; face++)
+        {
+            const CookedLevel& entry = table[level * faces + face];
+            if (IsCompressed(format))
+                EncodeBlocks(&images[face][0], entry.width, entry.height, channels, format, &bytes[entry.offset]);
+            else
+                memcpy(&bytes[entry.offset], &images[face][0], entry.size);
+            if (level + 1 < levels)
+            {
+                HalveImage(images[face], entry.width, entry.height, channels, halved);
+                images[face].swap(halved);
+            }
+        }
+    }
+
+    // a cache that cannot be written only costs the next start the cooking again
+    if (!WriteCookedFile(texture.path, bytes))
+        std::cout << "Could not write the cooked texture " << texture.path << std::endl;
+    texture.data = &bytes[0];
+    texture.size = bytes.size();
+    texture.recooked = true;
+    texture.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool PrepareCookedTexture(const std::vector<std::string>& sources, bool allowCompressed, CookedTexture& texture)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FreeCookedTexture(texture);
+    texture.path = CookedPath(sources);
+
+    bool compress = false;
+    if (texture.file.open(texture.path))
+    {
+        const unsigned char* data = (const unsigned char*)texture.file.data;
+        const CookedHeader* header = ReadCookedHeader(data, texture.file.size);
+        if (header != NULL && header->faces == sources.size())
+        {
+            compress = IsCompressed(header->format);
+            // without the sources the cooked file is all there is, it is used as it is
+            unsigned long long hash;
+            bool upToDate = !HashSources(sources, hash) || hash == header->sourceHash;
+            if (upToDate && (allowCompressed || !compress))
+            {
+                texture.data = data;
+                texture.size = texture.file.size;
+                texture.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                return true;
+            }
+        }
+        texture.file.close();
+    }
+    return CookTexture(sources, compress && allowCompressed, texture);
+}
+
+void FreeCookedTexture(CookedTexture& texture)
+{
+    texture.file.close();
+    std::vector<unsigned char>().swap(texture.memory);
+    texture.data = NULL;
+    texture.size = 0;
+    texture.recooked = false;
+    texture.seconds = 0.0;
+}
+
+/* UPLOAD */
+
+bool CompressedTexturesSupported()
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (name != NULL && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+            return true;
+    }
+    return false;
+}
+
+GLuint UploadCookedTexture(const CookedTexture& texture)
+{
+    if (ReadCookedHeader(texture.data, texture.size) == NULL)
+        return 0;
+    GLuint id;
+    glGenTextures(1, &id);
+    FillCookedTexture(id, texture, 0);
+    return id;
+}
+
+void FillCookedTexture(GLuint id, const CookedTexture& texture, GLuint unpackBuffer)
+{
+    const CookedHeader* header = ReadCookedHeader(texture.data, texture.size);
+    if (header == NULL)
+        return;
+    const CookedLevel* levels = (const CookedLevel*)(texture.data + sizeof(CookedHeader));
+    GLenum target = header->faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLenum compressedFormat = header->format == COOKED_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    GLenum format = ImageFormat((int)FormatChannels(header->format));
+
+    // the whole file goes into the buffer, the levels are at their file offsets in it
+    const unsigned char* base = StageUpload(unpackBuffer, texture.data, texture.size);
+    countedBindTexture(target, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int level = 0; level < header->levels; level++)
+    {
+        for (unsigned int face = 0; face < header->faces; face++)
+        {
+            const CookedLevel& entry = levels[level * header->faces + face];
+            GLenum imageTarget = header->faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+            const unsigned char* pixels = base + entry.offset;
+            if (IsCompressed(header->format))
+                glCompressedTexImage2D(imageTarget, level, compressedFormat, entry.width, entry.height, 0, (GLsizei)entry.size, pixels);
+            else
+                glTexImage2D(imageTarget, level, format, entry.width, entry.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+            renderStats.bytesUploaded += entry.size;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    EndUpload();
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, header->levels - 1);
+
+    if (target == GL_TEXTURE_2D)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    countedBindTexture(target, 0);
+}
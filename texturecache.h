@@ -0,0 +1,90 @@
+#pragma once
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+// the cooked textures live here, one file per texture or cubemap named after its first source
+const char* const TEXTURE_CACHE_DIRECTORY = "resources/cache";
+
+// how the pixels of a cooked texture are stored
+enum CookedFormat
+{
+    COOKED_R8,
+    COOKED_RGB8,
+    COOKED_RGBA8,
+    COOKED_BC1,         // rgb in 8 byte 4x4 blocks (DXT1)
+    COOKED_BC3          // rgba in 16 byte 4x4 blocks (DXT5)
+};
+
+// a cooked file is a header, a table of levels and the pixels of every level, so it is uploaded
+// as it lies on disk without decoding or glGenerateMipmap. a 2D texture has the whole mip chain
+// down to 1x1, a cubemap the six faces of one level (the skybox is not mipmapped)
+struct CookedHeader
+{
+    char magic[8];
+    unsigned int version;
+    unsigned int format;                // CookedFormat
+    unsigned int width;
+    unsigned int height;
+    unsigned int faces;                 // 1 or 6
+    unsigned int levels;
+    unsigned long long sourceHash;      // of the source files the texture was cooked from
+};
+
+// where a level (of a face) is in the file, level by level and the faces of a level in order
+struct CookedLevel
+{
+    unsigned long long offset;
+    unsigned long long size;
+    unsigned int width;
+    unsigned int height;
+};
+
+// a cooked texture ready for the GL thread: the mapped file when it was up to date, or the
+// bytes of the file cooked just now
+struct CookedTexture
+{
+    std::string path;
+    MappedFile file;
+    std::vector<unsigned char> memory;
+    const unsigned char* data;      // NULL when there is nothing to upload
+    std::size_t size;
+    bool recooked;
+    double seconds;                 // spent hashing, or decoding and cooking
+
+    CookedTexture() : data(NULL), size(0), recooked(false), seconds(0.0) {}
+
+private:
+    CookedTexture(const CookedTexture&);
+    CookedTexture& operator=(const CookedTexture&);
+};
+
+// a texture is cooked from one source image, a cubemap from six (right, left, top, bottom, front, back)
+
+// function to get the path of the cooked file of sources: the first one's name and a hash of all their paths
+std::string CookedPath(const std::vector<std::string>& sources);
+// function to map the cooked file of sources, cooking it again first when it is missing or the
+// hash of a source changed. the new file keeps the old one's compression, unless compressed
+// formats are not allowed. any thread
+bool PrepareCookedTexture(const std::vector<std::string>& sources, bool allowCompressed, CookedTexture& texture);
+// function to cook sources into their cooked file even if it is up to date, with BC1/BC3
+// compression when compress is set. any thread
+bool CookTexture(const std::vector<std::string>& sources, bool compress, CookedTexture& texture);
+void FreeCookedTexture(CookedTexture& texture);
+// function to halve an image with a 2x2 box filter, an odd last row or column is left out
+// (a 1 pixel wide or high image keeps its one). the cooked mip chains are made with it
+void HalveImage(const std::vector<unsigned char>& source, unsigned int width, unsigned int height, unsigned int channels,
+                std::vector<unsigned char>& target);
+// function to tell if the GL can sample BC1/BC3 textures (EXT_texture_compression_s3tc), GL thread
+bool CompressedTexturesSupported();
+// function to create the texture or cubemap of a cooked file with every level it has, 0 if there
+// is none. 2D textures repeat and are mipmapped like UploadTexture's, cubemaps clamp like UploadCubemap's
+GLuint UploadCookedTexture(const CookedTexture& texture);
+// function to fill a texture name the same way, copying the file through unpackBuffer when it is not 0
+void FillCookedTexture(GLuint id, const CookedTexture& texture, GLuint unpackBuffer);
+
+#endif
@@ -0,0 +1,289 @@
+#include "textureloader.h"
+#include "renderstats.h"
+#include "stb_image.h"
+
+#include <cstring>
+#include <iostream>
+
+bool DecodeImage(const std::string& path, DecodedImage& image, int channels)
+{
+    image.path = path;
+    image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, channels);
+    if (image.pixels == NULL)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return false;
+    }
+    if (channels != 0)
+        image.channels = channels;
+    return true;
+}
+
+void FreeImage(DecodedImage& image)
+{
+    if (image.pixels != NULL)
+        stbi_image_free(image.pixels);
+    image.pixels = NULL;
+}
+
+GLenum ImageFormat(int channels)
+{
+    if (channels == 1)
+        return GL_RED;
+    if (channels == 4)
+        return GL_RGBA;
+    return GL_RGB;
+}
+
+GLuint UploadTexture(const DecodedImage& image)
+{
+    if (image.pixels == NULL)
+        return 0;
+    GLuint texture;
+    glGenTextures(1, &texture);
+    FillTexture(texture, image, 0);
+    return texture;
+}
+
+GLuint UploadCubemap(const DecodedImage* faces)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    FillCubemap(texture, faces, 0);
+    return texture;
+}
+
+void FillTexture(GLuint texture, const DecodedImage& image, GLuint unpackBuffer)
+{
+    if (image.pixels == NULL)
+        return;
+    std::size_t size = (std::size_t)image.width * image.height * image.channels;
+    const unsigned char* pixels = StageUpload(unpackBuffer, image.pixels, size);
+    countedBindTexture(GL_TEXTURE_2D, texture);
+    // rgb rows of odd widths are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum format = ImageFormat(image.channels);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    EndUpload();
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    countedBindTexture(GL_TEXTURE_2D, 0);
+    renderStats.bytesUploaded += size;
+}
+
+void FillCubemap(GLuint texture, const DecodedImage* faces, GLuint unpackBuffer)
+{
+    countedBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        if (faces[i].pixels == NULL)
+        {
+            std::cout << "Cubemap texture failed to load at path: " << faces[i].path << std::endl;
+            continue;
+        }
+        std::size_t size = (std::size_t)faces[i].width * faces[i].height * faces[i].channels;
+        const unsigned char* pixels = StageUpload(unpackBuffer, faces[i].pixels, size);
+        GLenum format = ImageFormat(faces[i].channels);
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, faces[i].width, faces[i].height, 0, format,
+            GL_UNSIGNED_BYTE, pixels);
+        EndUpload();
+        renderStats.bytesUploaded += size;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    countedBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+// the buffer is given new storage for every upload, so the copy never waits for the GPU to
+// finish reading what the last upload put in it, and glTexImage2D returns without copying
+const unsigned char* StageUpload(GLuint unpackBuffer, const unsigned char* data, std::size_t size)
+{
+    if (unpackBuffer == 0)
+        return data;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+    countedBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == NULL)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return data;
+    }
+    memcpy(mapped, data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    return (const unsigned char*)NULL;
+}
+
+void EndUpload()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/* TEXTURE LOADER */
+
+TextureLoader textureLoader;
+
+TextureLoader::TextureLoader() : unpackBuffer(0), pending(0), loaded(0), decodeSeconds(0.0), reporting(true)
+{
+
+}
+
+TextureLoader::Request& TextureLoader::add(unsigned int faces, bool cooked)
+{
+    if (pending == 0)
+        firstRequest = std::chrono::steady_clock::now();
+    pending++;
+    requests.emplace_back();
+    Request& request = requests.back();
+    glGenTextures(1, &request.texture);
+    request.faces = faces;
+    request.cooked = cooked;
+    for (unsigned int i = 0; i < 6; i++)
+        request.decodeSeconds[i] = 0.0;
+    request.uploaded = false;
+    return request;
+}
+// function to queue the graph of a request: its decode tasks, then one that hands it to drain().
+// they are all background tasks, a frame's parallel work never waits behind a decode, and
+// so are the tasks they queue (the faces of a cubemap being cooked)
+void TextureLoader::start(Request& request)
+{
+    TaskId done = request.graph.add([this, &request]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(&request);
+    }, TASK_BACKGROUND);
+    for (TaskId i = 0; i < request.graph.size() - 1; i++)
+        request.graph.depend(done, i);
+    jobs.start(request.graph);
+}
+
+GLuint TextureLoader::load(const std::string& path)
+{
+    Request& request = add(1, false);
+    request.graph.add([&request, path]() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        DecodeImage(path, request.images[0]);
+        request.decodeSeconds[0] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }, TASK_BACKGROUND);
+    start(request);
+    return request.texture;
+}
+
+GLuint TextureLoader::loadCubemap(const std::string* faces)
+{
+    Request& request = add(6, false);
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        std::string path = faces[i];
+        request.graph.add([&request, path, i]() {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            DecodeImage(path, request.images[i]);
+            request.decodeSeconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }, TASK_BACKGROUND);
+    }
+    start(request);
+    return request.texture;
+}
+
+GLuint TextureLoader::loadCooked(const std::vector<std::string>& sources, bool allowCompressed)
+{
+    Request& request = add((unsigned int)sources.size(), true);
+    request.graph.add([&request, sources, allowCompressed]() {
+        PrepareCookedTexture(sources, allowCompressed, request.cookedTexture);
+        request.decodeSeconds[0] = request.cookedTexture.seconds;
+    }, TASK_BACKGROUND);
+    start(request);
+    return request.texture;
+}
+
+void TextureLoader::upload(Request& request)
+{
+    if (unpackBuffer == 0)
+        glGenBuffers(1, &unpackBuffer);
+    if (request.cooked)
+    {
+        if (request.cookedTexture.recooked)
+            std::cout << "Cooked " << request.cookedTexture.path << std::endl;
+        FillCookedTexture(request.texture, request.cookedTexture, unpackBuffer);
+        FreeCookedTexture(request.cookedTexture);
+    }
+    else if (request.faces == 6)
+        FillCubemap(request.texture, request.images, unpackBuffer);
+    else
+        FillTexture(request.texture, request.images[0], unpackBuffer);
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        FreeImage(request.images[i]);
+        decodeSeconds += request.decodeSeconds[i];
+    }
+    request.uploaded = true;
+    loaded++;
+    pending--;
+}
+
+unsigned int TextureLoader::drain()
+{
+    std::vector<Request*> decoded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.swap(ready);
+    }
+    for (std::size_t i = 0; i < decoded.size(); i++)
+        upload(*decoded[i]);
+    // a request's graph is done with it once its last task has returned
+    for (std::list<Request>::iterator it = requests.begin(); it != requests.end();)
+    {
+        if (it->uploaded && jobs.finished(it->graph))
+            it = requests.erase(it);
+        else
+            ++it;
+    }
+    if (pending == 0 && loaded > 0)
+        report();
+    return (unsigned int)decoded.size();
+}
+
+void TextureLoader::finish()
+{
+    for (std::list<Request>::iterator it = requests.begin(); it != requests.end(); ++it)
+        jobs.wait(it->graph);
+    drain();
+}
+
+unsigned int TextureLoader::getPendingCount() const
+{
+    return pending;
+}
+
+void TextureLoader::setReporting(bool enabled)
+{
+    reporting = enabled;
+}
+
+void TextureLoader::shutdown()
+{
+    finish();
+    if (unpackBuffer != 0)
+        glDeleteBuffers(1, &unpackBuffer);
+    unpackBuffer = 0;
+}
+
+void TextureLoader::report()
+{
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - firstRequest).count();
+    if (reporting)
+    {
+        std::cout << "Loaded " << loaded << " textures in " << wall * 1000.0 << " ms, decoding took "
+                  << decodeSeconds * 1000.0 << " ms on " << jobs.getWorkerCount() + 1 << " threads" << std::endl;
+    }
+    loaded = 0;
+    decodeSeconds = 0.0;
+}
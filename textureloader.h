@@ -0,0 +1,108 @@
+#pragma once
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "jobs.h"
+#include "texturecache.h"
+
+// an image file decoded by stb_image, ready to be uploaded on the GL thread
+struct DecodedImage
+{
+    std::string path;
+    int width;
+    int height;
+    int channels;
+    unsigned char* pixels;      // NULL when the file could not be read
+
+    DecodedImage() : width(0), height(0), channels(0), pixels(NULL) {}
+};
+
+// loading a texture is split in two: decoding reads and decompresses the file and
+// runs on any thread, uploading creates the GL texture and runs on the GL thread
+
+// function to decode an image file, any thread. with channels set every image comes out
+// with that many channels (grey is spread over rgb), otherwise with the file's own
+bool DecodeImage(const std::string& path, DecodedImage& image, int channels = 0);
+void FreeImage(DecodedImage& image);
+// function to get the GL pixel format of 1, 3 or 4 channels
+GLenum ImageFormat(int channels);
+// function to create a repeating, mipmapped 2D texture from an image, 0 if it did not decode
+GLuint UploadTexture(const DecodedImage& image);
+// function to create a cubemap from six images (right, left, top, bottom, front, back)
+GLuint UploadCubemap(const DecodedImage* faces);
+// functions to fill a texture name like the two above, copying the pixels through
+// unpackBuffer when it is not 0
+void FillTexture(GLuint texture, const DecodedImage& image, GLuint unpackBuffer);
+void FillCubemap(GLuint texture, const DecodedImage* faces, GLuint unpackBuffer);
+// function to copy size bytes into unpackBuffer and leave it bound to GL_PIXEL_UNPACK_BUFFER,
+// returns the pointer the glTexImage2D calls take for data: its offset in the buffer, or data
+// itself when there is no buffer or it did not map (nothing is bound then). GL thread
+const unsigned char* StageUpload(GLuint unpackBuffer, const unsigned char* data, std::size_t size);
+void EndUpload();
+
+// loads textures without holding up the GL thread: load() hands out the texture name at once
+// and queues the decoding on the job system, every image and every cubemap face a task of
+// its own. drain() fills the textures whose images are ready, through a pixel unpack buffer,
+// and the name is complete from then on. once nothing is pending it prints the wall time of
+// the loads next to the decode time they added up to
+class TextureLoader
+{
+public:
+    TextureLoader();
+
+    // functions to queue an image file, the six faces of a cubemap (right, left, top, bottom,
+    // front, back) or a cooked texture of texturecache.h, returning the texture they go into. GL thread
+    GLuint load(const std::string& path);
+    GLuint loadCubemap(const std::string* faces);
+    GLuint loadCooked(const std::vector<std::string>& sources, bool allowCompressed);
+    // function to fill the textures whose images are ready, returns how many. GL thread
+    unsigned int drain();
+    // function to decode what is left, on this thread too, and fill every queued texture. GL thread
+    void finish();
+    unsigned int getPendingCount() const;
+    // function to turn the wall / decode time line off or on (the default)
+    void setReporting(bool enabled);
+    // function to delete the unpack buffer, GL thread while the context is current
+    void shutdown();
+
+private:
+    struct Request
+    {
+        GLuint texture;
+        unsigned int faces;                 // 1, or 6 for a cubemap
+        bool cooked;
+        DecodedImage images[6];
+        CookedTexture cookedTexture;
+        double decodeSeconds[6];            // per task, each writes its own
+        bool uploaded;
+        TaskGraph graph;
+    };
+
+    Request& add(unsigned int faces, bool cooked);
+    void start(Request& request);
+    void upload(Request& request);
+    void report();
+
+    std::list<Request> requests;            // a list, the tasks keep pointers into it
+    std::mutex mutex;
+    std::vector<Request*> ready;            // decoded, filled by the tasks
+    GLuint unpackBuffer;
+    unsigned int pending;
+    unsigned int loaded;
+    double decodeSeconds;
+    bool reporting;
+    std::chrono::steady_clock::time_point firstRequest;
+
+    TextureLoader(const TextureLoader&);
+    TextureLoader& operator=(const TextureLoader&);
+};
+
+extern TextureLoader textureLoader;
+
+#endif
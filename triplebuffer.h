@@ -0,0 +1,61 @@
+#pragma once
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// hands values from one writer thread to one reader thread without locks or waiting.
+// the writer fills getWriteBuffer() and publishes it, the reader takes the newest
+// published value with acquire() and reads it from getReadBuffer(). neither side
+// ever touches the buffer the other one owns; values published while the reader
+// was busy are skipped, the reader always gets the latest
+template <class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back(0), middle(1), front(2)
+    {
+    }
+
+    // writer side
+    T& getWriteBuffer()
+    {
+        return buffers[back];
+    }
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side. hasFresh and acquire are only called by the reader, so a fresh value
+    // seen by hasFresh is still there for acquire
+    bool hasFresh() const
+    {
+        return (middle.load(std::memory_order_acquire) & FRESH) != 0;
+    }
+    bool acquire()
+    {
+        if (!hasFresh())
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    T& getReadBuffer()
+    {
+        return buffers[front];
+    }
+
+private:
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+
+    static const unsigned int INDEX = 3;
+    static const unsigned int FRESH = 4;
+
+    T buffers[3];
+    unsigned int back;                      // owned by the writer
+    std::atomic<unsigned int> middle;       // the last published buffer, FRESH until the reader took it
+    unsigned int front;                     // owned by the reader
+};
+
+#endif